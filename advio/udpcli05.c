@@ -0,0 +1,71 @@
+/*
+ * Load for the UDP echo servers: keep "window" datagrams outstanding to
+ * SERV_PORT at <IPaddress> for "nsec" seconds and report the echoes per
+ * second, to compare udpserv05 with udpserv03.  Run several at once to
+ * load a server with -n.  A datagram with no echo after 100 ms counts
+ * as lost and another takes its place.
+ */
+
+#include	"unp.h"
+
+#define	DGLEN	64			/* bytes per datagram */
+
+int
+main(int argc, char **argv)
+{
+	int				sockfd, nsec, window, i, n, nout;
+	long			nrecv, nlost;
+	char			buf[DGLEN];
+	struct timeval	start, now;
+	struct pollfd	fds[1];
+	struct addrinfo	hints, *res;
+
+	if (argc < 2 || argc > 4)
+		err_quit("usage: udpcli05 <IPaddress> [ #seconds [ window ] ]");
+	nsec = (argc > 2) ? atoi(argv[2]) : 5;
+	window = (argc > 3) ? atoi(argv[3]) : 32;
+
+	bzero(&hints, sizeof(hints));
+	hints.ai_flags = AI_NUMERICHOST;
+	hints.ai_socktype = SOCK_DGRAM;
+	if ( (n = getaddrinfo(argv[1], SERV_PORT_STR, &hints, &res)) != 0)
+		err_quit("udpcli05 error for %s: %s", argv[1], gai_strerror(n));
+	sockfd = Socket(res->ai_family, SOCK_DGRAM, 0);
+	Connect(sockfd, res->ai_addr, res->ai_addrlen);	/* ICMP errors, too */
+	freeaddrinfo(res);
+
+	memset(buf, 'x', sizeof(buf));
+	fds[0].fd = sockfd;
+	fds[0].events = POLLIN;
+	nrecv = nlost = 0;
+	Gettimeofday(&start, NULL);
+
+	for (nout = 0; ; ) {
+		for ( ; nout < window; nout++)
+			Write(sockfd, buf, sizeof(buf));
+
+		if (Poll(fds, 1, 100) == 0) {
+			nlost += nout;		/* all outstanding */
+			nout = 0;
+		} else {
+			for (i = 0; i < nout; i++) {	/* every echo that is waiting */
+				if ( (n = recv(sockfd, buf, sizeof(buf), MSG_DONTWAIT)) < 0) {
+					if (errno == EAGAIN || errno == EWOULDBLOCK)
+						break;
+					err_sys("recv error");
+				}
+				nrecv++;
+			}
+			nout -= i;
+		}
+
+		Gettimeofday(&now, NULL);
+		tv_sub(&now, &start);
+		if (now.tv_sec >= nsec)
+			break;
+	}
+
+	printf("%ld echoes in %d sec = %.0f/s, %ld lost (window %d)\n",
+		   nrecv, nsec, (double) nrecv / nsec, nlost, window);
+	exit(0);
+}
@@ -0,0 +1,298 @@
+/*
+ * A UDP echo server for a multihomed host that needs neither a socket
+ * nor a process per address, unlike udpserv03.c.  Each process binds
+ * one IPv4 and one IPv6 wildcard socket.  IP_PKTINFO and IPV6_RECVPKTINFO
+ * tell it which local address each datagram was sent to, and the same
+ * ancillary data given to sendmsg() makes the reply come from that
+ * address.  Datagrams are read and answered up to BATCH at a time with
+ * recvmmsg() and sendmmsg().
+ *
+ * With -n, that many processes (0 = one per CPU) each bind their own
+ * pair of sockets with SO_REUSEPORT and the kernel spreads the clients
+ * across them.  -v prints every datagram, as udpserv03 does.
+ */
+
+#define	_GNU_SOURCE			/* recvmmsg(), sendmmsg(), struct in6_pktinfo */
+#include	"unp.h"
+
+#define	BATCH	64			/* datagrams per system call */
+
+#ifndef	MSG_WAITFORONE		/* no recvmmsg() or sendmmsg(): one at a time */
+struct mmsghdr {
+  struct msghdr	msg_hdr;
+  unsigned int	msg_len;
+};
+
+static int
+recvmmsg(int fd, struct mmsghdr *msgs, unsigned int n, int flags, void *timeo)
+{
+	ssize_t		len;
+
+	if ( (len = recvmsg(fd, &msgs[0].msg_hdr, flags)) < 0)
+		return(-1);
+	msgs[0].msg_len = len;
+	return(1);
+}
+
+static int
+sendmmsg(int fd, struct mmsghdr *msgs, unsigned int n, int flags)
+{
+	unsigned int	i;
+
+	for (i = 0; i < n; i++)
+		if (sendmsg(fd, &msgs[i].msg_hdr, flags) < 0)
+			return(i > 0 ? i : -1);
+	return(n);
+}
+#endif
+
+static struct dgram {
+  char						d_buf[MAXLINE];
+  struct sockaddr_storage	d_from;
+  struct iovec				d_iov;
+  union {
+	struct cmsghdr	cm;
+	char			control[CMSG_SPACE(sizeof(struct in6_pktinfo)) +
+							CMSG_SPACE(sizeof(struct in_pktinfo))];
+  } d_control;
+} dg[BATCH];
+
+static struct mmsghdr	msgs[BATCH];
+static int				verbose;
+
+void	dg_echo_batch(int);
+int		dg_socket(int, int);
+void	dg_serve(int);
+
+int
+main(int argc, char **argv)
+{
+	int		c, i, nproc;
+
+	nproc = 1;
+	opterr = 0;		/* don't want getopt() writing to stderr */
+	while ( (c = getopt(argc, argv, "n:v")) != -1) {
+		switch (c) {
+		case 'n':
+			nproc = atoi(optarg);
+			break;
+
+		case 'v':
+			verbose = 1;
+			break;
+
+		case '?':
+			err_quit("usage: udpserv05 [ -n #processes ] [ -v ]");
+		}
+	}
+#ifndef	IP_PKTINFO
+	err_quit("IP_PKTINFO not supported by this system; use udpserv03");
+#endif
+	if (nproc == 0)
+		nproc = sysconf(_SC_NPROCESSORS_ONLN);
+	if (nproc <= 1)
+		dg_serve(0);		/* never returns */
+
+#ifndef	SO_REUSEPORT
+	err_quit("SO_REUSEPORT not supported by this system; use -n 1");
+#endif
+	for (i = 0; i < nproc; i++) {
+		if (Fork() == 0)
+			dg_serve(1);	/* never returns */
+	}
+	while (wait(NULL) > 0)
+		;
+	err_sys("wait error");
+}
+
+/*
+ * Bind a wildcard socket for SERV_PORT that reports the destination
+ * address of every datagram.  Return -1 if the system has no IPv6.
+ */
+int
+dg_socket(int family, int reuseport)
+{
+	int					sockfd;
+	const int			on = 1;
+	struct sockaddr_in	sin;
+#ifdef	IPV6
+	struct sockaddr_in6	sin6;
+#endif
+
+	if ( (sockfd = socket(family, SOCK_DGRAM, 0)) < 0) {
+		if (family != AF_INET && errno == EAFNOSUPPORT)
+			return(-1);
+		err_sys("socket error");
+	}
+	Setsockopt(sockfd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+#ifdef	SO_REUSEPORT
+	if (reuseport)
+		Setsockopt(sockfd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+#endif
+
+	if (family == AF_INET) {
+#ifdef	IP_PKTINFO
+		Setsockopt(sockfd, IPPROTO_IP, IP_PKTINFO, &on, sizeof(on));
+#endif
+		bzero(&sin, sizeof(sin));
+		sin.sin_family = AF_INET;
+		sin.sin_addr.s_addr = htonl(INADDR_ANY);
+		sin.sin_port = htons(SERV_PORT);
+		Bind(sockfd, (SA *) &sin, sizeof(sin));
+#ifdef	IPV6
+	} else {
+			/* IPv4 datagrams go to the other socket, not here as mapped */
+		Setsockopt(sockfd, IPPROTO_IPV6, IPV6_V6ONLY, &on, sizeof(on));
+		Setsockopt(sockfd, IPPROTO_IPV6, IPV6_RECVPKTINFO, &on, sizeof(on));
+		bzero(&sin6, sizeof(sin6));
+		sin6.sin6_family = AF_INET6;
+		sin6.sin6_addr = in6addr_any;
+		sin6.sin6_port = htons(SERV_PORT);
+		Bind(sockfd, (SA *) &sin6, sizeof(sin6));
+#endif
+	}
+	return(sockfd);
+}
+
+void
+dg_serve(int reuseport)
+{
+	int				i, nfds;
+	struct pollfd	fds[2];
+
+	fds[0].fd = dg_socket(AF_INET, reuseport);
+	nfds = 1;
+#ifdef	IPV6
+	if ( (fds[1].fd = dg_socket(AF_INET6, reuseport)) >= 0)
+		nfds = 2;
+#endif
+	printf("pid %d bound %s port %d\n", getpid(),
+		   (nfds == 2) ? "IPv4 and IPv6 wildcard" : "IPv4 wildcard",
+		   SERV_PORT);
+
+	for ( ; ; ) {
+		for (i = 0; i < nfds; i++)
+			fds[i].events = POLLIN;
+		if (poll(fds, nfds, INFTIM) < 0) {
+			if (errno == EINTR)
+				continue;
+			err_sys("poll error");
+		}
+		for (i = 0; i < nfds; i++)
+			if (fds[i].revents & (POLLIN | POLLERR))
+				dg_echo_batch(fds[i].fd);
+	}
+}
+
+/*
+ * Replace the destination address that recvmsg() reported in the
+ * ancillary data with the source address for the reply.  For IPv4 the
+ * kernel already fills in ipi_spec_dst with the right one: the
+ * destination itself, or the interface's address if the datagram was
+ * broadcast.  For IPv6, a multicast destination can't be the source,
+ * so we leave it to the kernel.  Return the local address, for -v.
+ */
+static const char *
+set_reply_src(struct msghdr *msg, char *str, size_t len)
+{
+	struct cmsghdr		*cmptr;
+
+	snprintf(str, len, "?");
+	for (cmptr = CMSG_FIRSTHDR(msg); cmptr != NULL;
+		 cmptr = CMSG_NXTHDR(msg, cmptr)) {
+#ifdef	IP_PKTINFO
+		if (cmptr->cmsg_level == IPPROTO_IP &&
+			cmptr->cmsg_type == IP_PKTINFO) {
+			struct in_pktinfo	pi;
+
+			memcpy(&pi, CMSG_DATA(cmptr), sizeof(pi));
+			inet_ntop(AF_INET, &pi.ipi_addr, str, len);
+			pi.ipi_ifindex = 0;			/* let routing pick the interface */
+			msg->msg_controllen = CMSG_SPACE(sizeof(pi));
+			cmptr = CMSG_FIRSTHDR(msg);	/* the only cmsg on the reply */
+			cmptr->cmsg_level = IPPROTO_IP;
+			cmptr->cmsg_type = IP_PKTINFO;
+			cmptr->cmsg_len = CMSG_LEN(sizeof(pi));
+			memcpy(CMSG_DATA(cmptr), &pi, sizeof(pi));
+			return(str);
+		}
+#endif
+#ifdef	IPV6
+		if (cmptr->cmsg_level == IPPROTO_IPV6 &&
+			cmptr->cmsg_type == IPV6_PKTINFO) {
+			struct in6_pktinfo	pi6;
+
+			memcpy(&pi6, CMSG_DATA(cmptr), sizeof(pi6));
+			inet_ntop(AF_INET6, &pi6.ipi6_addr, str, len);
+			if (IN6_IS_ADDR_MULTICAST(&pi6.ipi6_addr))
+				pi6.ipi6_addr = in6addr_any;
+				/* keep the interface, for a link-local source */
+			msg->msg_controllen = CMSG_SPACE(sizeof(pi6));
+			cmptr = CMSG_FIRSTHDR(msg);
+			cmptr->cmsg_level = IPPROTO_IPV6;
+			cmptr->cmsg_type = IPV6_PKTINFO;
+			cmptr->cmsg_len = CMSG_LEN(sizeof(pi6));
+			memcpy(CMSG_DATA(cmptr), &pi6, sizeof(pi6));
+			return(str);
+		}
+#endif
+	}
+	msg->msg_control = NULL;		/* no pktinfo; reply from any address */
+	msg->msg_controllen = 0;
+	return(str);
+}
+
+/* include dg_echo_batch */
+void
+dg_echo_batch(int sockfd)
+{
+	int				i, n, nsent;
+	struct msghdr	*msg;
+	char			str[INET6_ADDRSTRLEN];
+	const char		*to;
+
+	for (i = 0; i < BATCH; i++) {
+		dg[i].d_iov.iov_base = dg[i].d_buf;
+		dg[i].d_iov.iov_len = MAXLINE;
+		msg = &msgs[i].msg_hdr;
+		msg->msg_name = &dg[i].d_from;
+		msg->msg_namelen = sizeof(dg[i].d_from);
+		msg->msg_iov = &dg[i].d_iov;
+		msg->msg_iovlen = 1;
+		msg->msg_control = dg[i].d_control.control;
+		msg->msg_controllen = sizeof(dg[i].d_control.control);
+		msg->msg_flags = 0;
+	}
+
+		/* poll() said there is at least one; take all that are queued */
+	if ( (n = recvmmsg(sockfd, msgs, BATCH, MSG_DONTWAIT, NULL)) < 0) {
+		if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+			return;
+		err_ret("recvmmsg error");	/* e.g. an ICMP error; keep going */
+		return;
+	}
+
+	for (i = 0; i < n; i++) {
+		msg = &msgs[i].msg_hdr;
+		dg[i].d_iov.iov_len = msgs[i].msg_len;	/* echo what arrived */
+		to = set_reply_src(msg, str, sizeof(str));
+		if (verbose) {
+			printf("pid %d, datagram from %s", getpid(),
+				   Sock_ntop(msg->msg_name, msg->msg_namelen));
+			printf(", to %s\n", to);
+		}
+	}
+
+	for (nsent = 0; nsent < n; ) {
+		if ( (i = sendmmsg(sockfd, msgs + nsent, n - nsent, 0)) < 0) {
+			if (errno == EINTR)
+				continue;
+			err_ret("sendmmsg error to %s",
+					Sock_ntop(msgs[nsent].msg_hdr.msg_name,
+							  msgs[nsent].msg_hdr.msg_namelen));
+			i = 1;			/* skip the one that failed */
+		}
+		nsent += i;
+	}
+}
+/* end dg_echo_batch */
@@ -0,0 +1,91 @@
+/*
+ * Stand in for many responders on one host, to try udpcli07 against.
+ * Every request on the port gets one daytime-like reply from each of
+ * -n different source addresses, 127.0.0.1 upward: all of 127/8 is
+ * local on Linux, and IP_PKTINFO lets one socket send from any local
+ * address, so the replies look as though they came from that many
+ * hosts.  They go out BATCH at a time with sendmmsg(), so they arrive
+ * in the kind of burst a subnet's worth of real responders produces.
+ *
+ *		bcastresp -n 5000 9913 &
+ *		udpcli07 -q 127.0.0.1 9913
+ */
+
+#ifndef	_GNU_SOURCE
+#define	_GNU_SOURCE			/* sendmmsg() */
+#endif
+#include	"unp.h"
+
+#define	BATCH	256
+
+int
+main(int argc, char **argv)
+{
+	int					c, i, j, k, n, sockfd, nresp;
+	char				reqbuf[MAXLINE], timestr[64];
+	char				(*buf)[64];
+	time_t				ticks;
+	socklen_t			len;
+	struct sockaddr_in	servaddr, cliaddr;
+	struct in_pktinfo	*pi;
+	struct iovec		iov[BATCH];
+	struct mmsghdr		msgs[BATCH];
+	union {
+	  struct cmsghdr	cm;
+	  char				space[CMSG_SPACE(sizeof(struct in_pktinfo))];
+	} control[BATCH];
+
+	nresp = 1000;
+	opterr = 0;
+	while ( (c = getopt(argc, argv, "n:")) != -1) {
+		if (c == 'n')
+			nresp = atoi(optarg);
+		else
+			err_quit("unrecognized option: %c", optopt);
+	}
+	if (optind < argc - 1 || nresp < 1 || nresp > 65536)
+		err_quit("usage: bcastresp [ -n #responders ] [ port ]");
+
+	sockfd = Socket(AF_INET, SOCK_DGRAM, 0);
+	bzero(&servaddr, sizeof(servaddr));
+	servaddr.sin_family = AF_INET;
+	servaddr.sin_addr.s_addr = htonl(INADDR_ANY);
+	servaddr.sin_port = htons(optind < argc ? atoi(argv[optind]) : 13);
+	Bind(sockfd, (SA *) &servaddr, sizeof(servaddr));
+	buf = Malloc(BATCH * sizeof(*buf));
+
+	for ( ; ; ) {
+		len = sizeof(cliaddr);
+		Recvfrom(sockfd, reqbuf, sizeof(reqbuf), 0, (SA *) &cliaddr, &len);
+		ticks = time(NULL);
+		snprintf(timestr, sizeof(timestr), "%.24s", ctime(&ticks));
+
+		for (i = 0; i < nresp; i += n) {
+			n = min(BATCH, nresp - i);
+			for (j = 0; j < n; j++) {
+				k = i + j + 1;				/* this is 127.0.x.y, x.y = k */
+				iov[j].iov_base = buf[j];
+				iov[j].iov_len = snprintf(buf[j], sizeof(buf[j]),
+										  "responder %d: %s\r\n", k, timestr);
+				bzero(&msgs[j], sizeof(msgs[j]));
+				msgs[j].msg_hdr.msg_name = &cliaddr;
+				msgs[j].msg_hdr.msg_namelen = len;
+				msgs[j].msg_hdr.msg_iov = &iov[j];
+				msgs[j].msg_hdr.msg_iovlen = 1;
+				msgs[j].msg_hdr.msg_control = &control[j];
+				msgs[j].msg_hdr.msg_controllen = sizeof(control[j]);
+
+				control[j].cm.cmsg_level = IPPROTO_IP;
+				control[j].cm.cmsg_type = IP_PKTINFO;
+				control[j].cm.cmsg_len = CMSG_LEN(sizeof(struct in_pktinfo));
+				pi = (struct in_pktinfo *) CMSG_DATA(&control[j].cm);
+				bzero(pi, sizeof(*pi));
+				pi->ipi_spec_dst.s_addr = htonl(0x7f000000 | k);
+			}
+			for (j = 0; j < n; j += k) {
+				if ( (k = sendmmsg(sockfd, msgs + j, n - j, 0)) < 0)
+					err_sys("sendmmsg error");
+			}
+		}
+	}
+}
@@ -0,0 +1,279 @@
+/*
+ * The broadcast client of dgclibcast1.c reads one reply per recvfrom()
+ * and prints each as it comes, until an alarm after five seconds.  With
+ * thousands of responders the replies arrive in a burst that overflows
+ * the socket buffer while it is still printing.  Here the replies are
+ * read up to BATCH at a time with recvmmsg() into small buffers, the
+ * socket buffer is made large enough to hold the burst, and each reply
+ * costs a hash lookup on the responder's address and port: a responder
+ * already seen only has its count incremented.  The caller gets the
+ * responders back in a disc_result{} and prints them, or not, as it likes.
+ *
+ * The request is resent, since a broadcast can be lost as easily as any
+ * other datagram, but sparingly: the interval doubles each time, at most
+ * dp_maxsend copies are sent, and none at all once a copy has found
+ * fewer than dp_minnew new responders, which means everyone is in.
+ * A copy that found nobody at all does not count: it or all the replies
+ * to it may have been lost, so the resends go on until one is heard.
+ * Every responder answers every copy, so each needless resend costs a
+ * whole burst of duplicates.  The collection ends dp_timeout ms after
+ * the last copy was sent.
+ *
+ * Where the kernel provides SO_RXQ_OVFL, the number of replies it had to
+ * drop for lack of buffer space is returned in dr_ndrop.
+ */
+
+#include	"discover.h"
+#include	<poll.h>
+
+#define	BATCH		256			/* replies per recvmmsg() */
+#define	RCVBUF		(8 * 1024 * 1024)	/* bytes: a few thousand replies */
+
+static double
+now(void)						/* ms */
+{
+	struct timespec	ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return(ts.tv_sec * 1e3 + ts.tv_nsec / 1e6);
+}
+
+void
+disc_default(struct disc_param *dp)
+{
+	dp->dp_timeout = 2000;
+	dp->dp_retrans = 250;
+	dp->dp_maxsend = 4;
+	dp->dp_minnew = 1;
+}
+
+void
+disc_free(struct disc_result *dr)
+{
+	free(dr->dr_reply);
+	dr->dr_reply = NULL;
+	dr->dr_n = 0;
+}
+
+static uint32_t
+fnv(uint32_t h, const void *ptr, int len)
+{
+	const u_char	*p = ptr;
+
+	while (len-- > 0) {
+		h ^= *p++;
+		h *= 16777619U;
+	}
+	return(h);
+}
+
+/* The responder's address and port, hashed. */
+static uint32_t
+disc_hash(const struct sockaddr *sa, socklen_t salen)
+{
+	const struct sockaddr_in	*sin;
+	const struct sockaddr_in6	*sin6;
+
+	if (sa->sa_family == AF_INET6) {
+		sin6 = (const struct sockaddr_in6 *) sa;
+		return(fnv(fnv(2166136261U, &sin6->sin6_port, 2),
+				   &sin6->sin6_addr, 16));
+	}
+	sin = (const struct sockaddr_in *) sa;
+	return(fnv(fnv(2166136261U, &sin->sin_port, 2), &sin->sin_addr, 4));
+}
+
+struct dedup {					/* open addressing, on dr_reply[] indexes */
+  int		*d_slot;			/* -1 if empty */
+  uint32_t	 d_mask;
+  int		 d_max;				/* entries in dr_reply[] */
+};
+
+/*
+ * Return the index in dr_reply[] of the responder that sent this, adding
+ * it if new (*isnew is then 1), or -1 if out of memory.
+ */
+static int
+disc_lookup(struct disc_result *dr, struct dedup *d, const struct sockaddr *sa,
+			socklen_t salen, int *isnew)
+{
+	int					i, *slot;
+	uint32_t			h, j;
+	struct disc_reply	*r;
+
+	h = disc_hash(sa, salen);
+	for (j = h & d->d_mask; (i = d->d_slot[j]) >= 0;
+		 j = (j + 1) & d->d_mask) {
+		r = &dr->dr_reply[i];
+		if (sock_cmp_addr((SA *) &r->dr_addr, sa, salen) == 0 &&
+			sock_cmp_port((SA *) &r->dr_addr, sa, salen) == 1) {
+			*isnew = 0;
+			return(i);
+		}
+	}
+
+	if (dr->dr_n == d->d_max) {
+		i = d->d_max ? 2 * d->d_max : 256;
+		if ( (r = realloc(dr->dr_reply, i * sizeof(*r))) == NULL)
+			return(-1);
+		dr->dr_reply = r;
+		d->d_max = i;
+	}
+	if (2 * (dr->dr_n + 1) > d->d_mask + 1) {	/* keep it half empty */
+		if ( (slot = malloc(2 * (d->d_mask + 1) * sizeof(int))) == NULL)
+			return(-1);
+		free(d->d_slot);
+		d->d_slot = slot;
+		d->d_mask = 2 * d->d_mask + 1;
+		memset(slot, -1, (d->d_mask + 1) * sizeof(int));
+		for (i = 0; i < dr->dr_n; i++) {	/* rehash */
+			r = &dr->dr_reply[i];
+			j = disc_hash((SA *) &r->dr_addr, r->dr_addrlen) & d->d_mask;
+			while (slot[j] >= 0)
+				j = (j + 1) & d->d_mask;
+			slot[j] = i;
+		}
+		j = h & d->d_mask;
+		while (slot[j] >= 0)
+			j = (j + 1) & d->d_mask;
+	}
+	d->d_slot[j] = i = dr->dr_n++;
+	r = &dr->dr_reply[i];
+	bzero(r, sizeof(*r));
+	memcpy(&r->dr_addr, sa, salen);
+	r->dr_addrlen = salen;
+	*isnew = 1;
+	return(i);
+}
+
+/* include dg_discover */
+int
+dg_discover(int sockfd, const void *req, size_t reqlen, const SA *to,
+			socklen_t tolen, const struct disc_param *dp,
+			struct disc_result *dr)
+{
+	int					i, n, idx, isnew, nnew, nsend, interval, on;
+	double				start, t, nextsend, deadline;
+	struct dedup		d;
+	struct disc_reply	*r;
+	struct pollfd		pfd;
+	struct cmsghdr		*cmsg;
+	char				buf[BATCH][DISC_DATALEN];
+	struct sockaddr_storage	from[BATCH];
+	struct iovec		iov[BATCH];
+	struct mmsghdr		msgs[BATCH];
+#ifdef	SO_RXQ_OVFL
+	union {
+	  struct cmsghdr	cm;
+	  char				space[CMSG_SPACE(sizeof(uint32_t))];
+	} control[BATCH];
+#endif
+
+	bzero(dr, sizeof(*dr));
+	d.d_mask = 1023;
+	d.d_max = 0;
+	if ( (d.d_slot = malloc((d.d_mask + 1) * sizeof(int))) == NULL)
+		return(-1);
+	memset(d.d_slot, -1, (d.d_mask + 1) * sizeof(int));
+
+	on = 1;
+	setsockopt(sockfd, SOL_SOCKET, SO_BROADCAST, &on, sizeof(on));
+	n = RCVBUF;					/* the kernel caps it at rmem_max */
+	setsockopt(sockfd, SOL_SOCKET, SO_RCVBUF, &n, sizeof(n));
+#ifdef	SO_RXQ_OVFL
+	setsockopt(sockfd, SOL_SOCKET, SO_RXQ_OVFL, &on, sizeof(on));
+#endif
+
+	start = now();
+	nsend = 0;
+	nnew = dp->dp_minnew;		/* so the first one goes */
+	interval = dp->dp_retrans;
+	nextsend = deadline = start;
+	pfd.fd = sockfd;
+	pfd.events = POLLIN;
+
+	for ( ; ; ) {
+		t = now();
+		if (nsend < dp->dp_maxsend && t >= nextsend) {
+			if (nnew < dp->dp_minnew && dr->dr_n > 0)
+				nsend = dp->dp_maxsend;		/* found everyone: no more */
+			else {
+				if (sendto(sockfd, req, reqlen, 0, to, tolen) < 0)
+					goto bad;
+				dr->dr_nsent++;
+				if (nsend++ > 0)
+					interval *= 2;
+				nextsend = t + interval;
+				deadline = t + dp->dp_timeout;
+				nnew = 0;
+			}
+		}
+		if (t >= deadline)
+			break;
+
+		n = (nsend < dp->dp_maxsend) ? min(nextsend, deadline) - t :
+									   deadline - t;
+		if ( (n = poll(&pfd, 1, n + 1)) < 0) {
+			if (errno == EINTR)
+				continue;
+			goto bad;
+		}
+		if (n == 0)
+			continue;
+
+			/* 4read everything that is queued, BATCH at a time */
+		do {
+			for (i = 0; i < BATCH; i++) {
+				iov[i].iov_base = buf[i];
+				iov[i].iov_len = DISC_DATALEN;
+				bzero(&msgs[i].msg_hdr, sizeof(msgs[i].msg_hdr));
+				msgs[i].msg_hdr.msg_name = &from[i];
+				msgs[i].msg_hdr.msg_namelen = sizeof(from[i]);
+				msgs[i].msg_hdr.msg_iov = &iov[i];
+				msgs[i].msg_hdr.msg_iovlen = 1;
+#ifdef	SO_RXQ_OVFL
+				msgs[i].msg_hdr.msg_control = &control[i];
+				msgs[i].msg_hdr.msg_controllen = sizeof(control[i]);
+#endif
+			}
+			if ( (n = recvmmsg(sockfd, msgs, BATCH, MSG_DONTWAIT, NULL)) < 0) {
+				if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+					break;			/* back to poll() */
+				goto bad;
+			}
+
+			t = now();
+			for (i = 0; i < n; i++) {
+				dr->dr_nrecv++;
+				idx = disc_lookup(dr, &d, (SA *) &from[i],
+								  msgs[i].msg_hdr.msg_namelen, &isnew);
+				if (idx < 0)
+					goto bad;
+				r = &dr->dr_reply[idx];
+				r->dr_nreply++;
+				if (isnew) {
+					nnew++;
+					r->dr_rtt = t - start;
+					r->dr_datalen = min(msgs[i].msg_len, DISC_DATALEN);
+					memcpy(r->dr_data, buf[i], r->dr_datalen);
+				} else
+					dr->dr_ndup++;
+#ifdef	SO_RXQ_OVFL
+				for (cmsg = CMSG_FIRSTHDR(&msgs[i].msg_hdr); cmsg != NULL;
+					 cmsg = CMSG_NXTHDR(&msgs[i].msg_hdr, cmsg))
+					if (cmsg->cmsg_level == SOL_SOCKET &&
+						cmsg->cmsg_type == SO_RXQ_OVFL)
+						dr->dr_ndrop = *(uint32_t *) CMSG_DATA(cmsg);
+#endif
+			}
+		} while (n == BATCH);
+	}
+	free(d.d_slot);
+	return(dr->dr_n);
+
+bad:
+	free(d.d_slot);
+	disc_free(dr);
+	return(-1);
+}
+/* end dg_discover */
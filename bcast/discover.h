@@ -0,0 +1,42 @@
+/*
+ * Discovery by broadcast or multicast: send a request, collect one reply
+ * per responder.  See dg_discover.c.  Include this before anything else
+ * that includes "unp.h".
+ */
+
+#ifndef	_GNU_SOURCE
+#define	_GNU_SOURCE			/* recvmmsg() */
+#endif
+#include	"unp.h"
+
+#define	DISC_DATALEN	128		/* bytes kept of each responder's reply */
+
+struct disc_param {
+  int		dp_timeout;			/* ms to wait after the last request */
+  int		dp_retrans;			/* ms before the first resend, then doubled */
+  int		dp_maxsend;			/* most times the request is sent */
+  int		dp_minnew;			/* resend only if the last one found this many */
+};
+
+struct disc_reply {				/* one responder */
+  struct sockaddr_storage	dr_addr;
+  socklen_t					dr_addrlen;
+  double					dr_rtt;		/* ms, first request to first reply */
+  int						dr_nreply;	/* # replies from it */
+  int						dr_datalen;
+  char						dr_data[DISC_DATALEN];	/* its first reply */
+};
+
+struct disc_result {
+  struct disc_reply		*dr_reply;	/* in the order they first replied */
+  int					 dr_n;
+  long					 dr_nsent;		/* requests sent */
+  long					 dr_nrecv;		/* replies read */
+  long					 dr_ndup;		/* ... from a responder already seen */
+  long					 dr_ndrop;		/* dropped by the kernel, if known */
+};
+
+void	disc_default(struct disc_param *);
+int		dg_discover(int, const void *, size_t, const SA *, socklen_t,
+					const struct disc_param *, struct disc_result *);
+void	disc_free(struct disc_result *);
@@ -0,0 +1,76 @@
+#include	"discover.h"
+
+/*
+ * Discovery client: one request to a broadcast (or multicast) address,
+ * then one line per responder, collected by dg_discover().  With -q only
+ * the totals are printed.  The default service is daytime, as in
+ * udpcli01; "bcastresp" in this directory stands in for thousands of
+ * responders on one host.
+ */
+
+int
+main(int argc, char **argv)
+{
+	int					c, i, sockfd, quiet;
+	char				*req;
+	struct disc_param	dp;
+	struct disc_result	dr;
+	struct disc_reply	*r;
+	struct sockaddr_in	servaddr;
+
+	disc_default(&dp);
+	quiet = 0;
+	req = "\n";
+	opterr = 0;
+	while ( (c = getopt(argc, argv, "m:n:qr:t:")) != -1) {
+		switch (c) {
+		case 'm':
+			req = optarg;
+			break;
+		case 'n':
+			dp.dp_maxsend = atoi(optarg);
+			break;
+		case 'q':
+			quiet = 1;
+			break;
+		case 'r':
+			dp.dp_retrans = atoi(optarg);
+			break;
+		case 't':
+			dp.dp_timeout = atoi(optarg);
+			break;
+		case '?':
+			err_quit("unrecognized option: %c", optopt);
+		}
+	}
+	if (optind != argc - 1 && optind != argc - 2)
+		err_quit("usage: udpcli07 [ -m request ] [ -n #sends ] [ -q ] "
+				 "[ -r retransms ] [ -t timeoutms ] <IPaddress> [ port ]");
+
+	bzero(&servaddr, sizeof(servaddr));
+	servaddr.sin_family = AF_INET;
+	servaddr.sin_port = htons(optind == argc - 2 ? atoi(argv[optind + 1]) : 13);
+	Inet_pton(AF_INET, argv[optind], &servaddr.sin_addr);
+
+	sockfd = Socket(AF_INET, SOCK_DGRAM, 0);
+
+	if (dg_discover(sockfd, req, strlen(req), (SA *) &servaddr,
+					sizeof(servaddr), &dp, &dr) < 0)
+		err_sys("dg_discover error");
+
+	if (!quiet) {
+		for (i = 0; i < dr.dr_n; i++) {
+			r = &dr.dr_reply[i];
+			printf("from %s (%.1f ms, %d replies): %.*s",
+				   Sock_ntop_host((SA *) &r->dr_addr, r->dr_addrlen),
+				   r->dr_rtt, r->dr_nreply, r->dr_datalen, r->dr_data);
+			if (r->dr_datalen == 0 || r->dr_data[r->dr_datalen - 1] != '\n')
+				printf("\n");
+		}
+	}
+	printf("%d responders, %ld replies (%ld duplicates), %ld requests sent, "
+		   "%ld dropped\n", dr.dr_n, dr.dr_nrecv, dr.dr_ndup, dr.dr_nsent,
+		   dr.dr_ndrop);
+	disc_free(&dr);
+	exit(0);
+}
@@ -0,0 +1,372 @@
+/* include bufev1 */
+#include	"unpbufev.h"
+
+#define	RING_LEN(r)		((r)->br_tail - (r)->br_head)
+
+static void
+ring_free(struct bufring *r)
+{
+	if (r->br_buf == NULL)
+		return;
+	if (r->br_mirror)
+		mirror_free(r->br_buf, r->br_size);
+	else
+		free(r->br_buf);
+	r->br_buf = NULL;
+}
+
+	/* 4make room for at least need more bytes, data to the front */
+static void
+ring_grow(struct bufring *r, size_t need)
+{
+	int		mirror;
+	size_t	len, size, n;
+	char	*buf;
+
+	len = RING_LEN(r);
+	if (r->br_size - len >= need)
+		return;
+	for (size = max(r->br_size, BEV_BUFSIZE); size - len < need; size *= 2)
+		;
+	if ( (buf = mirror_alloc(size)) != NULL)
+		mirror = 1;
+	else {
+		buf = Malloc(size);
+		mirror = 0;
+	}
+	if (len > 0) {
+		n = min(len, r->br_size - (r->br_head & (r->br_size - 1)));
+		if (r->br_mirror)
+			n = len;		/* it runs on into the second mapping */
+		memcpy(buf, r->br_buf + (r->br_head & (r->br_size - 1)), n);
+		memcpy(buf + n, r->br_buf, len - n);
+	}
+	ring_free(r);
+	r->br_mirror = mirror;
+	r->br_buf = buf;
+	r->br_size = size;
+	r->br_head = 0;
+	r->br_tail = len;
+}
+
+	/* 4the data in the ring, as 0, 1, or 2 iovecs; never 2 if mirrored */
+static int
+ring_data(struct bufring *r, struct iovec *iov)
+{
+	size_t	len, off;
+
+	if ( (len = RING_LEN(r)) == 0)
+		return(0);
+	off = r->br_head & (r->br_size - 1);
+	iov[0].iov_base = r->br_buf + off;
+	iov[0].iov_len = r->br_mirror ? len : min(len, r->br_size - off);
+	if (iov[0].iov_len == len)
+		return(1);
+	iov[1].iov_base = r->br_buf;
+	iov[1].iov_len = len - iov[0].iov_len;
+	return(2);
+}
+
+	/* 4the free space in the ring, as 0, 1, or 2 iovecs */
+static int
+ring_space(struct bufring *r, struct iovec *iov)
+{
+	size_t	nfree, off;
+
+	if ( (nfree = r->br_size - RING_LEN(r)) == 0)
+		return(0);
+	off = r->br_tail & (r->br_size - 1);
+	iov[0].iov_base = r->br_buf + off;
+	iov[0].iov_len = r->br_mirror ? nfree : min(nfree, r->br_size - off);
+	if (iov[0].iov_len == nfree)
+		return(1);
+	iov[1].iov_base = r->br_buf;
+	iov[1].iov_len = nfree - iov[0].iov_len;
+	return(2);
+}
+
+static void
+ring_drop(struct bufring *r, size_t n)
+{
+	r->br_head += n;
+	if (r->br_head == r->br_tail)
+		r->br_head = r->br_tail = 0;	/* back to the front: fewer wraps */
+}
+/* end bufev1 */
+
+/* include bufev2 */
+static void
+bev_error(struct bufev *bev, int err)
+{
+	bev->be_flags |= BEV_ERROR;
+	bev->be_errno = err;
+	if (bev->be_eventcb)
+		(*bev->be_eventcb)(bev, BEV_ERROR, bev->be_arg);
+}
+
+	/* 4tell of the EOF once the reader has taken all that came before it */
+static void
+bev_eof(struct bufev *bev)
+{
+	if ((bev->be_flags & (BEV_EOF | BEV_EOFDONE)) == BEV_EOF &&
+		RING_LEN(&bev->be_in) == 0) {
+		bev->be_flags |= BEV_EOFDONE;
+		if (bev->be_eventcb)
+			(*bev->be_eventcb)(bev, BEV_EOF, bev->be_arg);
+	}
+}
+
+	/* 4one write() of as much output as the descriptor will take */
+static void
+bev_flush(struct bufev *bev)
+{
+	int				iovcnt;
+	ssize_t			n;
+	struct iovec	iov[2];
+
+	if ( (iovcnt = ring_data(&bev->be_out, iov)) == 0)
+		return;
+	if (iovcnt == 1)
+		n = write(bev->be_fd, iov[0].iov_base, iov[0].iov_len);
+	else
+		n = writev(bev->be_fd, iov, iovcnt);
+	if (n < 0) {
+		if (errno != EWOULDBLOCK && errno != EAGAIN && errno != EINTR)
+			bev_error(bev, errno);
+		return;
+	}
+	ring_drop(&bev->be_out, n);
+
+	if (RING_LEN(&bev->be_out) == 0 &&
+		(bev->be_flags & (BEV_SHUTWR | BEV_WDONE)) == BEV_SHUTWR) {
+		bev->be_flags |= BEV_WDONE;
+		if (shutdown(bev->be_fd, SHUT_WR) < 0 && errno != ENOTSOCK)
+			bev_error(bev, errno);
+	}
+}
+
+void
+bufev_handle(struct bufev *bev, short revents)
+{
+	int				iovcnt;
+	ssize_t			n;
+	size_t			len;
+	struct bufring	*r;
+	struct iovec	iov[2];
+
+	if ((bev->be_flags & (BEV_READ | BEV_EOF | BEV_ERROR)) == BEV_READ &&
+		RING_LEN(&bev->be_in) < bev->be_rhigh &&	/* else read() of 0 */
+		(revents & (POLLIN | POLLERR | POLLHUP))) {
+		r = &bev->be_in;
+		len = RING_LEN(r);
+		if (r->br_size == 0)
+			ring_grow(r, BEV_BUFSIZE);
+		else if (r->br_size - len < r->br_size / 4 && r->br_size < bev->be_rhigh)
+			ring_grow(r, r->br_size);		/* doubles it */
+
+		if ( (iovcnt = ring_space(r, iov)) == 1)
+			n = read(bev->be_fd, iov[0].iov_base, iov[0].iov_len);
+		else
+			n = readv(bev->be_fd, iov, iovcnt);
+		if (n > 0) {
+			r->br_tail += n;
+			if (bev->be_readcb)
+				(*bev->be_readcb)(bev, bev->be_arg);
+		} else if (n == 0) {
+			bev->be_flags |= BEV_EOF;
+			bev_eof(bev);
+		} else if (errno != EWOULDBLOCK && errno != EAGAIN && errno != EINTR)
+			bev_error(bev, errno);
+	}
+
+	if ((bev->be_flags & BEV_ERROR) == 0 && RING_LEN(&bev->be_out) > 0 &&
+		(revents & (POLLOUT | POLLERR | POLLHUP))) {
+		bev_flush(bev);
+		if ((bev->be_flags & BEV_ERROR) == 0 &&
+			RING_LEN(&bev->be_out) <= bev->be_wlow && bev->be_writecb)
+			(*bev->be_writecb)(bev, bev->be_arg);
+	}
+}
+/* end bufev2 */
+
+/* include bufev3 */
+short
+bufev_events(struct bufev *bev)
+{
+	short	events = 0;
+
+	if (bev->be_flags & BEV_ERROR)
+		return(0);
+	if ((bev->be_flags & (BEV_READ | BEV_EOF)) == BEV_READ &&
+		RING_LEN(&bev->be_in) < bev->be_rhigh)
+		events |= POLLIN;
+	if (RING_LEN(&bev->be_out) > 0)
+		events |= POLLOUT;
+	return(events);
+}
+
+	/* 4nothing more will happen: an error, or EOF and all written */
+int
+bufev_done(struct bufev *bev)
+{
+	return((bev->be_flags & BEV_ERROR) ||
+		   ((bev->be_flags & BEV_EOFDONE) && RING_LEN(&bev->be_out) == 0));
+}
+
+size_t
+bufev_read(struct bufev *bev, void *ptr, size_t nbytes)
+{
+	int				i, iovcnt;
+	size_t			n, len;
+	struct iovec	iov[2];
+
+	iovcnt = ring_data(&bev->be_in, iov);
+	for (i = 0, n = 0; i < iovcnt && n < nbytes; i++) {
+		len = min(iov[i].iov_len, nbytes - n);
+		memcpy((char *) ptr + n, iov[i].iov_base, len);
+		n += len;
+	}
+	ring_drop(&bev->be_in, n);
+	bev_eof(bev);
+	return(n);
+}
+
+	/*
+	 * Append to the output.  If there was nothing queued, write it now
+	 * instead of waiting for poll() to say the descriptor is writable.
+	 */
+void
+bufev_write(struct bufev *bev, const void *ptr, size_t nbytes)
+{
+	size_t			len, n;
+	struct bufring	*r = &bev->be_out;
+
+	if (nbytes == 0 || (bev->be_flags & (BEV_ERROR | BEV_WDONE)))
+		return;
+	len = RING_LEN(r);
+	ring_grow(r, nbytes);
+	n = min(nbytes, r->br_size - (r->br_tail & (r->br_size - 1)));
+	if (r->br_mirror)
+		n = nbytes;
+	memcpy(r->br_buf + (r->br_tail & (r->br_size - 1)), ptr, n);
+	memcpy(r->br_buf, (const char *) ptr + n, nbytes - n);
+	r->br_tail += nbytes;
+
+	if (len == 0)
+		bev_flush(bev);
+}
+
+	/*
+	 * Move input from one to output of another (or the same, to echo),
+	 * until the input is empty or the output is at its high watermark.
+	 * What is left is moved by the next call, from the reader's readcb or
+	 * the writer's writecb.
+	 */
+size_t
+bufev_move(struct bufev *from, struct bufev *to)
+{
+	int				iovcnt;
+	size_t			n, len, out, total;
+	struct iovec	iov[2];
+
+	total = 0;
+	for ( ; ; ) {
+		len = RING_LEN(&from->be_in);
+		out = RING_LEN(&to->be_out);
+		if (len == 0 || out >= to->be_whigh ||
+			(to->be_flags & (BEV_ERROR | BEV_WDONE)))
+			break;
+		n = min(len, to->be_whigh - out);
+
+		iovcnt = ring_data(&from->be_in, iov);
+		len = min(n, iov[0].iov_len);
+		bufev_write(to, iov[0].iov_base, len);
+		if (iovcnt == 2 && n > len)
+			bufev_write(to, iov[1].iov_base, n - len);
+		ring_drop(&from->be_in, n);
+		total += n;
+	}
+	bev_eof(from);
+	return(total);
+}
+
+	/* 4send a FIN once the output has drained */
+void
+bufev_shutdown(struct bufev *bev)
+{
+	if (bev->be_flags & (BEV_SHUTWR | BEV_ERROR))
+		return;
+	bev->be_flags |= BEV_SHUTWR;
+	if (RING_LEN(&bev->be_out) == 0) {
+		bev->be_flags |= BEV_WDONE;
+		if (shutdown(bev->be_fd, SHUT_WR) < 0 && errno != ENOTSOCK)
+			bev_error(bev, errno);
+	}
+}
+/* end bufev3 */
+
+struct bufev *
+bufev_new(int fd)
+{
+	struct bufev	*bev;
+
+	bev = Calloc(1, sizeof(struct bufev));
+	bev->be_fd = fd;
+	bev->be_flags = BEV_READ;
+	bev->be_rhigh = BEV_HIGHWAT;
+	bev->be_whigh = BEV_HIGHWAT;
+	bev->be_wlow = BEV_HIGHWAT / 2;
+	Fcntl(fd, F_SETFL, Fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+	return(bev);		/* rings are allocated when first used */
+}
+
+void
+bufev_free(struct bufev *bev)
+{
+	ring_free(&bev->be_in);
+	ring_free(&bev->be_out);
+	free(bev);
+}
+
+void
+bufev_setcb(struct bufev *bev, void (*readcb)(struct bufev *, void *),
+			void (*writecb)(struct bufev *, void *),
+			void (*eventcb)(struct bufev *, int, void *), void *arg)
+{
+	bev->be_readcb = readcb;
+	bev->be_writecb = writecb;
+	bev->be_eventcb = eventcb;
+	bev->be_arg = arg;
+}
+
+void
+bufev_setwatermark(struct bufev *bev, size_t rhigh, size_t wlow, size_t whigh)
+{
+	bev->be_rhigh = rhigh;
+	bev->be_wlow = wlow;
+	bev->be_whigh = whigh;
+}
+
+void
+bufev_enable(struct bufev *bev, int flags)
+{
+	bev->be_flags |= (flags & BEV_READ);
+}
+
+void
+bufev_disable(struct bufev *bev, int flags)
+{
+	bev->be_flags &= ~(flags & BEV_READ);
+}
+
+size_t
+bufev_inlen(struct bufev *bev)
+{
+	return(RING_LEN(&bev->be_in));
+}
+
+size_t
+bufev_outlen(struct bufev *bev)
+{
+	return(RING_LEN(&bev->be_out));
+}
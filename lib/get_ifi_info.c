@@ -12,6 +12,11 @@ get_ifi_info(int family, int doaliases)
 	struct sockaddr_in	*sinptr;
 	struct sockaddr_in6	*sin6ptr;
 
+#ifdef	__linux__
+	if (get_ifi_info_nl(family, doaliases, &ifihead) == 0)
+		return(ifihead);	/* from the rtnetlink table, see ifi_netlink.c */
+#endif
+
 	sockfd = Socket(AF_INET, SOCK_DGRAM, 0);
 
 	lastlen = 0;
@@ -160,6 +165,7 @@ get_ifi_info(int family, int doaliases)
 		}
 	}
 	free(buf);
+	close(sockfd);
 	return(ifihead);	/* pointer to first structure in linked list */
 }
 /* end get_ifi_info4 */
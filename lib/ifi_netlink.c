@@ -0,0 +1,496 @@
+/*
+ * get_ifi_info() from an rtnetlink table, for Linux.
+ *
+ * The SIOCGIFCONF version has to guess the buffer size, growing it
+ * until the length stops changing, and then makes another ioctl() for
+ * each of the flags, MTU, and broadcast or destination address of
+ * every interface; it also only sees IPv4 addresses.  Here the first
+ * call dumps the links and then the addresses of all families over one
+ * rtnetlink socket and keeps them in a table.  A second socket,
+ * subscribed to the link and address groups before the dump, carries
+ * RTM_NEWLINK, RTM_DELLINK, RTM_NEWADDR and RTM_DELADDR events, which a
+ * thread applies to the table as they arrive, so later calls build their
+ * list from the table without any system calls.  If the kernel drops
+ * events (ENOBUFS) the table is dumped again.  The thread blocks every
+ * signal, so that the caller's signal() and alarm() handlers still run
+ * in the caller's own thread.
+ *
+ * Without threads the waiting events are read at the start of each call
+ * instead.  A child process after fork() starts its own table on its
+ * next call, since the thread does not follow it.  Both netlink sockets
+ * are close-on-exec, so a program run by a caller does not inherit them.
+ */
+
+#include	"unpifi.h"
+
+#ifdef	__linux__
+#include	<linux/netlink.h>
+#include	<linux/rtnetlink.h>
+
+#define	NL_BUFSIZE	32768
+#define	NL_RCVBUF	(1024 * 1024)	/* room for a burst of events */
+
+struct nl_link {
+  int				l_index;
+  unsigned int		l_flags;	/* IFF_xxx */
+  int				l_mtu;
+  int				l_hlen;
+  u_char			l_haddr[IFI_HADDR];
+  char				l_name[IFI_NAME];
+};
+
+struct nl_addr {
+  int				a_index;	/* of its link */
+  struct sockaddr_storage	a_addr;
+  struct sockaddr_storage	a_brd;	/* ss_family 0 if none */
+  struct sockaddr_storage	a_dst;	/* ditto */
+};
+
+static struct {
+  int				n_init;		/* the table is loaded */
+  int				n_evfd;		/* event socket */
+  int				n_thread;	/* a thread reads n_evfd */
+  struct nl_link   *n_link;		/* in the order the kernel gave them */
+  int				n_nlink, n_maxlink;
+  struct nl_addr   *n_addr;		/* ditto */
+  int				n_naddr, n_maxaddr;
+} nl = { 0, -1 };
+
+#ifdef	HAVE_PTHREAD_H
+static pthread_mutex_t	nl_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t	nl_once = PTHREAD_ONCE_INIT;
+#endif
+
+static struct nl_link *
+nl_findlink(int index)
+{
+	int		i;
+
+	for (i = 0; i < nl.n_nlink; i++)
+		if (nl.n_link[i].l_index == index)
+			return(&nl.n_link[i]);
+	return(NULL);
+}
+
+/* Copy an address attribute into a sockaddr for the link "index". */
+static void
+nl_sockaddr(struct sockaddr_storage *ss, int family, struct rtattr *rta,
+			int index)
+{
+	struct sockaddr_in	*sin;
+	struct sockaddr_in6	*sin6;
+
+	bzero(ss, sizeof(*ss));
+	if (family == AF_INET && RTA_PAYLOAD(rta) >= 4) {
+		sin = (struct sockaddr_in *) ss;
+		sin->sin_family = AF_INET;
+		memcpy(&sin->sin_addr, RTA_DATA(rta), 4);
+	} else if (family == AF_INET6 && RTA_PAYLOAD(rta) >= 16) {
+		sin6 = (struct sockaddr_in6 *) ss;
+		sin6->sin6_family = AF_INET6;
+		memcpy(&sin6->sin6_addr, RTA_DATA(rta), 16);
+		if (IN6_IS_ADDR_LINKLOCAL(&sin6->sin6_addr))
+			sin6->sin6_scope_id = index;
+	}
+}
+
+static void
+nl_newlink(struct nlmsghdr *nh)
+{
+	int					len;
+	struct ifinfomsg	*ifm;
+	struct rtattr		*rta;
+	struct nl_link		*lp;
+
+	ifm = NLMSG_DATA(nh);
+	if ( (lp = nl_findlink(ifm->ifi_index)) == NULL) {
+		if (nl.n_nlink == nl.n_maxlink) {
+			len = nl.n_maxlink ? 2 * nl.n_maxlink : 16;
+			if ( (lp = realloc(nl.n_link, len * sizeof(*lp))) == NULL)
+				return;
+			nl.n_link = lp;
+			nl.n_maxlink = len;
+		}
+		lp = &nl.n_link[nl.n_nlink++];
+		bzero(lp, sizeof(*lp));
+		lp->l_index = ifm->ifi_index;
+	}
+	lp->l_flags = ifm->ifi_flags;
+
+	len = IFLA_PAYLOAD(nh);
+	for (rta = IFLA_RTA(ifm); RTA_OK(rta, len); rta = RTA_NEXT(rta, len)) {
+		switch (rta->rta_type) {
+		case IFLA_IFNAME:
+			strncpy(lp->l_name, RTA_DATA(rta), IFI_NAME);
+			lp->l_name[IFI_NAME-1] = '\0';
+			break;
+		case IFLA_MTU:
+			memcpy(&lp->l_mtu, RTA_DATA(rta), sizeof(int));
+			break;
+		case IFLA_ADDRESS:
+			lp->l_hlen = min(RTA_PAYLOAD(rta), IFI_HADDR);
+			memcpy(lp->l_haddr, RTA_DATA(rta), lp->l_hlen);
+			break;
+		}
+	}
+}
+
+static void
+nl_dellink(struct nlmsghdr *nh)
+{
+	int					i, index;
+	struct nl_link		*lp;
+
+	index = ((struct ifinfomsg *) NLMSG_DATA(nh))->ifi_index;
+	if ( (lp = nl_findlink(index)) != NULL) {
+		i = lp - nl.n_link;
+		memmove(lp, lp + 1, (--nl.n_nlink - i) * sizeof(*lp));
+	}
+	for (i = 0; i < nl.n_naddr; ) {		/* and its addresses */
+		if (nl.n_addr[i].a_index == index)
+			memmove(&nl.n_addr[i], &nl.n_addr[i+1],
+					(--nl.n_naddr - i) * sizeof(struct nl_addr));
+		else
+			i++;
+	}
+}
+
+/*
+ * RTM_NEWADDR and RTM_DELADDR.  For IPv4, IFA_LOCAL is the address and
+ * IFA_ADDRESS is the other end of a point-to-point link, or the same
+ * as IFA_LOCAL; IPv6 has only IFA_ADDRESS.
+ */
+static void
+nl_addr(struct nlmsghdr *nh)
+{
+	int					i, len;
+	struct ifaddrmsg	*ifa;
+	struct rtattr		*rta, *local, *address, *brd;
+	struct nl_addr		a, *ap;
+
+	ifa = NLMSG_DATA(nh);
+	if (ifa->ifa_family != AF_INET && ifa->ifa_family != AF_INET6)
+		return;
+	local = address = brd = NULL;
+	len = IFA_PAYLOAD(nh);
+	for (rta = IFA_RTA(ifa); RTA_OK(rta, len); rta = RTA_NEXT(rta, len)) {
+		if (rta->rta_type == IFA_LOCAL)
+			local = rta;
+		else if (rta->rta_type == IFA_ADDRESS)
+			address = rta;
+		else if (rta->rta_type == IFA_BROADCAST)
+			brd = rta;
+	}
+	if (local == NULL && (local = address) == NULL)
+		return;
+
+	bzero(&a, sizeof(a));
+	a.a_index = ifa->ifa_index;
+	nl_sockaddr(&a.a_addr, ifa->ifa_family, local, a.a_index);
+	if (brd != NULL)
+		nl_sockaddr(&a.a_brd, ifa->ifa_family, brd, a.a_index);
+	if (address != NULL && address != local &&
+		memcmp(RTA_DATA(address), RTA_DATA(local), RTA_PAYLOAD(local)) != 0)
+		nl_sockaddr(&a.a_dst, ifa->ifa_family, address, a.a_index);
+
+	for (i = 0; i < nl.n_naddr; i++)
+		if (nl.n_addr[i].a_index == a.a_index &&
+			sock_cmp_addr((SA *) &nl.n_addr[i].a_addr, (SA *) &a.a_addr,
+						  sizeof(a.a_addr)) == 0)
+			break;
+
+	if (nh->nlmsg_type == RTM_DELADDR) {
+		if (i < nl.n_naddr)
+			memmove(&nl.n_addr[i], &nl.n_addr[i+1],
+					(--nl.n_naddr - i) * sizeof(struct nl_addr));
+		return;
+	}
+	if (i == nl.n_naddr) {				/* a new one goes at the end */
+		if (nl.n_naddr == nl.n_maxaddr) {
+			len = nl.n_maxaddr ? 2 * nl.n_maxaddr : 16;
+			if ( (ap = realloc(nl.n_addr, len * sizeof(*ap))) == NULL)
+				return;
+			nl.n_addr = ap;
+			nl.n_maxaddr = len;
+		}
+		nl.n_naddr++;
+	}
+	nl.n_addr[i] = a;
+}
+
+/*
+ * Apply the messages in "buf" to the table.  Return 1 at the end of a
+ * dump, -1 with errno set for an error message, else 0.
+ */
+static int
+nl_parse(char *buf, int n)
+{
+	struct nlmsghdr	*nh;
+
+	for (nh = (struct nlmsghdr *) buf; NLMSG_OK(nh, n);
+		 nh = NLMSG_NEXT(nh, n)) {
+		switch (nh->nlmsg_type) {
+		case NLMSG_DONE:
+			return(1);
+		case NLMSG_ERROR:
+			errno = -((struct nlmsgerr *) NLMSG_DATA(nh))->error;
+			return(-1);
+		case RTM_NEWLINK:
+			nl_newlink(nh);
+			break;
+		case RTM_DELLINK:
+			nl_dellink(nh);
+			break;
+		case RTM_NEWADDR:
+		case RTM_DELADDR:
+			nl_addr(nh);
+			break;
+		}
+	}
+	return(0);
+}
+
+/* Empty the table and dump the links, then the addresses, into it. */
+static int
+nl_dump(void)
+{
+	int		fd, n, i, rc;
+	char	*buf;
+	struct {
+	  struct nlmsghdr	nh;
+	  struct rtgenmsg	g;
+	} req;
+	static const int	types[2] = { RTM_GETLINK, RTM_GETADDR };
+
+	nl.n_nlink = nl.n_naddr = 0;
+	if ( (fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE)) < 0)
+		return(-1);
+	if ( (buf = malloc(NL_BUFSIZE)) == NULL) {
+		close(fd);
+		return(-1);
+	}
+	for (i = 0, rc = 1; i < 2 && rc == 1; i++) {
+		rc = 0;
+		bzero(&req, sizeof(req));
+		req.nh.nlmsg_len = sizeof(req);
+		req.nh.nlmsg_type = types[i];
+		req.nh.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+		req.nh.nlmsg_seq = i + 1;
+		req.g.rtgen_family = AF_UNSPEC;
+		if (send(fd, &req, sizeof(req), 0) != sizeof(req))
+			rc = -1;
+		else while ( (n = recv(fd, buf, NL_BUFSIZE, 0)) > 0 &&
+					 (rc = nl_parse(buf, n)) == 0)
+			;
+		if (rc == 0)
+			rc = -1;		/* recv() failed before NLMSG_DONE */
+	}
+	free(buf);
+	close(fd);
+	if (rc < 0) {
+		nl.n_nlink = nl.n_naddr = 0;
+		return(-1);
+	}
+	return(0);
+}
+
+/*
+ * Read the events waiting on the event socket, without blocking.
+ * With the table locked.
+ */
+static void
+nl_drain(void)
+{
+	int		n;
+	char	buf[NL_BUFSIZE];
+
+	for ( ; ; ) {
+		if ( (n = recv(nl.n_evfd, buf, sizeof(buf), MSG_DONTWAIT)) > 0)
+			nl_parse(buf, n);
+		else if (n < 0 && errno == ENOBUFS)
+			nl.n_init = (nl_dump() == 0);	/* lost some: start over */
+		else if (n < 0 && errno == EINTR)
+			continue;
+		else
+			break;
+	}
+}
+
+#ifdef	HAVE_PTHREAD_H
+/* The thread that applies events as they arrive. */
+static void *
+nl_thread(void *arg)
+{
+	int		n, fd;
+	char	*buf;
+
+	fd = nl.n_evfd;
+	if ( (buf = malloc(NL_BUFSIZE)) == NULL)
+		return(NULL);
+	for ( ; ; ) {
+		n = recv(fd, buf, NL_BUFSIZE, 0);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n == 0 || (n < 0 && errno != ENOBUFS))
+			break;
+		pthread_mutex_lock(&nl_mutex);
+		if (n > 0)
+			nl_parse(buf, n);
+		else
+			nl.n_init = (nl_dump() == 0);	/* lost some: start over */
+		pthread_mutex_unlock(&nl_mutex);
+	}
+	pthread_mutex_lock(&nl_mutex);
+	nl.n_thread = 0;					/* calls read the events now */
+	pthread_mutex_unlock(&nl_mutex);
+	free(buf);
+	return(NULL);
+}
+
+/* After fork(), in the child: no thread, so start again on the next call. */
+static void
+nl_child(void)
+{
+	pthread_mutex_init(&nl_mutex, NULL);
+	if (nl.n_evfd >= 0)
+		close(nl.n_evfd);
+	nl.n_evfd = -1;
+	nl.n_init = nl.n_thread = 0;
+}
+
+static void
+nl_atfork(void)
+{
+	pthread_atfork(NULL, NULL, nl_child);
+}
+#endif
+
+/* Open the event socket, dump the table and start the thread. */
+static int
+nl_load(void)
+{
+	int					n;
+	struct sockaddr_nl	sa;
+#ifdef	HAVE_PTHREAD_H
+	pthread_t			tid;
+	pthread_attr_t		attr;
+	sigset_t			all, old;
+#endif
+
+	if (nl.n_evfd < 0) {
+		if ( (nl.n_evfd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC,
+								 NETLINK_ROUTE)) < 0)
+			return(-1);
+		n = NL_RCVBUF;
+		setsockopt(nl.n_evfd, SOL_SOCKET, SO_RCVBUF, &n, sizeof(n));
+		bzero(&sa, sizeof(sa));
+		sa.nl_family = AF_NETLINK;
+		sa.nl_groups = RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR;
+		if (bind(nl.n_evfd, (SA *) &sa, sizeof(sa)) < 0) {
+			close(nl.n_evfd);
+			nl.n_evfd = -1;
+			return(-1);
+		}
+	}
+	if (nl_dump() < 0)
+		return(-1);
+	nl.n_init = 1;
+
+#ifdef	HAVE_PTHREAD_H
+	pthread_once(&nl_once, nl_atfork);
+	if (nl.n_thread == 0) {
+		nl_drain();				/* events from before the dump */
+		pthread_attr_init(&attr);
+		pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+			/* 4the thread inherits our mask: leave all signals to the caller */
+		sigfillset(&all);
+		pthread_sigmask(SIG_SETMASK, &all, &old);
+		nl.n_thread = (pthread_create(&tid, &attr, nl_thread, NULL) == 0);
+		pthread_sigmask(SIG_SETMASK, &old, NULL);
+		pthread_attr_destroy(&attr);
+	}
+#endif
+	return(0);
+}
+
+/* include get_ifi_info_nl */
+int
+get_ifi_info_nl(int family, int doaliases, struct ifi_info **ifiheadp)
+{
+	int					i, j, alias;
+	socklen_t			salen;
+	struct nl_link		*lp;
+	struct nl_addr		*ap;
+	struct ifi_info		*ifi, *ifihead, **ifipnext;
+
+#ifdef	HAVE_PTHREAD_H
+	pthread_mutex_lock(&nl_mutex);
+#endif
+	if (nl.n_init == 0 && nl_load() < 0) {
+#ifdef	HAVE_PTHREAD_H
+		pthread_mutex_unlock(&nl_mutex);
+#endif
+		return(-1);
+	}
+	if (nl.n_thread == 0)
+		nl_drain();
+
+	ifihead = NULL;
+	ifipnext = &ifihead;
+	salen = (family == AF_INET6) ? sizeof(struct sockaddr_in6) :
+								   sizeof(struct sockaddr_in);
+	for (i = 0; i < nl.n_nlink; i++) {
+		lp = &nl.n_link[i];
+		if ((lp->l_flags & IFF_UP) == 0)
+			continue;	/* ignore if interface not up */
+		alias = 0;
+		for (j = 0; j < nl.n_naddr; j++) {
+			ap = &nl.n_addr[j];
+			if (ap->a_index != lp->l_index ||
+				ap->a_addr.ss_family != family)
+				continue;
+			if (alias && doaliases == 0)
+				break;	/* only the first address */
+
+			ifi = Calloc(1, sizeof(struct ifi_info));
+			*ifipnext = ifi;			/* prev points to this new one */
+			ifipnext = &ifi->ifi_next;	/* pointer to next one goes here */
+
+			memcpy(ifi->ifi_name, lp->l_name, IFI_NAME);
+			ifi->ifi_index = lp->l_index;
+			ifi->ifi_mtu = lp->l_mtu;
+			ifi->ifi_hlen = lp->l_hlen;
+			memcpy(ifi->ifi_haddr, lp->l_haddr, lp->l_hlen);
+			ifi->ifi_flags = lp->l_flags;	/* IFF_xxx values */
+			ifi->ifi_myflags = alias ? IFI_ALIAS : 0;
+			alias = 1;
+
+			ifi->ifi_addr = Calloc(1, salen);
+			memcpy(ifi->ifi_addr, &ap->a_addr, salen);
+			if ((lp->l_flags & IFF_BROADCAST) && ap->a_brd.ss_family) {
+				ifi->ifi_brdaddr = Calloc(1, salen);
+				memcpy(ifi->ifi_brdaddr, &ap->a_brd, salen);
+			}
+			if ((lp->l_flags & IFF_POINTOPOINT) && ap->a_dst.ss_family) {
+				ifi->ifi_dstaddr = Calloc(1, salen);
+				memcpy(ifi->ifi_dstaddr, &ap->a_dst, salen);
+			}
+		}
+	}
+#ifdef	HAVE_PTHREAD_H
+	pthread_mutex_unlock(&nl_mutex);
+#endif
+	*ifiheadp = ifihead;
+	return(0);
+}
+/* end get_ifi_info_nl */
+
+#else	/* not Linux */
+
+int
+get_ifi_info_nl(int family, int doaliases, struct ifi_info **ifiheadp)
+{
+	errno = ENOSYS;
+	return(-1);
+}
+#endif
@@ -0,0 +1,64 @@
+#ifndef	_GNU_SOURCE
+#define	_GNU_SOURCE			/* memfd_create() */
+#endif
+/* include mirror */
+#include	"unp.h"
+#include	<sys/mman.h>
+
+/*
+ * Map size bytes of memory twice, back to back, so that byte i and byte
+ * i + size are the same.  A ring buffer in it can hand any run of up to
+ * size bytes, starting anywhere, to read() or write() as one span: the
+ * part past the end is the start again.  size must be a multiple of the
+ * page size.  Returns NULL if it cannot be done, and the caller uses an
+ * ordinary buffer.
+ */
+void *
+mirror_alloc(size_t size)
+{
+#ifdef	__linux__
+	int		fd, saverr;
+	char	*ptr;
+
+	if (size == 0 || size % sysconf(_SC_PAGESIZE) != 0) {
+		errno = EINVAL;
+		return(NULL);
+	}
+	if ( (fd = memfd_create("ring", MFD_CLOEXEC)) < 0)
+		return(NULL);
+	ptr = MAP_FAILED;
+	if (ftruncate(fd, size) < 0)
+		goto fail;
+
+		/* 4reserve room for both, then put the pages in each half */
+	if ( (ptr = mmap(NULL, 2 * size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS,
+					 -1, 0)) == MAP_FAILED)
+		goto fail;
+	if (mmap(ptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED,
+			 fd, 0) == MAP_FAILED ||
+		mmap(ptr + size, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED,
+			 fd, 0) == MAP_FAILED)
+		goto fail;
+	close(fd);			/* the mappings keep the pages */
+	return(ptr);
+
+fail:
+	saverr = errno;
+	if (ptr != MAP_FAILED)
+		munmap(ptr, 2 * size);
+	close(fd);
+	errno = saverr;
+	return(NULL);
+#else
+	errno = ENOSYS;
+	return(NULL);
+#endif
+}
+/* end mirror */
+
+void
+mirror_free(void *ptr, size_t size)
+{
+	if (munmap(ptr, 2 * size) < 0)
+		err_sys("munmap error");
+}
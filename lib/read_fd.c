@@ -68,3 +68,82 @@ Read_fd(int fd, void *ptr, size_t nbytes, int *recvfd)
 
 	return(n);
 }
+
+/*
+ * read_fd() for up to *nfds descriptors (at most MAXFDPASS), as sent by
+ * write_fds() in one message.  On return *nfds is the number received.
+ */
+/* include read_fds */
+ssize_t
+read_fds(int fd, void *ptr, size_t nbytes, int *recvfds, int *nfds)
+{
+	struct msghdr	msg;
+	struct iovec	iov[1];
+	ssize_t			n;
+	int				i, nmax;
+
+#ifdef	HAVE_MSGHDR_MSG_CONTROL
+	union {
+	  struct cmsghdr	cm;
+	  char				control[CMSG_SPACE(MAXFDPASS * sizeof(int))];
+	} control_un;
+	struct cmsghdr	*cmptr;
+#else
+	int				newfd[MAXFDPASS];
+#endif
+
+	nmax = min(*nfds, MAXFDPASS);
+	*nfds = 0;
+
+#ifdef	HAVE_MSGHDR_MSG_CONTROL
+	msg.msg_control = control_un.control;
+	msg.msg_controllen = CMSG_SPACE(nmax * sizeof(int));
+#else
+	msg.msg_accrights = (caddr_t) newfd;
+	msg.msg_accrightslen = nmax * sizeof(int);
+#endif
+
+	msg.msg_name = NULL;
+	msg.msg_namelen = 0;
+
+	iov[0].iov_base = ptr;
+	iov[0].iov_len = nbytes;
+	msg.msg_iov = iov;
+	msg.msg_iovlen = 1;
+
+	if ( (n = recvmsg(fd, &msg, 0)) <= 0)
+		return(n);
+
+#ifdef	HAVE_MSGHDR_MSG_CONTROL
+	for (cmptr = CMSG_FIRSTHDR(&msg); cmptr != NULL;
+		 cmptr = CMSG_NXTHDR(&msg, cmptr)) {
+		if (cmptr->cmsg_level != SOL_SOCKET)
+			err_quit("control level != SOL_SOCKET");
+		if (cmptr->cmsg_type != SCM_RIGHTS)
+			err_quit("control type != SCM_RIGHTS");
+		i = (cmptr->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+		memcpy(recvfds + *nfds, CMSG_DATA(cmptr), i * sizeof(int));
+		*nfds += i;
+	}
+#else
+/* *INDENT-OFF* */
+	*nfds = msg.msg_accrightslen / sizeof(int);
+	for (i = 0; i < *nfds; i++)
+		recvfds[i] = newfd[i];
+/* *INDENT-ON* */
+#endif
+
+	return(n);
+}
+/* end read_fds */
+
+ssize_t
+Read_fds(int fd, void *ptr, size_t nbytes, int *recvfds, int *nfds)
+{
+	ssize_t		n;
+
+	if ( (n = read_fds(fd, ptr, nbytes, recvfds, nfds)) < 0)
+		err_sys("read_fds error");
+
+	return(n);
+}
@@ -76,13 +76,33 @@ rtt_start(struct rtt_info *ptr)
  * timer with alarm(0), or right after a timeout occurs.
  */
 
+static void	rtt_update(struct rtt_info *, double);
+
 /* include rtt_stop */
 void
 rtt_stop(struct rtt_info *ptr, uint32_t ms)
+{
+	rtt_update(ptr, ms / 1000.0);
+}
+
+/*
+ * Same as rtt_stop(), but the RTT is measured between two timestamps,
+ * normally the kernel's transmit and receive timestamps (see tstamp.c),
+ * with more than the millisecond resolution of rtt_ts().
+ */
+void
+rtt_stop_ts(struct rtt_info *ptr, const struct timespec *tssend,
+			const struct timespec *tsrecv)
+{
+	rtt_update(ptr, tstamp_msec(tsrecv, tssend) / 1000.0);
+}
+
+static void
+rtt_update(struct rtt_info *ptr, double rtt)
 {
 	double		delta;
 
-	ptr->rtt_rtt = ms / 1000.0;		/* measured RTT in seconds */
+	ptr->rtt_rtt = rtt;				/* measured RTT in seconds */
 
 	/*
 	 * Update our estimators of RTT and mean deviation of RTT.
@@ -1,11 +1,83 @@
 /* include tcp_connect */
 #include	"unp.h"
+#include	<netinet/tcp.h>
 
 int
 tcp_connect(const char *host, const char *serv)
 {
-	int				sockfd, n;
-	struct addrinfo	hints, *res, *ressave;
+	return(tcp_connect_opt(host, serv, NULL));
+}
+
+/*
+ * Connect, then send opt->to_data if there is any.  With to_fastopen,
+ * use the client half of TCP Fast Open: the data goes out in the SYN,
+ * by sendto(MSG_FASTOPEN), and once the client holds a cookie from an
+ * earlier connection to the same server, the server has the request a
+ * round trip sooner.  With to_fastopen and no to_data,
+ * TCP_FASTOPEN_CONNECT holds back the SYN until the caller's first
+ * write().  Where neither exists the connect is an ordinary one.
+ * With SOCK_NONBLOCK in to_sockflags there is no to_data (the caller
+ * checks), and a connect that is still in progress is success.
+ */
+static int
+connect_data(int sockfd, const struct addrinfo *res,
+			 const struct tcp_opts *opt)
+{
+	ssize_t		n;
+
+	if (opt->to_fastopen == 0)
+		goto plain;
+
+#ifdef	MSG_FASTOPEN
+	if (opt->to_data != NULL) {
+		n = sendto(sockfd, opt->to_data, opt->to_datalen, MSG_FASTOPEN,
+				   res->ai_addr, res->ai_addrlen);
+		if (n >= 0) {
+			if (n < opt->to_datalen &&		/* the rest did not fit */
+				writen(sockfd, (const char *) opt->to_data + n,
+					   opt->to_datalen - n) < 0)
+				return(-1);
+			return(0);
+		}
+		if (errno != EOPNOTSUPP)
+			return(-1);
+	}
+#endif
+#ifdef	TCP_FASTOPEN_CONNECT
+	if (opt->to_data == NULL) {
+		const int	on = 1;
+
+		setsockopt(sockfd, IPPROTO_TCP, TCP_FASTOPEN_CONNECT, &on, sizeof(on));
+	}
+#endif
+
+plain:
+	if (connect(sockfd, res->ai_addr, res->ai_addrlen) < 0)
+		return(errno == EINPROGRESS ? 0 : -1);	/* SOCK_NONBLOCK */
+	if (opt->to_data != NULL &&
+		writen(sockfd, opt->to_data, opt->to_datalen) < 0)
+		return(-1);
+	return(0);
+}
+
+int
+tcp_connect_opt(const char *host, const char *serv, const struct tcp_opts *opt)
+{
+	int					sockfd, n, i, ntry;
+	struct addrinfo		hints, *res, *ressave;
+	struct tcp_srcpool	*sp;
+	static const struct tcp_opts	noopt;
+
+	if (opt == NULL)
+		opt = &noopt;
+	sp = opt->to_srcpool;
+#ifdef	SOCK_NONBLOCK
+	if (opt->to_data != NULL && (opt->to_sockflags & SOCK_NONBLOCK)) {
+		errno = EINVAL;		/* we could not wait to send it all */
+		err_sys("tcp_connect error for %s, %s: to_data with SOCK_NONBLOCK",
+				host, serv);
+	}
+#endif
 
 	bzero(&hints, sizeof(struct addrinfo));
 	hints.ai_family = AF_UNSPEC;
@@ -17,18 +89,41 @@ tcp_connect(const char *host, const char *serv)
 	ressave = res;
 
 	do {
-		sockfd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
-		if (sockfd < 0)
-			continue;	/* ignore this one */
+			/* 4with a pool, try its addresses until one has a port */
+		ntry = (sp != NULL) ? sp->sp_n : 1;
+		sockfd = -1;
+		for (i = 0; i < ntry; i++) {
+			sockfd = socket(res->ai_family,
+							res->ai_socktype | opt->to_sockflags,
+							res->ai_protocol);
+			if (sockfd < 0)
+				break;	/* ignore this one */
 
-		if (connect(sockfd, res->ai_addr, res->ai_addrlen) == 0)
-			break;		/* success */
+			if (sp != NULL &&
+				tcp_srcpool_bind(sockfd, res->ai_family, sp) < 0) {
+				Close(sockfd);
+				sockfd = -1;
+				if (errno == EADDRINUSE)
+					continue;	/* out of ports at bind(): next address */
+				break;
+			}
+			if (connect_data(sockfd, res, opt) == 0)
+				break;	/* success */
 
-		Close(sockfd);	/* ignore this one */
+			Close(sockfd);	/* ignore this one */
+			sockfd = -1;
+			if (sp == NULL || errno != EADDRNOTAVAIL)
+				break;
+			sp->sp_nexhaust++;	/* out of ports at connect(): next address */
+		}
+		if (sockfd >= 0)
+			break;		/* success */
 	} while ( (res = res->ai_next) != NULL);
 
 	if (res == NULL)	/* errno set from final connect() */
 		err_sys("tcp_connect error for %s, %s", host, serv);
+	if (sp != NULL)
+		sp->sp_nconnect++;
 
 	freeaddrinfo(ressave);
 
@@ -47,3 +142,9 @@ Tcp_connect(const char *host, const char *serv)
 {
 	return(tcp_connect(host, serv));
 }
+
+int
+Tcp_connect_opt(const char *host, const char *serv, const struct tcp_opts *opt)
+{
+	return(tcp_connect_opt(host, serv, opt));
+}
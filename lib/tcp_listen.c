@@ -1,12 +1,33 @@
+#ifndef	_GNU_SOURCE
+#define	_GNU_SOURCE			/* accept4() */
+#endif
 /* include tcp_listen */
 #include	"unp.h"
+#include	<netinet/tcp.h>
 
 int
 tcp_listen(const char *host, const char *serv, socklen_t *addrlenp)
 {
-	int				listenfd, n;
+	return(tcp_listen_opt(host, serv, addrlenp, NULL));
+}
+
+/*
+ * tcp_listen() with the options in *opt, which may be NULL.  An option
+ * this system does not have is ignored.  An explicit to_backlog is used
+ * as is; otherwise the backlog is LISTENQ, which the LISTENQ environment
+ * variable can override (see Listen()).
+ */
+int
+tcp_listen_opt(const char *host, const char *serv, socklen_t *addrlenp,
+			   const struct tcp_opts *opt)
+{
+	int				listenfd, n, type;
 	const int		on = 1;
 	struct addrinfo	hints, *res, *ressave;
+	static const struct tcp_opts	noopt;
+
+	if (opt == NULL)
+		opt = &noopt;
 
 	bzero(&hints, sizeof(struct addrinfo));
 	hints.ai_flags = AI_PASSIVE;
@@ -19,11 +40,16 @@ tcp_listen(const char *host, const char *serv, socklen_t *addrlenp)
 	ressave = res;
 
 	do {
-		listenfd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+		type = res->ai_socktype | opt->to_sockflags;
+		listenfd = socket(res->ai_family, type, res->ai_protocol);
 		if (listenfd < 0)
 			continue;		/* error, try next one */
 
 		Setsockopt(listenfd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+#ifdef	SO_REUSEPORT
+		if (opt->to_reuseport)
+			Setsockopt(listenfd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+#endif
 		if (bind(listenfd, res->ai_addr, res->ai_addrlen) == 0)
 			break;			/* success */
 
@@ -33,7 +59,24 @@ tcp_listen(const char *host, const char *serv, socklen_t *addrlenp)
 	if (res == NULL)	/* errno from final socket() or bind() */
 		err_sys("tcp_listen error for %s, %s", host, serv);
 
-	Listen(listenfd, LISTENQ);
+#ifdef	TCP_DEFER_ACCEPT
+		/* 4accept() returns only once the client has sent something */
+	if (opt->to_deferaccept > 0)
+		Setsockopt(listenfd, IPPROTO_TCP, TCP_DEFER_ACCEPT,
+				   &opt->to_deferaccept, sizeof(opt->to_deferaccept));
+#endif
+#ifdef	TCP_FASTOPEN
+		/* 4data in the SYN is accepted, up to this many pending */
+	if (opt->to_fastopen > 0)
+		Setsockopt(listenfd, IPPROTO_TCP, TCP_FASTOPEN,
+				   &opt->to_fastopen, sizeof(opt->to_fastopen));
+#endif
+
+	if (opt->to_backlog > 0) {
+		if (listen(listenfd, opt->to_backlog) < 0)
+			err_sys("listen error");
+	} else
+		Listen(listenfd, LISTENQ);
 
 	if (addrlenp)
 		*addrlenp = res->ai_addrlen;	/* return size of protocol address */
@@ -44,6 +87,22 @@ tcp_listen(const char *host, const char *serv, socklen_t *addrlenp)
 }
 /* end tcp_listen */
 
+/*
+ * accept() with the to_acceptflags of *opt (which may be NULL) applied
+ * to the new socket by accept4(), where there is one.
+ */
+int
+tcp_accept(int listenfd, SA *sa, socklen_t *salenptr,
+		   const struct tcp_opts *opt)
+{
+#ifdef	SOCK_NONBLOCK
+	return(accept4(listenfd, sa, salenptr,
+				   (opt != NULL) ? opt->to_acceptflags : 0));
+#else
+	return(accept(listenfd, sa, salenptr));
+#endif
+}
+
 /*
  * We place the wrapper function here, not in wraplib.c, because some
  * XTI programs need to include wraplib.c, and it also defines
@@ -55,3 +114,30 @@ Tcp_listen(const char *host, const char *serv, socklen_t *addrlenp)
 {
 	return(tcp_listen(host, serv, addrlenp));
 }
+
+int
+Tcp_listen_opt(const char *host, const char *serv, socklen_t *addrlenp,
+			   const struct tcp_opts *opt)
+{
+	return(tcp_listen_opt(host, serv, addrlenp, opt));
+}
+
+int
+Tcp_accept(int listenfd, SA *sa, socklen_t *salenptr,
+		   const struct tcp_opts *opt)
+{
+	int		n;
+
+again:
+	if ( (n = tcp_accept(listenfd, sa, salenptr, opt)) < 0) {
+#ifdef	EPROTO
+		if (errno == EPROTO || errno == ECONNABORTED)
+#else
+		if (errno == ECONNABORTED)
+#endif
+			goto again;
+		else
+			err_sys("accept error");
+	}
+	return(n);
+}
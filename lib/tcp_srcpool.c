@@ -0,0 +1,170 @@
+/*
+ * A pool of local addresses for tcp_connect_opt() to bind its sockets
+ * to in turn.  A client that opens and closes connections as fast as it
+ * can leaves one in TIME_WAIT per connection, and the ephemeral ports
+ * for one source address and one server run out after some 28,000 of
+ * them (the default ip_local_port_range on Linux) until the oldest
+ * expire; then connect() fails with EADDRNOTAVAIL.  Spreading the
+ * connections over N source addresses gives N times as many.  On Linux
+ * all of 127/8 is local, so a loopback benchmark can use as many as it
+ * likes.
+ *
+ * Binding to an address normally picks the port then and there, and
+ * has to pick one not in use with any server: IP_BIND_ADDRESS_NO_PORT
+ * leaves the choice to connect(), which only needs it unique for the
+ * one server, so the same port can be used to many servers at once.
+ */
+
+#include	"unp.h"
+
+#if	defined(__linux__) && !defined(IP_BIND_ADDRESS_NO_PORT)
+#define	IP_BIND_ADDRESS_NO_PORT	24		/* <linux/in.h> */
+#endif
+
+#define	MAXPOOL	65536			/* most addresses from one prefix */
+
+static int
+pool_add(struct tcp_srcpool *sp, const struct sockaddr *sa, socklen_t salen)
+{
+	int						nmax;
+	struct sockaddr_storage	*a;
+
+	if (sp->sp_n == sp->sp_max) {
+		nmax = sp->sp_max ? 2 * sp->sp_max : 16;
+		if ( (a = realloc(sp->sp_addr, nmax * sizeof(*a))) == NULL)
+			return(-1);
+		sp->sp_addr = a;
+		sp->sp_max = nmax;
+	}
+	bzero(&sp->sp_addr[sp->sp_n], sizeof(struct sockaddr_storage));
+	memcpy(&sp->sp_addr[sp->sp_n++], sa, salen);
+	return(0);
+}
+
+/*
+ * Parse a comma-separated list of local addresses, IPv4 or IPv6, each of
+ * which may be an IPv4 prefix ("127.0.0.0/24") standing for all of its
+ * addresses but the first and last, up to MAXPOOL of them.  Returns
+ * NULL with errno EINVAL if the list has something else in it.
+ */
+struct tcp_srcpool *
+tcp_srcpool_alloc(const char *spec)
+{
+	int					plen;
+	char				*list, *tok, *slash, *last;
+	uint32_t			base, i, n;
+	struct sockaddr_in	sin;
+	struct sockaddr_in6	sin6;
+	struct tcp_srcpool	*sp;
+
+	if ( (sp = calloc(1, sizeof(struct tcp_srcpool))) == NULL)
+		return(NULL);
+	if ( (list = strdup(spec)) == NULL)
+		goto bad;
+
+	for (tok = strtok_r(list, ",", &last); tok != NULL;
+		 tok = strtok_r(NULL, ",", &last)) {
+		bzero(&sin, sizeof(sin));
+		sin.sin_family = AF_INET;
+		bzero(&sin6, sizeof(sin6));
+		sin6.sin6_family = AF_INET6;
+
+		plen = 32;
+		if ( (slash = strchr(tok, '/')) != NULL) {
+			*slash = 0;
+			plen = atoi(slash + 1);
+		}
+		if (inet_pton(AF_INET, tok, &sin.sin_addr) == 1) {
+			if (plen < 1 || plen > 32)
+				goto inval;
+			base = ntohl(sin.sin_addr.s_addr) & ~((1U << (32 - plen)) - 1);
+			n = 1U << (32 - plen);
+			i = 0;
+			if (plen < 31) {		/* not the network and broadcast */
+				i = 1;
+				n--;
+			}
+			n = min(n, i + MAXPOOL);
+			for ( ; i < n; i++) {
+				sin.sin_addr.s_addr = htonl(base + i);
+				if (pool_add(sp, (SA *) &sin, sizeof(sin)) < 0)
+					goto bad;
+			}
+		} else if (slash == NULL &&
+				   inet_pton(AF_INET6, tok, &sin6.sin6_addr) == 1) {
+			if (pool_add(sp, (SA *) &sin6, sizeof(sin6)) < 0)
+				goto bad;
+		} else
+			goto inval;
+	}
+	free(list);
+	if (sp->sp_n == 0) {
+		free(sp);
+		errno = EINVAL;
+		return(NULL);
+	}
+	return(sp);
+
+inval:
+	errno = EINVAL;
+bad:
+	free(list);
+	free(sp->sp_addr);
+	free(sp);
+	return(NULL);
+}
+
+void
+tcp_srcpool_free(struct tcp_srcpool *sp)
+{
+	free(sp->sp_addr);
+	free(sp);
+}
+
+/*
+ * Bind sockfd to the next address of its family in the pool, round
+ * robin, leaving the port for connect() to choose where possible.
+ */
+int
+tcp_srcpool_bind(int sockfd, int family, struct tcp_srcpool *sp)
+{
+	int						i;
+	socklen_t				len;
+	struct sockaddr_storage	*ss;
+#ifdef	IP_BIND_ADDRESS_NO_PORT
+	const int				on = 1;
+#endif
+
+	ss = NULL;
+	for (i = 0; i < sp->sp_n; i++) {
+		ss = &sp->sp_addr[sp->sp_next++ % sp->sp_n];
+		if (ss->ss_family == family)
+			break;
+	}
+	if (i == sp->sp_n) {
+		errno = EAFNOSUPPORT;		/* none of this family */
+		return(-1);
+	}
+
+#ifdef	IP_BIND_ADDRESS_NO_PORT
+	setsockopt(sockfd, IPPROTO_IP, IP_BIND_ADDRESS_NO_PORT, &on, sizeof(on));
+#endif
+	len = (family == AF_INET) ? sizeof(struct sockaddr_in) :
+								sizeof(struct sockaddr_in6);
+	if (bind(sockfd, (SA *) ss, len) < 0) {
+		if (errno == EADDRINUSE)
+			sp->sp_nexhaust++;		/* no port left on this address */
+		return(-1);
+	}
+	return(0);
+}
+
+struct tcp_srcpool *
+Tcp_srcpool_alloc(const char *spec)
+{
+	struct tcp_srcpool	*sp;
+
+	if ( (sp = tcp_srcpool_alloc(spec)) == NULL)
+		err_sys("tcp_srcpool_alloc error for %s", spec);
+	return(sp);
+}
@@ -0,0 +1,220 @@
+/*
+ * Kernel timestamps for sent and received packets.
+ *
+ * Stamping a packet with gettimeofday() in user space includes the
+ * scheduling and system call latency on both ends of every measurement.
+ * Linux can record the time a packet left the stack (SO_TIMESTAMPING,
+ * reported on the socket's error queue) and the time it arrived
+ * (SO_TIMESTAMPING or SO_TIMESTAMPNS, reported as ancillary data with
+ * the packet itself).  Other systems at least provide SO_TIMESTAMP, a
+ * microsecond receive timestamp.  All times are CLOCK_REALTIME.
+ */
+
+#include	"unp.h"
+
+#ifdef	SO_TIMESTAMPING
+#include	<linux/net_tstamp.h>
+#include	<linux/errqueue.h>
+/* The SOF_xxx flags are an enum, so test for a macro from the same era
+   (Linux 4.14) to see whether OPT_ID and OPT_TSONLY are declared. */
+#ifdef	SO_EE_ORIGIN_ZEROCOPY
+#define	TSTAMP_HAVE_TX	1
+#endif
+#endif
+
+/*
+ * Enable whichever of TSTAMP_RX and TSTAMP_TX the system supports and
+ * return the flags actually enabled.  It is OK if nothing is supported;
+ * the caller then falls back to tstamp_now().  Transmit timestamps are
+ * numbered 0, 1, 2, ... in the order the socket sends packets.
+ */
+int
+tstamp_enable(int fd, int flags)
+{
+	int		on;
+
+#ifdef	TSTAMP_HAVE_TX
+	if (flags & TSTAMP_TX) {
+		on = SOF_TIMESTAMPING_SOFTWARE | SOF_TIMESTAMPING_TX_SOFTWARE |
+			 SOF_TIMESTAMPING_OPT_ID | SOF_TIMESTAMPING_OPT_TSONLY;
+		if (flags & TSTAMP_RX)
+			on |= SOF_TIMESTAMPING_RX_SOFTWARE;
+		if (setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPING, &on, sizeof(on)) == 0)
+			return(flags & (TSTAMP_RX | TSTAMP_TX));
+		/* older kernel; try for receive timestamps alone */
+	}
+#endif
+
+	if ((flags & TSTAMP_RX) == 0)
+		return(0);
+	on = 1;
+#ifdef	SO_TIMESTAMPNS
+	if (setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on)) == 0)
+		return(TSTAMP_RX);
+#endif
+#ifdef	SO_TIMESTAMP
+	if (setsockopt(fd, SOL_SOCKET, SO_TIMESTAMP, &on, sizeof(on)) == 0)
+		return(TSTAMP_RX);
+#endif
+	return(0);
+}
+
+/*
+ * Look through the ancillary data returned by recvmsg() for a receive
+ * timestamp.  Return 1 and fill in *ts if found, else return 0.
+ */
+int
+tstamp_recv(struct msghdr *msg, struct timespec *ts)
+{
+	struct cmsghdr	*cmptr;
+
+	if (msg->msg_controllen < sizeof(struct cmsghdr))
+		return(0);			/* no ancillary data, or truncated */
+
+	for (cmptr = CMSG_FIRSTHDR(msg); cmptr != NULL;
+		 cmptr = CMSG_NXTHDR(msg, cmptr)) {
+		if (cmptr->cmsg_level != SOL_SOCKET)
+			continue;
+
+#ifdef	SO_TIMESTAMPING
+		if (cmptr->cmsg_type == SCM_TIMESTAMPING) {
+			struct scm_timestamping	tss;
+
+			memcpy(&tss, CMSG_DATA(cmptr), sizeof(tss));
+			if (tss.ts[0].tv_sec == 0 && tss.ts[0].tv_nsec == 0)
+				continue;	/* only a hardware timestamp */
+			*ts = tss.ts[0];
+			return(1);
+		}
+#endif
+#ifdef	SO_TIMESTAMPNS
+		if (cmptr->cmsg_type == SCM_TIMESTAMPNS) {
+			memcpy(ts, CMSG_DATA(cmptr), sizeof(struct timespec));
+			return(1);
+		}
+#endif
+#ifdef	SO_TIMESTAMP
+		if (cmptr->cmsg_type == SCM_TIMESTAMP) {
+			struct timeval	tv;
+
+			memcpy(&tv, CMSG_DATA(cmptr), sizeof(tv));
+			ts->tv_sec = tv.tv_sec;
+			ts->tv_nsec = tv.tv_usec * 1000;
+			return(1);
+		}
+#endif
+	}
+	return(0);
+}
+
+/*
+ * Read one transmit timestamp from the socket's error queue without
+ * blocking.  Return 1 with *idp and *ts filled in, 0 if the queue holds
+ * no more timestamps, or -1 on error.
+ */
+int
+tstamp_txreap(int fd, uint32_t *idp, struct timespec *ts)
+{
+#ifdef	TSTAMP_HAVE_TX
+	int						found;
+	ssize_t					n;
+	char					buf[1];
+	struct msghdr			msg;
+	struct iovec			iov;
+	struct cmsghdr			*cmptr;
+	struct sock_extended_err	ee;
+	struct scm_timestamping	tss;
+	union {
+	  struct cmsghdr	cm;
+	  char				control[CMSG_SPACE(sizeof(struct scm_timestamping)) +
+								CMSG_SPACE(sizeof(struct sock_extended_err) +
+										   sizeof(struct sockaddr_storage))];
+	} control_un;
+
+	for ( ; ; ) {
+		iov.iov_base = buf;
+		iov.iov_len = sizeof(buf);
+		bzero(&msg, sizeof(msg));
+		msg.msg_iov = &iov;
+		msg.msg_iovlen = 1;
+		msg.msg_control = control_un.control;
+		msg.msg_controllen = sizeof(control_un.control);
+
+		if ( (n = recvmsg(fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT)) < 0) {
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				return(0);	/* error queue is empty */
+			if (errno == EINTR)
+				continue;
+			return(-1);
+		}
+
+		found = 0;
+		for (cmptr = CMSG_FIRSTHDR(&msg); cmptr != NULL;
+			 cmptr = CMSG_NXTHDR(&msg, cmptr)) {
+			if (cmptr->cmsg_level == SOL_SOCKET &&
+				cmptr->cmsg_type == SCM_TIMESTAMPING) {
+				memcpy(&tss, CMSG_DATA(cmptr), sizeof(tss));
+				found |= 1;
+			} else if ((cmptr->cmsg_level == IPPROTO_IP &&
+						cmptr->cmsg_type == IP_RECVERR)
+#ifdef	IPV6
+					|| (cmptr->cmsg_level == IPPROTO_IPV6 &&
+						cmptr->cmsg_type == IPV6_RECVERR)
+#endif
+					) {
+				memcpy(&ee, CMSG_DATA(cmptr), sizeof(ee));
+				if (ee.ee_errno == ENOMSG &&
+					ee.ee_origin == SO_EE_ORIGIN_TIMESTAMPING)
+					found |= 2;
+			}
+		}
+		if (found == 3) {
+			*idp = ee.ee_data;
+			*ts = tss.ts[0];
+			return(1);
+		}
+		/* something else on the error queue, e.g. an ICMP error; skip it */
+	}
+#else
+	return(0);
+#endif
+}
+
+/*
+ * The user-space fallback: the current time on the same clock that the
+ * kernel timestamps use.
+ */
+void
+tstamp_now(struct timespec *ts)
+{
+#ifdef	CLOCK_REALTIME
+	if (clock_gettime(CLOCK_REALTIME, ts) == -1)
+		err_sys("clock_gettime error");
+#else
+	struct timeval	tv;
+
+	Gettimeofday(&tv, NULL);
+	ts->tv_sec = tv.tv_sec;
+	ts->tv_nsec = tv.tv_usec * 1000;
+#endif
+}
+
+/*
+ * Return end - start, in milliseconds.
+ */
+double
+tstamp_msec(const struct timespec *end, const struct timespec *start)
+{
+	return((end->tv_sec - start->tv_sec) * 1000.0 +
+		   (end->tv_nsec - start->tv_nsec) / 1000000.0);
+}
+
+int
+Tstamp_txreap(int fd, uint32_t *idp, struct timespec *ts)
+{
+	int		n;
+
+	if ( (n = tstamp_txreap(fd, idp, ts)) < 0)
+		err_sys("tstamp_txreap error");
+	return(n);
+}
@@ -195,6 +195,42 @@ struct unp_in_pktinfo {
 /* Miscellaneous constants */
 #define	MAXLINE		4096	/* max text line length */
 #define	BUFFSIZE	8192	/* buffer size for reads and writes */
+#define	MAXFDPASS	32		/* max descriptors per read_fds() or write_fds() */
+
+/* Flags for tstamp_enable() */
+#define	TSTAMP_RX	0x01	/* kernel receive timestamps, as ancillary data */
+#define	TSTAMP_TX	0x02	/* kernel transmit timestamps, on the error queue */
+
+/* MSG_ZEROCOPY sends on one socket, for writen_zc() and zc_reap() */
+struct zcstate {
+  uint32_t	zc_sent;		/* # send() calls made with MSG_ZEROCOPY */
+  uint32_t	zc_done;		/* # of those the kernel is finished with */
+  uint32_t	zc_copied;		/* # of those it copied after all */
+};
+
+/* Options for tcp_listen_opt(), tcp_accept() and tcp_connect_opt();
+   a member left 0 (or NULL) means what tcp_listen() and tcp_connect() do */
+struct tcp_opts {
+  int		 to_backlog;		/* listen() backlog; 0 = LISTENQ */
+  int		 to_reuseport;		/* SO_REUSEPORT on the listening socket */
+  int		 to_deferaccept;	/* TCP_DEFER_ACCEPT, seconds to wait for data */
+  int		 to_fastopen;		/* TCP Fast Open: listen: max # pending;
+								   connect: nonzero to use it */
+  int		 to_sockflags;		/* SOCK_NONBLOCK, SOCK_CLOEXEC for socket() */
+  int		 to_acceptflags;	/* SOCK_NONBLOCK, SOCK_CLOEXEC for accept4() */
+  const void *to_data;			/* connect: first data to send, in the SYN */
+  size_t	 to_datalen;		/*   if to_fastopen; not with SOCK_NONBLOCK */
+  struct tcp_srcpool *to_srcpool;	/* connect: local addresses to bind */
+};
+
+/* Local addresses for tcp_connect_opt() to use in turn: tcp_srcpool.c */
+struct tcp_srcpool {
+  struct sockaddr_storage *sp_addr;
+  int		 sp_n, sp_max;		/* # in sp_addr[], # allocated */
+  unsigned	 sp_next;			/* the next one to bind, mod sp_n */
+  long		 sp_nconnect;		/* # connections made from the pool */
+  long		 sp_nexhaust;		/* # times an address was out of ports */
+};
 
 /* Define some port number that can be used for our examples */
 #define	SERV_PORT		 9877			/* TCP and UDP */
@@ -286,11 +322,14 @@ int		 inet_srcrt_add(char *);
 u_char  *inet_srcrt_init(int);
 void	 inet_srcrt_print(u_char *, int);
 void	 inet6_srcrt_print(void *);
+void	*mirror_alloc(size_t);
+void	 mirror_free(void *, size_t);
 char   **my_addrs(int *);
 int		 readable_timeo(int, int);
 ssize_t	 readline(int, void *, size_t);
 ssize_t	 readn(int, void *, size_t);
 ssize_t	 read_fd(int, void *, size_t, int *);
+ssize_t	 read_fds(int, void *, size_t, int *, int *);
 ssize_t	 recvfrom_flags(int, void *, size_t, int *, SA *, socklen_t *,
 		 struct unp_in_pktinfo *);
 Sigfunc *signal_intr(int, Sigfunc *);
@@ -306,15 +345,33 @@ char	*sock_ntop_host(const SA *, socklen_t);
 int		 sockfd_to_family(int);
 void	 str_echo(int);
 void	 str_cli(FILE *, int);
+int		 tcp_accept(int, SA *, socklen_t *, const struct tcp_opts *);
 int		 tcp_connect(const char *, const char *);
+int		 tcp_connect_opt(const char *, const char *, const struct tcp_opts *);
+int		 tcp_cork(int, int);
 int		 tcp_listen(const char *, const char *, socklen_t *);
+int		 tcp_listen_opt(const char *, const char *, socklen_t *,
+						const struct tcp_opts *);
+struct tcp_srcpool *tcp_srcpool_alloc(const char *);
+int		 tcp_srcpool_bind(int, int, struct tcp_srcpool *);
+void	 tcp_srcpool_free(struct tcp_srcpool *);
+int		 tstamp_enable(int, int);
+double	 tstamp_msec(const struct timespec *, const struct timespec *);
+void	 tstamp_now(struct timespec *);
+int		 tstamp_recv(struct msghdr *, struct timespec *);
+int		 tstamp_txreap(int, uint32_t *, struct timespec *);
 void	 tv_sub(struct timeval *, struct timeval *);
 int		 udp_client(const char *, const char *, SA **, socklen_t *);
 int		 udp_connect(const char *, const char *);
 int		 udp_server(const char *, const char *, socklen_t *);
 int		 writable_timeo(int, int);
 ssize_t	 writen(int, const void *, size_t);
+ssize_t	 writen_more(int, const void *, size_t, int);
+ssize_t	 writen_zc(int, const void *, size_t, struct zcstate *);
 ssize_t	 write_fd(int, void *, size_t, int);
+ssize_t	 write_fds(int, void *, size_t, const int *, int);
+int		 zc_enable(int);
+int		 zc_reap(int, struct zcstate *, int);
 
 #ifdef	MCAST
 int		 mcast_leave(int, const SA *, socklen_t);
@@ -415,6 +472,7 @@ unsigned int		 If_nametoindex(const char *);
 struct if_nameindex	*If_nameindex(void);
 char   **My_addrs(int *);
 ssize_t	 Read_fd(int, void *, size_t, int *);
+ssize_t	 Read_fds(int, void *, size_t, int *, int *);
 int		 Readable_timeo(int, int);
 ssize_t	 Recvfrom_flags(int, void *, size_t, int *, SA *, socklen_t *,
 		 struct unp_in_pktinfo *);
@@ -424,12 +482,20 @@ int		 Sock_bind_wild(int, int);
 char	*Sock_ntop(const SA *, socklen_t);
 char	*Sock_ntop_host(const SA *, socklen_t);
 int		 Sockfd_to_family(int);
+int		 Tcp_accept(int, SA *, socklen_t *, const struct tcp_opts *);
 int		 Tcp_connect(const char *, const char *);
+int		 Tcp_connect_opt(const char *, const char *, const struct tcp_opts *);
+void	 Tcp_cork(int, int);
 int		 Tcp_listen(const char *, const char *, socklen_t *);
+int		 Tcp_listen_opt(const char *, const char *, socklen_t *,
+						const struct tcp_opts *);
+struct tcp_srcpool *Tcp_srcpool_alloc(const char *);
+int		 Tstamp_txreap(int, uint32_t *, struct timespec *);
 int		 Udp_client(const char *, const char *, SA **, socklen_t *);
 int		 Udp_connect(const char *, const char *);
 int		 Udp_server(const char *, const char *, socklen_t *);
 ssize_t	 Write_fd(int, void *, size_t, int);
+ssize_t	 Write_fds(int, void *, size_t, const int *, int);
 int		 Writable_timeo(int, int);
 
 			/* prototypes for our Unix wrapper functions: see {Sec errors} */
@@ -507,6 +573,9 @@ int		 Sockatmark(int);
 int		 Socket(int, int, int);
 void	 Socketpair(int, int, int, int *);
 void	 Writen(int, void *, size_t);
+void	 Writen_more(int, void *, size_t, int);
+void	 Writen_zc(int, void *, size_t, struct zcstate *);
+void	 Zc_reap(int, struct zcstate *, int);
 
 void	 err_dump(const char *, ...);
 void	 err_msg(const char *, ...);
@@ -0,0 +1,77 @@
+#ifndef	__unp_bufev_h
+#define	__unp_bufev_h
+
+#include	"unp.h"
+
+/*
+ * A nonblocking descriptor with an input and an output buffer, for
+ * programs that drive many descriptors from one poll() loop.  The
+ * program puts bufev_events() in its pollfd and hands the revents back to
+ * bufev_handle(), which does the read() or write() and calls back:
+ *
+ *	readcb		new data is in the input buffer
+ *	writecb		the output buffer has drained to the low watermark
+ *	eventcb		BEV_EOF, once the input buffer has also been emptied,
+ *				or BEV_ERROR, with the errno in be_errno
+ *
+ * Both buffers are rings that grow as needed.  Where mirror_alloc() works
+ * the ring's pages are mapped twice, back to back, so the data or free
+ * space is always one span for a read() or write(); elsewhere a ring that
+ * wraps is two spans, passed to readv() or writev().
+ * Reading stops while the input buffer holds be_rhigh bytes, and
+ * bufev_move() stops adding to an output buffer at be_whigh, so a fast
+ * sender is held back by a slow receiver instead of using more memory.
+ */
+
+struct bufring {
+  char		*br_buf;
+  size_t	 br_size;		/* a power of 2 */
+  size_t	 br_head;		/* data is [br_head, br_tail), mod br_size */
+  size_t	 br_tail;
+  int		 br_mirror;		/* br_buf from mirror_alloc() */
+};
+
+struct bufev {
+  int			be_fd;
+  int			be_flags;		/* BEV_xxx */
+  int			be_errno;		/* for BEV_ERROR */
+  struct bufring be_in, be_out;
+  size_t		be_rhigh;		/* stop reading at this much input */
+  size_t		be_wlow;		/* writecb when output drains to this */
+  size_t		be_whigh;		/* bufev_move() fills output to this */
+  void		  (*be_readcb)(struct bufev *, void *);
+  void		  (*be_writecb)(struct bufev *, void *);
+  void		  (*be_eventcb)(struct bufev *, int, void *);
+  void		   *be_arg;
+};
+
+#define	BEV_READ		0x01	/* reading enabled */
+#define	BEV_EOF			0x02	/* read() returned 0 */
+#define	BEV_ERROR		0x04	/* read() or write() failed */
+#define	BEV_EOFDONE		0x08	/* eventcb has been told of the EOF */
+#define	BEV_SHUTWR		0x10	/* shutdown() once the output drains */
+#define	BEV_WDONE		0x20	/* and it has */
+
+#define	BEV_BUFSIZE		4096	/* initial size of each ring */
+#define	BEV_HIGHWAT		65536	/* default be_rhigh and be_whigh */
+
+				/* function prototypes */
+void		 bufev_disable(struct bufev *, int);
+int			 bufev_done(struct bufev *);
+void		 bufev_enable(struct bufev *, int);
+short		 bufev_events(struct bufev *);
+void		 bufev_free(struct bufev *);
+void		 bufev_handle(struct bufev *, short);
+size_t		 bufev_inlen(struct bufev *);
+size_t		 bufev_move(struct bufev *, struct bufev *);
+struct bufev *bufev_new(int);
+size_t		 bufev_outlen(struct bufev *);
+size_t		 bufev_read(struct bufev *, void *, size_t);
+void		 bufev_setcb(struct bufev *, void (*)(struct bufev *, void *),
+						 void (*)(struct bufev *, void *),
+						 void (*)(struct bufev *, int, void *), void *);
+void		 bufev_setwatermark(struct bufev *, size_t, size_t, size_t);
+void		 bufev_shutdown(struct bufev *);
+void		 bufev_write(struct bufev *, const void *, size_t);
+
+#endif	/* __unp_bufev_h */
@@ -30,5 +30,6 @@ struct ifi_info {
 struct ifi_info	*get_ifi_info(int, int);
 struct ifi_info	*Get_ifi_info(int, int);
 void			 free_ifi_info(struct ifi_info *);
+int				 get_ifi_info_nl(int, int, struct ifi_info **);
 
 #endif	/* __unp_ifi_h */
@@ -22,6 +22,8 @@ void	 rtt_init(struct rtt_info *);
 void	 rtt_newpack(struct rtt_info *);
 int		 rtt_start(struct rtt_info *);
 void	 rtt_stop(struct rtt_info *, uint32_t);
+void	 rtt_stop_ts(struct rtt_info *, const struct timespec *,
+					 const struct timespec *);
 int		 rtt_timeout(struct rtt_info *);
 uint32_t rtt_ts(struct rtt_info *);
 
@@ -49,3 +49,70 @@ Write_fd(int fd, void *ptr, size_t nbytes, int sendfd)
 
 	return(n);
 }
+
+/*
+ * write_fd() for nfds descriptors (at most MAXFDPASS) in one message,
+ * so that handing a batch of connections to another process costs one
+ * sendmsg() rather than one each.
+ */
+/* include write_fds */
+ssize_t
+write_fds(int fd, void *ptr, size_t nbytes, const int *sendfds, int nfds)
+{
+	struct msghdr	msg;
+	struct iovec	iov[1];
+
+#ifdef	HAVE_MSGHDR_MSG_CONTROL
+	union {
+	  struct cmsghdr	cm;
+	  char				control[CMSG_SPACE(MAXFDPASS * sizeof(int))];
+	} control_un;
+	struct cmsghdr	*cmptr;
+#endif
+
+	if (nfds < 0 || nfds > MAXFDPASS) {
+		errno = EINVAL;
+		return(-1);
+	}
+
+#ifdef	HAVE_MSGHDR_MSG_CONTROL
+	if (nfds > 0) {
+		msg.msg_control = control_un.control;
+		msg.msg_controllen = CMSG_SPACE(nfds * sizeof(int));
+
+		cmptr = CMSG_FIRSTHDR(&msg);
+		cmptr->cmsg_len = CMSG_LEN(nfds * sizeof(int));
+		cmptr->cmsg_level = SOL_SOCKET;
+		cmptr->cmsg_type = SCM_RIGHTS;
+		memcpy(CMSG_DATA(cmptr), sendfds, nfds * sizeof(int));
+	} else {
+		msg.msg_control = NULL;
+		msg.msg_controllen = 0;
+	}
+#else
+	msg.msg_accrights = (caddr_t) sendfds;
+	msg.msg_accrightslen = nfds * sizeof(int);
+#endif
+
+	msg.msg_name = NULL;
+	msg.msg_namelen = 0;
+
+	iov[0].iov_base = ptr;
+	iov[0].iov_len = nbytes;
+	msg.msg_iov = iov;
+	msg.msg_iovlen = 1;
+
+	return(sendmsg(fd, &msg, 0));
+}
+/* end write_fds */
+
+ssize_t
+Write_fds(int fd, void *ptr, size_t nbytes, const int *sendfds, int nfds)
+{
+	ssize_t		n;
+
+	if ( (n = write_fds(fd, ptr, nbytes, sendfds, nfds)) < 0)
+		err_sys("write_fds error");
+
+	return(n);
+}
@@ -0,0 +1,73 @@
+/*
+ * Coalescing small writes into full segments.
+ *
+ * With Nagle off, every write() of a few bytes becomes its own segment.
+ * Writing all but the last piece of a message with MSG_MORE, or corking
+ * the socket around the pieces, has TCP hold the data until the message
+ * is complete (or 200 ms pass) and then send full-sized segments.
+ */
+
+#include	"unp.h"
+#include	<netinet/tcp.h>		/* TCP_CORK */
+
+/* include writen_more */
+ssize_t						/* Write "n" bytes to a descriptor. */
+writen_more(int fd, const void *vptr, size_t n, int more)
+{
+	size_t		nleft;
+	ssize_t		nwritten;
+	const char	*ptr;
+	int			flags;
+
+#ifdef	MSG_MORE
+	flags = more ? MSG_MORE : 0;	/* more to come after this write */
+#else
+	flags = 0;
+#endif
+	ptr = vptr;
+	nleft = n;
+	while (nleft > 0) {
+		if ( (nwritten = send(fd, ptr, nleft, flags)) <= 0) {
+			if (nwritten < 0 && errno == EINTR)
+				nwritten = 0;		/* and call send() again */
+			else
+				return(-1);			/* error */
+		}
+
+		nleft -= nwritten;
+		ptr   += nwritten;
+	}
+	return(n);
+}
+/* end writen_more */
+
+/*
+ * Cork (on = 1) or uncork (on = 0) a TCP socket.  Uncorking sends
+ * whatever has been held back.  TCP_NOPUSH is the BSD equivalent.
+ */
+int
+tcp_cork(int fd, int on)
+{
+#if	defined(TCP_CORK)
+	return(setsockopt(fd, IPPROTO_TCP, TCP_CORK, &on, sizeof(on)));
+#elif	defined(TCP_NOPUSH)
+	return(setsockopt(fd, IPPROTO_TCP, TCP_NOPUSH, &on, sizeof(on)));
+#else
+	errno = ENOPROTOOPT;
+	return(-1);
+#endif
+}
+
+void
+Writen_more(int fd, void *ptr, size_t nbytes, int more)
+{
+	if (writen_more(fd, ptr, nbytes, more) != nbytes)
+		err_sys("writen_more error");
+}
+
+void
+Tcp_cork(int fd, int on)
+{
+	if (tcp_cork(fd, on) < 0)
+		err_sys("tcp_cork error");
+}
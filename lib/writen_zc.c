@@ -0,0 +1,151 @@
+/*
+ * writen() with MSG_ZEROCOPY.
+ *
+ * A zerocopy send pins the caller's pages and hands them to the device
+ * instead of copying them into the kernel, so the caller must not
+ * modify the buffer until the kernel reports, on the socket's error
+ * queue, that it is finished with it.  Linux numbers the zerocopy send()
+ * calls on a socket 0, 1, 2, ...; each notification covers a range of
+ * them.  The copy this saves only outweighs the page pinning and the
+ * notifications for large writes, tens of kilobytes or more, and the
+ * kernel copies anyway when the route is loopback.
+ */
+
+#include	"unp.h"
+
+#if	defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
+#include	<linux/errqueue.h>
+#define	ZC_HAVE		1
+#endif
+
+/*
+ * Return 0 if the socket can now use writen_zc(), else -1.
+ */
+int
+zc_enable(int fd)
+{
+#ifdef	ZC_HAVE
+	int		on = 1;
+
+	return(setsockopt(fd, SOL_SOCKET, SO_ZEROCOPY, &on, sizeof(on)));
+#else
+	errno = ENOPROTOOPT;
+	return(-1);
+#endif
+}
+
+/*
+ * Read the completion notifications waiting on the error queue into *zs.
+ * If "block" is nonzero, wait until every send is complete, after which
+ * all the buffers passed to writen_zc() may be reused.  Return 0, or -1
+ * on error.
+ */
+int
+zc_reap(int fd, struct zcstate *zs, int block)
+{
+#ifdef	ZC_HAVE
+	uint32_t				n;
+	struct msghdr			msg;
+	struct cmsghdr			*cmptr;
+	struct sock_extended_err	ee;
+	struct pollfd			pfd;
+	union {
+	  struct cmsghdr	cm;
+	  char				control[CMSG_SPACE(sizeof(struct sock_extended_err) +
+										   sizeof(struct sockaddr_storage))];
+	} control_un;
+
+	while (zs->zc_done != zs->zc_sent) {
+		bzero(&msg, sizeof(msg));
+		msg.msg_control = control_un.control;
+		msg.msg_controllen = sizeof(control_un.control);
+
+		if (recvmsg(fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+			if (errno == EINTR)
+				continue;
+			if (errno != EAGAIN && errno != EWOULDBLOCK)
+				return(-1);
+			if (block == 0)
+				return(0);		/* nothing more yet */
+
+			pfd.fd = fd;
+			pfd.events = 0;		/* POLLERR is always reported */
+			if (poll(&pfd, 1, INFTIM) < 0 && errno != EINTR)
+				return(-1);
+			continue;
+		}
+
+		for (cmptr = CMSG_FIRSTHDR(&msg); cmptr != NULL;
+			 cmptr = CMSG_NXTHDR(&msg, cmptr)) {
+			if (!(cmptr->cmsg_level == IPPROTO_IP &&
+				  cmptr->cmsg_type == IP_RECVERR)
+#ifdef	IPV6
+				&& !(cmptr->cmsg_level == IPPROTO_IPV6 &&
+					 cmptr->cmsg_type == IPV6_RECVERR)
+#endif
+				)
+				continue;
+			memcpy(&ee, CMSG_DATA(cmptr), sizeof(ee));
+			if (ee.ee_origin != SO_EE_ORIGIN_ZEROCOPY || ee.ee_errno != 0)
+				continue;		/* something else, e.g. an ICMP error */
+
+			n = ee.ee_data - ee.ee_info + 1;	/* sends [ee_info, ee_data] */
+			zs->zc_done += n;
+			if (ee.ee_code & SO_EE_CODE_ZEROCOPY_COPIED)
+				zs->zc_copied += n;
+		}
+	}
+#endif
+	return(0);
+}
+
+/* include writen_zc */
+ssize_t						/* Write "n" bytes to a descriptor. */
+writen_zc(int fd, const void *vptr, size_t n, struct zcstate *zs)
+{
+	size_t		nleft;
+	ssize_t		nwritten;
+	const char	*ptr;
+
+#ifdef	ZC_HAVE
+	ptr = vptr;
+	nleft = n;
+	while (nleft > 0) {
+		if ( (nwritten = send(fd, ptr, nleft, MSG_ZEROCOPY)) <= 0) {
+			if (nwritten < 0 && errno == EINTR)
+				nwritten = 0;		/* and call send() again */
+			else if (nwritten < 0 && errno == ENOBUFS) {
+					/* too many pages pinned; wait for the kernel */
+				if (zc_reap(fd, zs, 1) < 0)
+					return(-1);
+				nwritten = 0;
+			} else
+				return(-1);			/* error */
+		} else
+			zs->zc_sent++;
+
+		nleft -= nwritten;
+		ptr   += nwritten;
+	}
+	if (zc_reap(fd, zs, 0) < 0)		/* keep the error queue short */
+		return(-1);
+	return(n);
+#else
+	return(writen(fd, vptr, n));
+#endif
+}
+/* end writen_zc */
+
+void
+Writen_zc(int fd, void *ptr, size_t nbytes, struct zcstate *zs)
+{
+	if (writen_zc(fd, ptr, nbytes, zs) != nbytes)
+		err_sys("writen_zc error");
+}
+
+void
+Zc_reap(int fd, struct zcstate *zs, int block)
+{
+	if (zc_reap(fd, zs, block) < 0)
+		err_sys("zc_reap error");
+}
@@ -1,20 +1,24 @@
 #include	"gai_hdr.h"
 
+/*
+ * Everything in the list, the socket address structures and the
+ * canonical name included, is in the arena that getaddrinfo() built it
+ * in.  "aihead" need not be the head of that list: a caller may free
+ * any sublist, and the arena is freed with the last of its addrinfo{}s.
+ */
+
 /* include freeaddrinfo */
 void
 freeaddrinfo(struct addrinfo *aihead)
 {
 	struct addrinfo	*ai, *ainext;
+	struct ga_arena	*arena;
 
 	for (ai = aihead; ai != NULL; ai = ainext) {
-		if (ai->ai_addr != NULL)
-			free(ai->ai_addr);		/* socket address structure */
-
-		if (ai->ai_canonname != NULL)
-			free(ai->ai_canonname);
-
 		ainext = ai->ai_next;	/* can't fetch ai_next after free() */
-		free(ai);				/* the addrinfo{} itself */
+		arena = ga_arena(ai);
+		if (--arena->ar_nai == 0)
+			ga_free(arena);		/* every chunk, usually just one */
 	}
 }
 /* end freeaddrinfo */
@@ -1,17 +1,40 @@
 #include	"gai_hdr.h"
 
 /*
- * Create and fill in an addrinfo{}.
+ * Create and fill in an addrinfo{}, and its socket address structure
+ * right after it, in the result's arena.
  */
 
 /* include ga_aistruct1 */
 int
-ga_aistruct(struct addrinfo ***paipnext, const struct addrinfo *hintsp,
-			const void *addr, int family)
+ga_aistruct(struct ga_arena **arenap, struct addrinfo ***paipnext,
+			const struct addrinfo *hintsp, const void *addr, int family)
 {
 	struct addrinfo	*ai;
+	socklen_t		salen;
 
-	if ( (ai = calloc(1, sizeof(struct addrinfo))) == NULL)
+	switch (family) {
+#ifdef	IPv4
+	case AF_INET:
+		salen = sizeof(struct sockaddr_in);
+		break;
+#endif
+#ifdef	IPv6
+	case AF_INET6:
+		salen = sizeof(struct sockaddr_in6);
+		break;
+#endif
+#ifdef	UNIXdomain
+	case AF_LOCAL:
+		if (strlen(addr) >= sizeof(((struct sockaddr_un *) 0)->sun_path))
+			return(EAI_SERVICE);
+		salen = sizeof(struct sockaddr_un);
+		break;
+#endif
+	default:
+		return(EAI_FAMILY);
+	}
+	if ( (ai = ga_aialloc(arenap, salen)) == NULL)
 		return(EAI_MEMORY);
 	ai->ai_next = NULL;
 	ai->ai_canonname = NULL;
@@ -30,9 +53,8 @@ ga_aistruct(struct addrinfo ***paipnext, const struct addrinfo *hintsp,
 		case AF_INET: {
 			struct sockaddr_in	*sinptr;
 
-				/* 4allocate sockaddr_in{} and fill in all but port */
-			if ( (sinptr = calloc(1, sizeof(struct sockaddr_in))) == NULL)
-				return(EAI_MEMORY);
+				/* 4fill in sockaddr_in{}, all but port */
+			sinptr = (struct sockaddr_in *) (ai + 1);
 #ifdef	HAVE_SOCKADDR_SA_LEN
 			sinptr->sin_len = sizeof(struct sockaddr_in);
 #endif
@@ -47,9 +69,8 @@ ga_aistruct(struct addrinfo ***paipnext, const struct addrinfo *hintsp,
 		case AF_INET6: {
 			struct sockaddr_in6	*sin6ptr;
 
-				/* 4allocate sockaddr_in6{} and fill in all but port */
-			if ( (sin6ptr = calloc(1, sizeof(struct sockaddr_in6))) == NULL)
-				return(EAI_MEMORY);
+				/* 4fill in sockaddr_in6{}, all but port */
+			sin6ptr = (struct sockaddr_in6 *) (ai + 1);
 #ifdef	HAVE_SOCKADDR_SA_LEN
 			sin6ptr->sin6_len = sizeof(struct sockaddr_in6);
 #endif
@@ -64,13 +85,8 @@ ga_aistruct(struct addrinfo ***paipnext, const struct addrinfo *hintsp,
 		case AF_LOCAL: {
 			struct sockaddr_un	*unp;
 
-				/* 4allocate sockaddr_un{} and fill in */
-/* *INDENT-OFF* */
-			if (strlen(addr) >= sizeof(unp->sun_path))
-				return(EAI_SERVICE);
-			if ( (unp = calloc(1, sizeof(struct sockaddr_un))) == NULL)
-				return(EAI_MEMORY);
-/* *INDENT-ON* */
+				/* 4fill in sockaddr_un{} */
+			unp = (struct sockaddr_un *) (ai + 1);
 			unp->sun_family = AF_LOCAL;
 			strcpy(unp->sun_path, addr);
 #ifdef	HAVE_SOCKADDR_SA_LEN
@@ -0,0 +1,99 @@
+#include	"gai_hdr.h"
+
+/*
+ * All the memory for one getaddrinfo() result, the addrinfo{}s, their
+ * socket address structures and the canonical name, comes from one
+ * arena, so a typical result costs one malloc() and freeaddrinfo()
+ * one free().  The arena is a chain of chunks, each starting with a
+ * ga_arena{} header.  Each addrinfo{} is preceded by a pointer to the
+ * first chunk, which is how freeaddrinfo() finds the arena from any
+ * node: the caller may free a sublist, starting at any ai_next.  The
+ * first chunk counts the addrinfo{}s not yet freed, and the arena goes
+ * when the last of them does.
+ */
+
+#define	GA_ALIGN(n)	(((n) + sizeof(double) - 1) & ~(sizeof(double) - 1))
+#define	GA_HDRLEN	GA_ALIGN(sizeof(struct ga_arena))
+#define	GA_PTRLEN	GA_ALIGN(sizeof(struct ga_arena *))
+#define	GA_CHUNK	512		/* first chunk: a few addresses, two socket types */
+
+/* include ga_alloc */
+void *
+ga_alloc(struct ga_arena **arenap, size_t n)
+{
+	size_t			size;
+	char			*ptr;
+	struct ga_arena	*first, *cur, *new;
+
+	n = GA_ALIGN(n);
+	if ( (first = *arenap) != NULL) {
+		cur = first->ar_last;
+		if (cur->ar_used + n <= cur->ar_size) {
+			ptr = (char *) cur + GA_HDRLEN + cur->ar_used;
+			cur->ar_used += n;
+			return(ptr);		/* calloc'ed when the chunk was */
+		}
+		size = 2 * cur->ar_size;
+	} else
+		size = GA_CHUNK;
+	if (size < n)
+		size = n;
+
+		/* 4new chunk, chained after the last */
+	if ( (new = calloc(1, GA_HDRLEN + size)) == NULL)
+		return(NULL);
+	new->ar_next = NULL;
+	new->ar_size = size;
+	new->ar_used = n;
+	if (first == NULL) {
+		*arenap = new;
+		new->ar_last = new;
+	} else {
+		first->ar_last->ar_next = new;
+		first->ar_last = new;
+	}
+	return((char *) new + GA_HDRLEN);
+}
+/* end ga_alloc */
+
+/* An addrinfo{} with "salen" bytes after it for its socket address. */
+struct addrinfo *
+ga_aialloc(struct ga_arena **arenap, socklen_t salen)
+{
+	char	*ptr;
+
+	if ( (ptr = ga_alloc(arenap, GA_PTRLEN + sizeof(struct addrinfo) + salen))
+		 == NULL)
+		return(NULL);
+	*(struct ga_arena **) ptr = *arenap;	/* the first chunk */
+	(*arenap)->ar_nai++;
+	return((struct addrinfo *) (ptr + GA_PTRLEN));
+}
+
+char *
+ga_strdup(struct ga_arena **arenap, const char *str)
+{
+	char	*ptr;
+
+	if ( (ptr = ga_alloc(arenap, strlen(str) + 1)) != NULL)
+		strcpy(ptr, str);
+	return(ptr);
+}
+
+void
+ga_free(struct ga_arena *arena)
+{
+	struct ga_arena	*next;
+
+	for ( ; arena != NULL; arena = next) {
+		next = arena->ar_next;
+		free(arena);
+	}
+}
+
+/* The arena that "ai" came from. */
+struct ga_arena *
+ga_arena(struct addrinfo *ai)
+{
+	return(*(struct ga_arena **) ((char *) ai - GA_PTRLEN));
+}
@@ -1,16 +1,17 @@
 #include	"gai_hdr.h"
 
 /*
- * Clone a new addrinfo structure from an existing one.
+ * Clone a new addrinfo structure from an existing one, in the same arena,
+ * with its socket address structure right after it.
  */
 
 /* include ga_clone */
 struct addrinfo *
-ga_clone(struct addrinfo *ai)
+ga_clone(struct ga_arena **arenap, struct addrinfo *ai)
 {
 	struct addrinfo	*new;
 
-	if ( (new = calloc(1, sizeof(struct addrinfo))) == NULL)
+	if ( (new = ga_aialloc(arenap, ai->ai_addrlen)) == NULL)
 		return(NULL);
 
 	new->ai_next = ai->ai_next;
@@ -22,8 +23,7 @@ ga_clone(struct addrinfo *ai)
 	new->ai_protocol = ai->ai_protocol;
 	new->ai_canonname = NULL;
 	new->ai_addrlen = ai->ai_addrlen;
-	if ( (new->ai_addr = malloc(ai->ai_addrlen)) == NULL)
-		return(NULL);
+	new->ai_addr = (struct sockaddr *) (new + 1);
 	memcpy(new->ai_addr, ai->ai_addr, ai->ai_addrlen);
 
 	return(new);
@@ -28,7 +28,8 @@
 
 /* include ga_port */
 int
-ga_port(struct addrinfo *aihead, int port, int socktype)
+ga_port(struct ga_arena **arenap, struct addrinfo *aihead, int port,
+		int socktype)
 		/* port must be in network byte order */
 {
 	int				nfound = 0;
@@ -37,7 +38,7 @@ ga_port(struct addrinfo *aihead, int port, int socktype)
 	for (ai = aihead; ai != NULL; ai = ai->ai_next) {
 		if (ai->ai_flags & AI_CLONE) {
 			if (ai->ai_socktype != 0) {
-				if ( (ai = ga_clone(ai)) == NULL)
+				if ( (ai = ga_clone(arenap, ai)) == NULL)
 					return(-1);		/* memory allocation error */
 				/* ai points to newly cloned entry, which is what we want */
 			}
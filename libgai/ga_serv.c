@@ -4,43 +4,60 @@
  * This function handles the service string.
  */
 
+/*
+ * Port for a service name and socket type, in network byte order, or -1.
+ * The compiled-in table of well-known services first, then the cached
+ * services file, and only then getservbyname().
+ */
+static int
+ga_getport(const char *serv, int socktype)
+{
+	int				port;
+	struct servent	*sptr;
+
+	if ( (port = ga_svctab(serv, socktype)) >= 0 ||
+		 (port = ga_svcfile(serv, socktype)) >= 0)
+		return(port);
+	sptr = getservbyname(serv, socktype == SOCK_STREAM ? "tcp" : "udp");
+	return(sptr == NULL ? -1 : sptr->s_port);
+}
+
 /* include ga_serv */
 int
-ga_serv(struct addrinfo *aihead, const struct addrinfo *hintsp,
-		const char *serv)
+ga_serv(struct ga_arena **arenap, struct addrinfo *aihead,
+		const struct addrinfo *hintsp, const char *serv)
 {
 	int				port, rc, nfound;
-	struct servent	*sptr;
 
 	nfound = 0;
 	if (isdigit(serv[0])) {		/* check for port number string first */
 		port = htons(atoi(serv));
 		if (hintsp->ai_socktype) {
 				/* 4caller specifies socket type */
-			if ( (rc = ga_port(aihead, port, hintsp->ai_socktype)) < 0)
+			if ( (rc = ga_port(arenap, aihead, port, hintsp->ai_socktype)) < 0)
 				return(EAI_MEMORY);
 			nfound += rc;
 		} else {
 				/* 4caller does not specify socket type */
-			if ( (rc = ga_port(aihead, port, SOCK_STREAM)) < 0)
+			if ( (rc = ga_port(arenap, aihead, port, SOCK_STREAM)) < 0)
 				return(EAI_MEMORY);
 			nfound += rc;
-			if ( (rc = ga_port(aihead, port, SOCK_DGRAM)) < 0)
+			if ( (rc = ga_port(arenap, aihead, port, SOCK_DGRAM)) < 0)
 				return(EAI_MEMORY);
 			nfound += rc;
 		}
 	} else {
 			/* 4try service name, TCP then UDP */
 		if (hintsp->ai_socktype == 0 || hintsp->ai_socktype == SOCK_STREAM) {
-			if ( (sptr = getservbyname(serv, "tcp")) != NULL) {
-				if ( (rc = ga_port(aihead, sptr->s_port, SOCK_STREAM)) < 0)
+			if ( (port = ga_getport(serv, SOCK_STREAM)) >= 0) {
+				if ( (rc = ga_port(arenap, aihead, port, SOCK_STREAM)) < 0)
 					return(EAI_MEMORY);
 				nfound += rc;
 			}
 		}
 		if (hintsp->ai_socktype == 0 || hintsp->ai_socktype == SOCK_DGRAM) {
-			if ( (sptr = getservbyname(serv, "udp")) != NULL) {
-				if ( (rc = ga_port(aihead, sptr->s_port, SOCK_DGRAM)) < 0)
+			if ( (port = ga_getport(serv, SOCK_DGRAM)) >= 0) {
+				if ( (rc = ga_port(arenap, aihead, port, SOCK_DGRAM)) < 0)
 					return(EAI_MEMORY);
 				nfound += rc;
 			}
@@ -49,7 +66,7 @@ ga_serv(struct addrinfo *aihead, const struct addrinfo *hintsp,
 
 	if (nfound == 0) {
 		if (hintsp->ai_socktype == 0)
-			return(EAI_NONAME);	/* all calls to getservbyname() failed */
+			return(EAI_NONAME);	/* all the lookups failed */
 		else
 			return(EAI_SERVICE);/* service not supported for socket type */
 	}
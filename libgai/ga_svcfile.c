@@ -0,0 +1,195 @@
+#include	"gai_hdr.h"
+#include	<sys/mman.h>
+
+/*
+ * A service name that is not in the compiled-in table is looked up in
+ * the system's services file, mapped into memory the first time it is
+ * needed and indexed by an open-addressed hash table of (name,
+ * protocol) pairs that point into the mapping.  After that a lookup is
+ * a hash and a probe or two, where getservbyname() opens and reads
+ * through the whole file on every call.  The mapping and the index
+ * stay for the life of the process, so a change to the file is not
+ * seen until the next one.
+ *
+ * The file is $GAI_SERVICES if set, else /etc/services; setting
+ * GAI_SERVICES to the empty string turns the cache off.  A name not
+ * found here still goes to getservbyname(), which also knows about
+ * services that come from somewhere other than the file.
+ */
+
+/* FNV-1a, with the high bits folded in since the callers use the low. */
+uint32_t
+ga_svchash(const char *name, size_t len, uint32_t seed)
+{
+	uint32_t	h;
+
+	h = 2166136261U ^ seed;
+	while (len-- > 0) {
+		h ^= (unsigned char) *name++;
+		h *= 16777619U;
+	}
+	return(h ^ (h >> 16));
+}
+
+struct svcidx {
+  uint32_t	si_hash;
+  uint32_t	si_off;		/* of the name in the mapping */
+  uint16_t	si_len;		/* of the name, 0 if the slot is empty */
+  uint16_t	si_port;	/* network byte order */
+  int		si_udp;		/* 1 for udp, 0 for tcp */
+};
+
+static const char		*map;		/* the file */
+static size_t			 maplen;
+static struct svcidx	*idx;		/* NULL if there is no cache */
+static uint32_t			 idxmask;
+static long				 nidx;
+
+/* Return the next word before "end" and its length, advancing *pp. */
+static const char *
+nextword(const char **pp, const char *end, size_t *lenp)
+{
+	const char	*ptr, *word;
+
+	for (ptr = *pp; ptr < end && isspace((unsigned char) *ptr); ptr++)
+		;
+	for (word = ptr; ptr < end && !isspace((unsigned char) *ptr); ptr++)
+		;
+	*pp = ptr;
+	*lenp = ptr - word;
+	return(*lenp == 0 ? NULL : word);
+}
+
+static void
+svc_insert(const char *name, size_t len, int port, int udp)
+{
+	uint32_t		h, i;
+	struct svcidx	*si;
+
+	h = ga_svchash(name, len, udp);
+	for (i = h & idxmask; (si = &idx[i])->si_len != 0; i = (i + 1) & idxmask) {
+		if (si->si_hash == h && si->si_udp == udp && si->si_len == len &&
+			memcmp(map + si->si_off, name, len) == 0)
+			return;				/* first one in the file wins */
+	}
+	si->si_hash = h;
+	si->si_off = name - map;
+	si->si_len = len;
+	si->si_port = htons(port);
+	si->si_udp = udp;
+}
+
+/*
+ * Go through the file, counting the names (and aliases) on the tcp and
+ * udp lines into nidx, or if "insert" is nonzero, indexing them.
+ */
+static void
+svc_scan(int insert)
+{
+	int			port, udp;
+	size_t		len, namelen;
+	const char	*ptr, *eol, *end, *name, *word;
+
+	for (ptr = map; ptr < map + maplen; ptr = eol + 1) {
+		if ( (eol = memchr(ptr, '\n', map + maplen - ptr)) == NULL)
+			eol = map + maplen;
+		if ( (end = memchr(ptr, '#', eol - ptr)) == NULL)
+			end = eol;
+
+		if ( (name = nextword(&ptr, end, &namelen)) == NULL)
+			continue;
+		if ( (word = nextword(&ptr, end, &len)) == NULL)
+			continue;
+		for (port = 0; len > 0 && isdigit((unsigned char) *word); len--)
+			port = port * 10 + (*word++ - '0');
+		if (port == 0 || port > 65535 || len != 4 || *word != '/')
+			continue;
+		if (memcmp(word + 1, "tcp", 3) == 0)
+			udp = 0;
+		else if (memcmp(word + 1, "udp", 3) == 0)
+			udp = 1;
+		else
+			continue;
+
+			/* 4the name, then the aliases after the port/protocol */
+		word = name;
+		len = namelen;
+		do {
+			if (len > 0xffff)
+				continue;
+			if (insert)
+				svc_insert(word, len, port, udp);
+			else
+				nidx++;
+		} while ( (word = nextword(&ptr, end, &len)) != NULL);
+	}
+}
+
+static void
+svc_load(void)
+{
+	int			fd;
+	const char	*path;
+	struct stat	st;
+	void		*ptr;
+
+	if ( (path = getenv("GAI_SERVICES")) == NULL)
+		path = "/etc/services";
+	if (*path == 0 || (fd = open(path, O_RDONLY)) < 0)
+		return;
+	if (fstat(fd, &st) < 0 || st.st_size == 0 || st.st_size > 0x7fffffff) {
+		close(fd);
+		return;
+	}
+	ptr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (ptr == MAP_FAILED)
+		return;
+	map = ptr;
+	maplen = st.st_size;
+
+	svc_scan(0);
+	for (idxmask = 15; idxmask + 1 < 2 * nidx; idxmask = (idxmask << 1) | 1)
+		;
+	if ( (idx = calloc(idxmask + 1, sizeof(struct svcidx))) == NULL) {
+		munmap(ptr, maplen);
+		return;
+	}
+	svc_scan(1);
+}
+
+#ifdef	HAVE_PTHREAD_H
+static pthread_once_t	svc_once = PTHREAD_ONCE_INIT;
+#else
+static int				svc_once;
+#endif
+
+/* include ga_svcfile */
+int
+ga_svcfile(const char *serv, int socktype)
+{
+	int				udp;
+	size_t			len;
+	uint32_t		h, i;
+	struct svcidx	*si;
+
+#ifdef	HAVE_PTHREAD_H
+	pthread_once(&svc_once, svc_load);
+#else
+	if (svc_once++ == 0)
+		svc_load();
+#endif
+	if (idx == NULL)
+		return(-1);
+
+	udp = (socktype != SOCK_STREAM);
+	len = strlen(serv);
+	h = ga_svchash(serv, len, udp);
+	for (i = h & idxmask; (si = &idx[i])->si_len != 0; i = (i + 1) & idxmask) {
+		if (si->si_hash == h && si->si_udp == udp && si->si_len == len &&
+			memcmp(map + si->si_off, serv, len) == 0)
+			return(si->si_port);
+	}
+	return(-1);
+}
+/* end ga_svcfile */
@@ -0,0 +1,30 @@
+#include	"gai_hdr.h"
+#include	"ga_svctab.h"
+
+/*
+ * Look up a service name in the table of well-known services compiled
+ * in from svctab.in, so the common names a client or server passes to
+ * getaddrinfo() ("daytime", "http", "domain") cost one hash and one
+ * string compare instead of a read of /etc/services.  The ports are
+ * the IANA assignments, so a local /etc/services that moves one of
+ * these services is not seen; remove the name from svctab.in if that
+ * matters.
+ *
+ * Return the port in network byte order, or -1 if the name is not in
+ * the table for this socket type.
+ */
+
+/* include ga_svctab */
+int
+ga_svctab(const char *serv, int socktype)
+{
+	int						port;
+	const struct ga_svc		*sv;
+
+	sv = &svctab[ga_svchash(serv, strlen(serv), SVC_SEED) & SVC_MASK];
+	if (sv->sv_name == NULL || strcmp(sv->sv_name, serv) != 0)
+		return(-1);
+	port = (socktype == SOCK_STREAM) ? sv->sv_tcp : sv->sv_udp;
+	return(port == 0 ? -1 : htons(port));
+}
+/* end ga_svctab */
@@ -0,0 +1,263 @@
+/* Generated by mksvctab from svctab.in: do not edit. */
+
+#define	SVC_SEED	75244U		/* 75 names in 256 slots */
+#define	SVC_MASK	255U
+
+static const struct ga_svc	svctab[SVC_MASK + 1] = {
+	{ "portmapper", 111, 111 },
+	{ NULL, 0, 0 },
+	{ "postgres", 5432, 0 },
+	{ "source", 19, 19 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ "sunrpc", 111, 111 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ "snmptrap", 162, 162 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ "ntp", 0, 123 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ "auth", 113, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ "finger", 79, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ "echo", 7, 7 },
+	{ NULL, 0, 0 },
+	{ "tap", 113, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ "readnews", 119, 0 },
+	{ "ftp-data", 20, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ "smtp", 25, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ "null", 9, 9 },
+	{ NULL, 0, 0 },
+	{ "ftp", 21, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ "rtsp", 554, 554 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ "rsync", 873, 0 },
+	{ "sink", 9, 9 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ "snmp", 161, 161 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ "kerberos", 88, 88 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ "exec", 512, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ "isakmp", 0, 500 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ "kerberos-sec", 88, 88 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ "imaps", 993, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ "timserver", 37, 37 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ "pop3s", 995, 0 },
+	{ "nfs", 2049, 2049 },
+	{ NULL, 0, 0 },
+	{ "nicname", 43, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ "postgresql", 5432, 0 },
+	{ "https", 443, 443 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ "authentication", 113, 0 },
+	{ "mysql", 3306, 0 },
+	{ "submission", 587, 0 },
+	{ NULL, 0, 0 },
+	{ "ldap", 389, 389 },
+	{ NULL, 0, 0 },
+	{ "discard", 9, 9 },
+	{ "tftp", 0, 69 },
+	{ "nntp", 119, 0 },
+	{ "webcache", 8080, 0 },
+	{ "snmp-trap", 162, 162 },
+	{ "ident", 113, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ "telnet", 23, 0 },
+	{ NULL, 0, 0 },
+	{ "imap2", 143, 0 },
+	{ "pop-3", 110, 0 },
+	{ NULL, 0, 0 },
+	{ "www", 80, 0 },
+	{ NULL, 0, 0 },
+	{ "http-alt", 8080, 0 },
+	{ "shell", 514, 0 },
+	{ "domain", 53, 53 },
+	{ NULL, 0, 0 },
+	{ "redis", 6379, 0 },
+	{ NULL, 0, 0 },
+	{ "pop3", 110, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ "untp", 119, 0 },
+	{ "daytime", 13, 13 },
+	{ NULL, 0, 0 },
+	{ "gopher", 70, 0 },
+	{ "imap", 143, 0 },
+	{ "login", 513, 0 },
+	{ "xmpp-client", 5222, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ "microsoft-ds", 445, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ "chargen", 19, 19 },
+	{ NULL, 0, 0 },
+	{ "ldaps", 636, 636 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ "syslog", 514, 514 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ "openvpn", 1194, 1194 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ "ipp", 631, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ "time", 37, 37 },
+	{ "krb5", 88, 88 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ "whois", 43, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ "http", 80, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ "ttytst", 19, 19 },
+	{ "socks", 1080, 0 },
+	{ NULL, 0, 0 },
+	{ "bootpc", 0, 68 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ "sip", 5060, 5060 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ "bootps", 0, 67 },
+	{ NULL, 0, 0 },
+	{ "mail", 25, 0 },
+	{ "kerberos5", 88, 88 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ "jabber-client", 5222, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ "cmd", 514, 0 },
+	{ NULL, 0, 0 },
+	{ "ssh", 22, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
+};
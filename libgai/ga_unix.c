@@ -7,8 +7,10 @@ int
 ga_unix(const char *path, struct addrinfo *hintsp, struct addrinfo **result)
 {
 	int				rc;
+	struct ga_arena	*arena;
 	struct addrinfo	*aihead, **aipnext;
 
+	arena = NULL;
 	aihead = NULL;
 	aipnext = &aihead;
 
@@ -18,25 +20,32 @@ ga_unix(const char *path, struct addrinfo *hintsp, struct addrinfo **result)
 	if (hintsp->ai_socktype == 0) {
 			/* 4no socket type specified: return stream then dgram */
 		hintsp->ai_socktype = SOCK_STREAM;
-		if ( (rc = ga_aistruct(&aipnext, hintsp, path, AF_LOCAL)) != 0)
-			return(rc);
+		if ( (rc = ga_aistruct(&arena, &aipnext, hintsp, path, AF_LOCAL)) != 0)
+			goto bad;
 		hintsp->ai_socktype = SOCK_DGRAM;
 	}
 
-	if ( (rc = ga_aistruct(&aipnext, hintsp, path, AF_LOCAL)) != 0)
-		return(rc);
+	if ( (rc = ga_aistruct(&arena, &aipnext, hintsp, path, AF_LOCAL)) != 0)
+		goto bad;
 
 	if (hintsp->ai_flags & AI_CANONNAME) {
 		struct utsname	myname;
 
+		rc = EAI_SYSTEM;
 		if (uname(&myname) < 0)
-			return(EAI_SYSTEM);
-		if ( (aihead->ai_canonname = strdup(myname.nodename)) == NULL)
-			return(EAI_MEMORY);
+			goto bad;
+		rc = EAI_MEMORY;
+		if ( (aihead->ai_canonname = ga_strdup(&arena, myname.nodename))
+			 == NULL)
+			goto bad;
 	}
 
 	*result = aihead;	/* pointer to first structure in linked list */
 	return(0);
+
+bad:
+	ga_free(arena);		/* everything allocated so far */
+	return(rc);
 }
 /* end ga_unix */
 #endif	/* UNIXdomain */
@@ -1,22 +1,48 @@
+#ifndef	_GNU_SOURCE
+#define	_GNU_SOURCE		/* EAI_ADDRFAMILY and gethostbyname2() in glibc */
+#endif
 #include	"unp.h"
 #include	<ctype.h>		/* isxdigit(), etc. */
 
 		/* following internal flag cannot overlap with other AI_xxx flags */
 #define	AI_CLONE	     4	/* clone this entry for other socket types */
 
+struct ga_arena {		/* header of each chunk of a result's memory */
+  struct ga_arena	*ar_next;	/* next chunk */
+  struct ga_arena	*ar_last;	/* first chunk only: last chunk */
+  int				 ar_nai;	/* first chunk only: addrinfo{}s not freed */
+  size_t			ar_size;	/* bytes after the header */
+  size_t			ar_used;
+};
+
+struct ga_svc {			/* one well-known service, see ga_svctab.c */
+  const char	*sv_name;
+  uint16_t		 sv_tcp;	/* TCP port, host byte order, 0 if none */
+  uint16_t		 sv_udp;	/* UDP port, likewise */
+};
+
 struct search {
   const char	*host;	/* hostname or address string */
   int			family;	/* AF_xxx */
 };
 
 		/* 4function prototypes for our own internal functions */
-int		ga_aistruct(struct addrinfo ***, const struct addrinfo *,
-					const void *, int);
-struct addrinfo		*ga_clone(struct addrinfo *);
+struct addrinfo	*ga_aialloc(struct ga_arena **, socklen_t);
+void	*ga_alloc(struct ga_arena **, size_t);
+struct ga_arena	*ga_arena(struct addrinfo *);
+void	 ga_free(struct ga_arena *);
+char	*ga_strdup(struct ga_arena **, const char *);
+int		ga_aistruct(struct ga_arena **, struct addrinfo ***,
+					const struct addrinfo *, const void *, int);
+struct addrinfo		*ga_clone(struct ga_arena **, struct addrinfo *);
 int		ga_echeck(const char *, const char *, int, int, int, int);
 int		ga_nsearch(const char *, const struct addrinfo *, struct search *);
-int		ga_port(struct addrinfo *, int , int);
-int		ga_serv(struct addrinfo *, const struct addrinfo *, const char *);
+int		ga_port(struct ga_arena **, struct addrinfo *, int , int);
+int		ga_serv(struct ga_arena **, struct addrinfo *, const struct addrinfo *,
+				const char *);
+uint32_t	ga_svchash(const char *, size_t, uint32_t);
+int		ga_svcfile(const char *, int);
+int		ga_svctab(const char *, int);
 int		ga_unix(const char *, struct addrinfo *, struct addrinfo **);
 
 int		gn_ipv46(char *, size_t, char *, size_t, void *, size_t,
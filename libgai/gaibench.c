@@ -0,0 +1,95 @@
+#include	"unp.h"
+
+/*
+ * Time getaddrinfo() and freeaddrinfo() for the cases that need no
+ * name service: numeric hosts, and the AI_PASSIVE wildcards a server
+ * asks for.  The Makefile links this with the getaddrinfo() in this
+ * directory even if the system has its own, so the two can be compared
+ * by building it with and without -DSYSTEM_GAI.  With glibc, the
+ * allocations per call are counted too.
+ */
+
+#if defined(__GLIBC__) && !defined(SYSTEM_GAI)
+extern void	*__libc_malloc(size_t), *__libc_calloc(size_t, size_t);
+static long	 nalloc;
+
+void *
+malloc(size_t n)
+{
+	nalloc++;
+	return(__libc_malloc(n));
+}
+
+void *
+calloc(size_t n, size_t size)
+{
+	nalloc++;
+	return(__libc_calloc(n, size));
+}
+#define	NALLOC	nalloc
+#else
+#define	NALLOC	0L
+#endif
+
+static void
+bench(const char *what, const char *host, const char *serv, int flags,
+	  int family, int socktype, long nloop)
+{
+	int				n, nres;
+	long			i, alloc0;
+	double			ns;
+	struct timeval	start, end;
+	struct addrinfo	hints, *res, *ai;
+
+	bzero(&hints, sizeof(hints));
+	hints.ai_flags = flags;
+	hints.ai_family = family;
+	hints.ai_socktype = socktype;
+
+	if ( (n = getaddrinfo(host, serv, &hints, &res)) != 0)
+		err_quit("getaddrinfo error for %s, %s: %s",
+				 host ? host : "(null)", serv, gai_strerror(n));
+	for (nres = 0, ai = res; ai != NULL; ai = ai->ai_next)
+		nres++;
+	freeaddrinfo(res);
+
+	alloc0 = NALLOC;
+	Gettimeofday(&start, NULL);
+	for (i = 0; i < nloop; i++) {
+		if (getaddrinfo(host, serv, &hints, &res) != 0)
+			err_quit("getaddrinfo error");
+		freeaddrinfo(res);
+	}
+	Gettimeofday(&end, NULL);
+	tv_sub(&end, &start);
+	ns = (end.tv_sec * 1e9 + end.tv_usec * 1e3) / nloop;
+
+	printf("%-28s %d results: %7.0f ns/call", what, nres, ns);
+	if (NALLOC != 0)
+		printf(", %.1f allocations/call", (double) (NALLOC - alloc0) / nloop);
+	printf("\n");
+}
+
+int
+main(int argc, char **argv)
+{
+	long	nloop;
+
+	if (argc > 2)
+		err_quit("usage: gaibench [ #loops ]");
+	nloop = (argc == 2) ? atol(argv[1]) : 1000000;
+
+	bench("127.0.0.1, any socktype", "127.0.0.1", "9877", 0,
+		  AF_UNSPEC, 0, nloop);
+	bench("::1, SOCK_STREAM", "::1", "9877", 0,
+		  AF_UNSPEC, SOCK_STREAM, nloop);
+	bench("AI_PASSIVE, AF_INET", NULL, "9877", AI_PASSIVE,
+		  AF_INET, SOCK_STREAM, nloop);
+	bench("AI_PASSIVE, any family/type", NULL, "9877", AI_PASSIVE,
+		  AF_UNSPEC, 0, nloop);
+	bench("AI_PASSIVE, AF_INET, \"http\"", NULL, "http", AI_PASSIVE,
+		  AF_INET, SOCK_STREAM, nloop);
+	bench("127.0.0.1, \"domain\"", "127.0.0.1", "domain", 0,
+		  AF_INET, 0, nloop);
+	exit(0);
+}
@@ -8,18 +8,21 @@ getaddrinfo(const char *hostname, const char *servname,
 			const struct addrinfo *hintsp, struct addrinfo **result)
 {
 	int					rc, error, nsearch;
-	char				**ap, *canon;
+	char				**ap, *canon, canonbuf[NI_MAXHOST];
 	struct hostent		*hptr;
 	struct search		search[3], *sptr;
+	struct ga_arena		*arena;
 	struct addrinfo		hints, *aihead, **aipnext;
 
 	/*
 	 * If we encounter an error we want to free() any dynamic memory
 	 * that we've allocated.  This is our hack to simplify the code.
+	 * All of it is in the arena, which the first ga_aistruct() creates.
 	 */
 #define	error(e) { error = (e); goto bad; }
 
-	aihead = NULL;		/* initialize automatic variables */
+	arena = NULL;		/* initialize automatic variables */
+	aihead = NULL;
 	aipnext = &aihead;
 	canon = NULL;
 
@@ -58,7 +61,7 @@ getaddrinfo(const char *hostname, const char *servname,
 					error(EAI_ADDRFAMILY);
 				if (sptr->family != AF_INET)
 					continue;		/* ignore */
-				rc = ga_aistruct(&aipnext, &hints, &inaddr, AF_INET);
+				rc = ga_aistruct(&arena, &aipnext, &hints, &inaddr, AF_INET);
 				if (rc != 0)
 					error(rc);
 				continue;
@@ -78,7 +81,8 @@ getaddrinfo(const char *hostname, const char *servname,
 					error(EAI_ADDRFAMILY);
 				if (sptr->family != AF_INET6)
 					continue;		/* ignore */
-				rc = ga_aistruct(&aipnext, &hints, &in6addr, AF_INET6);
+				rc = ga_aistruct(&arena, &aipnext, &hints, &in6addr,
+								 AF_INET6);
 				if (rc != 0)
 					error(rc);
 				continue;
@@ -92,18 +96,20 @@ getaddrinfo(const char *hostname, const char *servname,
 			res_init();			/* need this to set _res.options */
 
 		if (nsearch == 2) {
-#ifdef	IPv6
+#ifdef	RES_USE_INET6
 			_res.options &= ~RES_USE_INET6;
 #endif
 			hptr = gethostbyname2(sptr->host, sptr->family);
 		} else {
-#ifdef  IPv6
+#ifdef	RES_USE_INET6
 			if (sptr->family == AF_INET6)
 				_res.options |= RES_USE_INET6;
 			else
 				_res.options &= ~RES_USE_INET6;
-#endif
 			hptr = gethostbyname(sptr->host);
+#else	/* resolvers since glibc 2.26 have no RES_USE_INET6 */
+			hptr = gethostbyname2(sptr->host, sptr->family);
+#endif
 		}
 		if (hptr == NULL) {
 			if (nsearch == 2)
@@ -122,16 +128,17 @@ getaddrinfo(const char *hostname, const char *servname,
 		if (hints.ai_family != AF_UNSPEC && hints.ai_family != hptr->h_addrtype)
 			error(EAI_ADDRFAMILY);
 
-			/* 4save canonical name first time */
+			/* 4save canonical name first time; the arena gets it later */
 		if (hostname != NULL && hostname[0] != '\0' &&
 			(hints.ai_flags & AI_CANONNAME) && canon == NULL) {
-			if ( (canon = strdup(hptr->h_name)) == NULL)	
-				error(EAI_MEMORY);
+			strncpy(canonbuf, hptr->h_name, sizeof(canonbuf) - 1);
+			canonbuf[sizeof(canonbuf) - 1] = '\0';
+			canon = canonbuf;
 		}
 	
 			/* 4create one addrinfo{} for each returned address */
 		for (ap = hptr->h_addr_list; *ap != NULL; ap++) {
-			rc = ga_aistruct(&aipnext, &hints, *ap, hptr->h_addrtype);
+			rc = ga_aistruct(&arena, &aipnext, &hints, *ap, hptr->h_addrtype);
 			if (rc != 0)
 				error(rc);
 		}
@@ -144,17 +151,15 @@ getaddrinfo(const char *hostname, const char *servname,
 		/* 4return canonical name */
 	if (hostname != NULL && hostname[0] != '\0' &&
 		hints.ai_flags & AI_CANONNAME) {
-		if (canon != NULL)
-			aihead->ai_canonname = canon;	/* strdup'ed earlier */
-		else {
-			if ( (aihead->ai_canonname = strdup(search[0].host)) == NULL)
-				error(EAI_MEMORY);
-		}
+		if (canon == NULL)
+			canon = (char *) search[0].host;
+		if ( (aihead->ai_canonname = ga_strdup(&arena, canon)) == NULL)
+			error(EAI_MEMORY);
 	}
 
 		/* 4now process the service name */
 	if (servname != NULL && servname[0] != '\0') {
-		if ( (rc = ga_serv(aihead, &hints, servname)) != 0)
+		if ( (rc = ga_serv(&arena, aihead, &hints, servname)) != 0)
 			error(rc);
 	}
 
@@ -162,7 +167,7 @@ getaddrinfo(const char *hostname, const char *servname,
 	return(0);
 
 bad:
-	freeaddrinfo(aihead);	/* free any alloc'ed memory */
+	ga_free(arena);		/* free any alloc'ed memory */
 	return(error);
 }
 /* end ga5 */
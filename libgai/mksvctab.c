@@ -0,0 +1,130 @@
+#include	"gai_hdr.h"
+
+/*
+ * Generate ga_svctab.h, the perfect hash table of well-known services
+ * that ga_serv() looks in before anything else.  Reads /etc/services
+ * format from standard input (svctab.in), merges the tcp and udp lines
+ * for each name and alias, and then looks for a seed for ga_svchash()
+ * that puts every name in its own slot of a table of the smallest
+ * power of two at least twice the number of names.  A lookup is then
+ * one hash and one strcmp(), with no probing.
+ */
+
+#define	MAXSVC	1024
+#define	MAXSEED	10000000
+
+struct svc {
+  char		name[64];
+  int		tcp, udp;
+};
+
+static struct svc	svc[MAXSVC];
+static int			nsvc;
+
+static void
+add(const char *name, int port, int tcp)
+{
+	int		i;
+
+	for (i = 0; i < nsvc; i++)
+		if (strcmp(svc[i].name, name) == 0)
+			break;
+	if (i == nsvc) {
+		if (nsvc == MAXSVC)
+			err_quit("more than %d names", MAXSVC);
+		if (strlen(name) >= sizeof(svc[i].name))
+			err_quit("name too long: %s", name);
+		strcpy(svc[nsvc++].name, name);
+	}
+	if (tcp && svc[i].tcp == 0)			/* first one wins, as in the file */
+		svc[i].tcp = port;
+	else if (!tcp && svc[i].udp == 0)
+		svc[i].udp = port;
+}
+
+/* Return the seed that hashes all names into different slots, or -1. */
+static long
+findseed(uint32_t mask, unsigned char *used)
+{
+	int		i;
+	long	seed;
+	uint32_t	h;
+
+	for (seed = 0; seed < MAXSEED; seed++) {
+		memset(used, 0, mask + 1);
+		for (i = 0; i < nsvc; i++) {
+			h = ga_svchash(svc[i].name, strlen(svc[i].name), seed) & mask;
+			if (used[h])
+				break;
+			used[h] = 1;
+		}
+		if (i == nsvc)
+			return(seed);
+	}
+	return(-1);
+}
+
+int
+main(int argc, char **argv)
+{
+	int				i, port, nline;
+	long			seed;
+	char			line[MAXLINE], *name, *proto, *ptr, *tok;
+	uint32_t		mask, h;
+	unsigned char	*used;
+	struct svc		**slot;
+
+	for (nline = 1; fgets(line, sizeof(line), stdin) != NULL; nline++) {
+		if ( (ptr = strchr(line, '#')) != NULL)
+			*ptr = 0;
+		if ( (name = strtok(line, " \t\n")) == NULL)
+			continue;						/* blank or comment */
+		if ( (tok = strtok(NULL, " \t\n")) == NULL)
+			err_quit("line %d: no port/protocol", nline);
+		if ( (proto = strchr(tok, '/')) == NULL)
+			err_quit("line %d: no protocol in %s", nline, tok);
+		*proto++ = 0;
+		if ( (port = atoi(tok)) <= 0 || port > 65535)
+			err_quit("line %d: bad port %s", nline, tok);
+		if (strcmp(proto, "tcp") != 0 && strcmp(proto, "udp") != 0)
+			continue;
+		for (tok = name; tok != NULL; tok = strtok(NULL, " \t\n"))
+			add(tok, port, proto[0] == 't');
+	}
+	if (nsvc == 0)
+		err_quit("no services");
+
+		/* 4smallest power of two at least twice the names, then grow */
+	for (mask = 1; mask + 1 < 2 * nsvc; mask = (mask << 1) | 1)
+		;
+	for ( ; ; mask = (mask << 1) | 1) {
+		if ( (used = malloc(mask + 1)) == NULL)
+			err_sys("malloc error");
+		seed = findseed(mask, used);
+		free(used);
+		if (seed >= 0)
+			break;
+	}
+
+	if ( (slot = calloc(mask + 1, sizeof(struct svc *))) == NULL)
+		err_sys("calloc error");
+	for (i = 0; i < nsvc; i++) {
+		h = ga_svchash(svc[i].name, strlen(svc[i].name), seed) & mask;
+		slot[h] = &svc[i];
+	}
+
+	printf("/* Generated by mksvctab from svctab.in: do not edit. */\n\n");
+	printf("#define\tSVC_SEED\t%ldU\t\t/* %d names in %lu slots */\n",
+		   seed, nsvc, (unsigned long) mask + 1);
+	printf("#define\tSVC_MASK\t%luU\n\n", (unsigned long) mask);
+	printf("static const struct ga_svc\tsvctab[SVC_MASK + 1] = {\n");
+	for (h = 0; h <= mask; h++) {
+		if (slot[h] == NULL)
+			printf("\t{ NULL, 0, 0 },\n");
+		else
+			printf("\t{ \"%s\", %d, %d },\n", slot[h]->name,
+				   slot[h]->tcp, slot[h]->udp);
+	}
+	printf("};\n");
+	exit(0);
+}
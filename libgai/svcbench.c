@@ -0,0 +1,69 @@
+#include	"gai_hdr.h"
+
+/*
+ * Time the three ways ga_serv() can turn a service name into a port:
+ * the compiled-in perfect hash table (ga_svctab), the mmap'ed services
+ * file (ga_svcfile), and getservbyname().  Each name is checked to get
+ * the same port from all three that know it.
+ */
+
+static const char	*names[] = {
+	"daytime", "http", "domain", "postgresql",	/* in the table */
+	"bgp", "git",								/* only in the file */
+	"nosuchservice",
+	NULL
+};
+
+static double
+timeit(int (*fn)(const char *, int), const char *name, long nloop)
+{
+	long			i;
+	struct timeval	start, end;
+
+	Gettimeofday(&start, NULL);
+	for (i = 0; i < nloop; i++)
+		fn(name, SOCK_STREAM);
+	Gettimeofday(&end, NULL);
+	tv_sub(&end, &start);
+	return((end.tv_sec * 1e9 + end.tv_usec * 1e3) / nloop);
+}
+
+static int
+sysport(const char *name, int socktype)
+{
+	struct servent	*sptr;
+
+	sptr = getservbyname(name, socktype == SOCK_STREAM ? "tcp" : "udp");
+	return(sptr == NULL ? -1 : sptr->s_port);
+}
+
+int
+main(int argc, char **argv)
+{
+	int			i, tab, file, sys;
+	long		nloop;
+
+	if (argc > 2)
+		err_quit("usage: svcbench [ #loops ]");
+	nloop = (argc == 2) ? atol(argv[1]) : 1000000;
+
+	printf("%-16s %6s %12s %12s %14s\n", "name", "port",
+		   "table ns", "file ns", "getservbyname");
+	for (i = 0; names[i] != NULL; i++) {
+		tab = ga_svctab(names[i], SOCK_STREAM);
+		file = ga_svcfile(names[i], SOCK_STREAM);
+		sys = sysport(names[i], SOCK_STREAM);
+		if ((tab >= 0 && tab != sys) || (file >= 0 && file != sys))
+			err_msg("%s: table %d, file %d, getservbyname %d", names[i],
+					ntohs(tab), ntohs(file), ntohs(sys));
+
+		printf("%-16s %6d ", names[i], sys < 0 ? -1 : ntohs(sys));
+		if (tab >= 0)
+			printf("%12.0f ", timeit(ga_svctab, names[i], nloop));
+		else
+			printf("%12s ", "-");
+		printf("%12.0f ", timeit(ga_svcfile, names[i], nloop));
+		printf("%14.0f\n", timeit(sysport, names[i], nloop / 100));
+	}
+	exit(0);
+}
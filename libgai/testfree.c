@@ -0,0 +1,82 @@
+#include	"unp.h"
+
+/*
+ * See that freeaddrinfo() takes a sublist, as POSIX allows, and not just
+ * the head of what getaddrinfo() returned: split each result after its
+ * first addrinfo{}, free res->ai_next before or after res, and check
+ * that the rest of the list is still intact and that, with glibc, every
+ * allocation was freed once.  Linked, like gaibench, with the
+ * getaddrinfo() in this directory.
+ */
+
+#if defined(__GLIBC__)
+extern void	*__libc_malloc(size_t), *__libc_calloc(size_t, size_t);
+extern void	 __libc_free(void *);
+static long	 nalloc, nfree;
+
+void *
+malloc(size_t n)
+{
+	nalloc++;
+	return(__libc_malloc(n));
+}
+
+void *
+calloc(size_t n, size_t size)
+{
+	nalloc++;
+	return(__libc_calloc(n, size));
+}
+
+void
+free(void *ptr)
+{
+	if (ptr != NULL)
+		nfree++;
+	__libc_free(ptr);
+}
+#endif
+
+static void
+test(const char *what, const char *host, int flags, int headfirst)
+{
+	int				n;
+	long			alloc0, free0;
+	struct addrinfo	hints, *res, *sub;
+
+	bzero(&hints, sizeof(hints));
+	hints.ai_flags = flags;
+	alloc0 = nalloc;
+	free0 = nfree;
+	if ( (n = getaddrinfo(host, "9877", &hints, &res)) != 0)
+		err_quit("getaddrinfo error for %s: %s", what, gai_strerror(n));
+	if ( (sub = res->ai_next) == NULL)
+		err_quit("%s: only one result", what);
+	res->ai_next = NULL;
+
+	if (headfirst) {
+		freeaddrinfo(res);
+		if (sub->ai_addr == NULL || sub->ai_addr->sa_family != sub->ai_family)
+			err_quit("%s: sublist damaged by freeing its head", what);
+		freeaddrinfo(sub);
+	} else {
+		freeaddrinfo(sub);
+		if (res->ai_addr == NULL || res->ai_addr->sa_family != res->ai_family)
+			err_quit("%s: head damaged by freeing res->ai_next", what);
+		freeaddrinfo(res);
+	}
+	if (nalloc - alloc0 != nfree - free0)
+		err_quit("%s: %ld allocations, %ld frees", what,
+				 nalloc - alloc0, nfree - free0);
+	printf("%-40s OK\n", what);
+}
+
+int
+main(int argc, char **argv)
+{
+	test("AI_PASSIVE, res->ai_next first", NULL, AI_PASSIVE, 0);
+	test("AI_PASSIVE, res first", NULL, AI_PASSIVE, 1);
+	test("127.0.0.1, res->ai_next first", "127.0.0.1", 0, 0);
+	test("127.0.0.1, AI_CANONNAME, res first", "127.0.0.1", AI_CANONNAME, 1);
+	exit(0);
+}
@@ -0,0 +1,730 @@
+/*
+ * A caching DNS forwarder, so that every process on the host shares one
+ * set of answers instead of each resolver library going to the server.
+ * Queries arrive on a socket from udp_server() and are answered from
+ * the cache, or sent on to the upstream server, and the answer is kept
+ * for the smallest TTL in it.  A cached answer is given out with its
+ * TTLs reduced by the time it has been in the cache.
+ *
+ * The cache is a hash table split into shards, each with its own lock,
+ * so the -t threads (which all read the one socket) rarely wait for
+ * each other.  A query for a name that is already on its way upstream
+ * is not sent again; the client is added to the entry's waiters and
+ * every waiter gets the one answer.  If no answer comes within RETRY
+ * seconds, the next query for the name sends it again, and after
+ * PENDTIMEO seconds the waiters are forgotten (their resolvers retry).
+ * A pending entry that old is also the first to go when its shard is
+ * full, so names the upstream server never answers don't fill it.
+ *
+ * Anyone who can guess the ID and source port of a query we send
+ * upstream can answer it first, and have their answer cached and given
+ * to every client.  So each query gets a random ID, and every PENDTIMEO
+ * seconds each thread moves to a new upstream socket, and so a new
+ * source port chosen by the kernel; answers to queries sent on the old
+ * one are read from it until the next move.
+ *
+ * Each thread reads queries and upstream answers BATCH at a time with
+ * recvmmsg(), and sends what they produce BATCH at a time with
+ * sendmmsg(), as udpserv05 does.  Each thread has its own connected
+ * socket to the upstream server, so an answer comes back to the thread
+ * that asked.
+ *
+ * Only NOERROR and NXDOMAIN answers that are not truncated are cached;
+ * a negative answer only if it has an SOA record (RFC 2308).  Queries
+ * go upstream without their additional section (so no EDNS), which
+ * keeps every answer within 512 bytes for every client.
+ *
+ * To try it on one host with the stub from udpcksum/:
+ *		dnsstub 9953 &
+ *		dnscache 9954 127.0.0.1 9953 &
+ *		dnsload -r 50000 127.0.0.1 9954
+ */
+
+#define	_GNU_SOURCE			/* recvmmsg(), sendmmsg() */
+#include	"unpthread.h"
+#include	<ctype.h>
+#ifdef	__linux__
+#include	<sys/random.h>		/* getrandom() */
+#endif
+
+#define	BATCH		64			/* datagrams per system call */
+#define	MAXMSG		512			/* DNS over UDP, without EDNS */
+#define	MAXKEY		(255 + 4)	/* name, type and class */
+#define	MAXTTLS		32			/* TTLs we can adjust in one answer */
+#define	MAXWAIT		64			/* clients waiting for one answer */
+#define	MAXTTL		86400		/* longest we keep anything, seconds */
+#define	RETRY		1.0			/* seconds before asking upstream again */
+#define	PENDTIMEO	5.0			/* seconds before giving up on upstream */
+#define	NRAND		256			/* random IDs fetched at a time */
+
+#define	GET16(p)	(((p)[0] << 8) | (p)[1])
+#define	GET32(p)	(((uint32_t) (p)[0] << 24) | ((p)[1] << 16) | \
+					 ((p)[2] << 8) | (p)[3])
+
+struct waiter {					/* a client waiting for an answer */
+  struct sockaddr_storage	w_addr;
+  socklen_t					w_len;
+  unsigned char				w_id[2];	/* its query ID */
+};
+
+struct entry {
+  struct entry	*e_next;		/* hash chain */
+  struct entry	*e_newer, *e_older;	/* shard's list, newest first */
+  uint32_t		 e_hash;
+  int			 e_keylen;
+  unsigned char	 e_key[MAXKEY];	/* lowercase name, type, class */
+
+  unsigned char	*e_msg;			/* the answer; NULL while pending */
+  int			 e_len;
+  double		 e_stored, e_expire;
+  int			 e_nttl;		/* where the TTLs are, and their values */
+  uint16_t		 e_ttloff[MAXTTLS];
+  uint32_t		 e_ttl[MAXTTLS];
+
+  double		 e_sent;		/* while pending: when we asked */
+  uint16_t		 e_upid;		/* with this ID */
+  int			 e_nwait;
+  struct waiter	*e_wait;		/* MAXWAIT of them */
+};
+
+struct shard {
+  pthread_mutex_t	 s_lock;
+  struct entry	   **s_hash;
+  struct entry		*s_newest, *s_oldest;
+  int				 s_count;
+};
+
+struct worker {					/* one per thread */
+  pthread_t			 w_tid;
+  int				 w_upfd;	/* connected to the upstream server */
+  int				 w_oldfd;	/* the one before, for late answers */
+  double			 w_upsince;	/* when w_upfd was opened */
+  int				 w_nrand;	/* IDs left in w_rand[] */
+  uint16_t			 w_rand[NRAND];
+  int				 w_nout, w_nup;		/* datagrams queued to send */
+  unsigned char		 w_out[BATCH][MAXMSG];
+  struct iovec		 w_outiov[BATCH];
+  struct mmsghdr	 w_outmsg[BATCH];
+  struct sockaddr_storage	w_outaddr[BATCH];
+  unsigned char		 w_up[BATCH][MAXMSG];
+  struct iovec		 w_upiov[BATCH];
+  struct mmsghdr	 w_upmsg[BATCH];
+  long				 w_queries, w_hits, w_misses, w_coalesced, w_bad;
+  long				 w_upsent, w_answers, w_stale;
+};
+
+static struct shard		*shards;
+static int				 nshards, nbuckets, maxper;
+static struct worker	*workers;
+static int				 nworkers, listenfd, verbose;
+static char				*uphost, *upserv;
+
+static double
+now(void)
+{
+	struct timespec	ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return(ts.tv_sec + ts.tv_nsec / 1e9);
+}
+
+/* A query ID for upstream that cannot be guessed from the ones before. */
+static uint16_t
+new_id(struct worker *w)
+{
+	if (w->w_nrand == 0) {
+#ifdef	__linux__
+		if (getrandom(w->w_rand, sizeof(w->w_rand), 0) != sizeof(w->w_rand))
+			err_sys("getrandom error");
+#else
+		arc4random_buf(w->w_rand, sizeof(w->w_rand));
+#endif
+		w->w_nrand = NRAND;
+	}
+	return(w->w_rand[--w->w_nrand]);
+}
+
+static uint32_t
+hash(const unsigned char *key, int len)
+{
+	uint32_t	h;
+
+	for (h = 2166136261U; len > 0; len--)		/* FNV-1a */
+		h = (h ^ *key++) * 16777619;
+	return(h);
+}
+
+/*
+ * Copy the question of "msg" into "key", with the name in lowercase, set
+ * *keylen, and return the offset just past the question, or -1 if it is
+ * not a query we handle.
+ */
+static int
+get_question(const unsigned char *msg, int len, unsigned char *key, int *keylen)
+{
+	int		off, n, i;
+
+	if (len < 12 || GET16(msg + 4) != 1)		/* exactly one question */
+		return(-1);
+	for (off = 12, i = 0; off < len && (n = msg[off]) != 0; ) {
+		if (n > 63 || off + n + 1 > len || i + n + 1 > 255)
+			return(-1);			/* no compression in a question */
+		key[i++] = msg[off++];
+		while (n-- > 0)
+			key[i++] = tolower(msg[off++]);
+	}
+	if (off + 5 > len)
+		return(-1);
+	key[i++] = 0;
+	memcpy(key + i, msg + off + 1, 4);			/* type and class */
+	*keylen = i + 4;
+	return(off + 5);
+}
+
+/* The name in "key" with dots, for -v. */
+static char *
+key_name(const unsigned char *key)
+{
+	int			i, n;
+	static char	name[256];
+
+	for (i = 0; (n = key[i]) != 0; i += n + 1) {
+		memcpy(name + i, key + i + 1, n);
+		name[i + n] = '.';
+	}
+	name[i] = 0;
+	return(name);
+}
+
+/* Return the offset just past the name at "off", or -1. */
+static int
+skip_name(const unsigned char *msg, int len, int off)
+{
+	int		n;
+
+	while (off < len) {
+		if ( (n = msg[off]) == 0)
+			return(off + 1);
+		if ((n & 0xc0) == 0xc0)			/* pointer: the name ends here */
+			return(off + 2 <= len ? off + 2 : -1);
+		if (n > 63)
+			return(-1);
+		off += n + 1;
+	}
+	return(-1);
+}
+
+/*
+ * Note where every TTL in the answer "msg" is, starting at "off" (past
+ * the question), and return the TTL the answer can be cached for, or -1
+ * if it can't be.
+ */
+static long
+scan_ttls(struct entry *e, const unsigned char *msg, int len, int off)
+{
+	int		i, nrr, nansauth, type, rdlen, rcode;
+	long	ttl, least;
+
+	rcode = msg[3] & 0x0f;
+	if ((msg[2] & 0x02) || (rcode != 0 && rcode != 3))	/* TC, or failure */
+		return(-1);
+	nansauth = GET16(msg + 6) + GET16(msg + 8);
+	nrr = nansauth + GET16(msg + 10);
+
+	least = -1;
+	e->e_nttl = 0;
+	for (i = 0; i < nrr; i++) {
+		if ( (off = skip_name(msg, len, off)) < 0 || off + 10 > len)
+			return(-1);
+		type = GET16(msg + off);
+		ttl = GET32(msg + off + 4) & 0x7fffffff;
+		rdlen = GET16(msg + off + 8);
+		if (off + 10 + rdlen > len)
+			return(-1);
+		if (type != 41) {				/* OPT's "TTL" is not a TTL */
+			if (e->e_nttl == MAXTTLS)
+				return(-1);
+			e->e_ttloff[e->e_nttl] = off + 4;
+			e->e_ttl[e->e_nttl++] = ttl;
+			if (i < nansauth) {
+				if (type == 6 && rdlen >= 4)		/* SOA: its minimum, too */
+					ttl = min(ttl, (long) GET32(msg + off + 10 + rdlen - 4));
+				if (least < 0 || ttl < least)
+					least = ttl;
+			}
+		}
+		off += 10 + rdlen;
+	}
+	if (rcode == 3 && GET16(msg + 8) == 0)
+		return(-1);						/* negative, but no SOA */
+	return(least > MAXTTL ? MAXTTL : least);
+}
+
+static void
+unlink_entry(struct shard *s, struct entry *e)
+{
+	struct entry	**pp;
+
+	for (pp = &s->s_hash[e->e_hash % nbuckets]; *pp != e; pp = &(*pp)->e_next)
+		;
+	*pp = e->e_next;
+	if (e->e_newer)
+		e->e_newer->e_older = e->e_older;
+	else
+		s->s_newest = e->e_older;
+	if (e->e_older)
+		e->e_older->e_newer = e->e_newer;
+	else
+		s->s_oldest = e->e_newer;
+	s->s_count--;
+}
+
+static void
+free_entry(struct entry *e)
+{
+	free(e->e_msg);
+	free(e->e_wait);
+	free(e);
+}
+
+/* Make "e" the newest entry of its shard. */
+static void
+make_newest(struct shard *s, struct entry *e)
+{
+	if (s->s_newest == e)
+		return;
+	e->e_newer->e_older = e->e_older;		/* take it out ... */
+	if (e->e_older)
+		e->e_older->e_newer = e->e_newer;
+	else
+		s->s_oldest = e->e_newer;
+	e->e_newer = NULL;						/* ... and put it in front */
+	e->e_older = s->s_newest;
+	s->s_newest->e_newer = e;
+	s->s_newest = e;
+}
+
+/* Called with the shard locked. */
+static struct entry *
+lookup(struct shard *s, uint32_t h, const unsigned char *key, int keylen)
+{
+	struct entry	*e;
+
+	for (e = s->s_hash[h % nbuckets]; e != NULL; e = e->e_next)
+		if (e->e_hash == h && e->e_keylen == keylen &&
+			memcmp(e->e_key, key, keylen) == 0)
+			return(e);
+	return(NULL);
+}
+
+/*
+ * Add a pending entry, first throwing out the oldest answer if the
+ * shard is full.  A pending entry goes too, once it is PENDTIMEO old at
+ * time "t".  Called with the shard locked.
+ */
+static struct entry *
+insert(struct shard *s, uint32_t h, const unsigned char *key, int keylen,
+	   double t)
+{
+	struct entry	*e;
+
+	while (s->s_count >= maxper) {
+		for (e = s->s_oldest; e != NULL && e->e_msg == NULL &&
+			 t - e->e_sent <= PENDTIMEO; e = e->e_newer)
+			;					/* pending entries stay, for a while */
+		if (e == NULL)
+			break;
+		unlink_entry(s, e);
+		free_entry(e);
+	}
+
+	e = Calloc(1, sizeof(struct entry));
+	e->e_hash = h;
+	e->e_keylen = keylen;
+	memcpy(e->e_key, key, keylen);
+	e->e_next = s->s_hash[h % nbuckets];
+	s->s_hash[h % nbuckets] = e;
+	e->e_older = s->s_newest;
+	if (s->s_newest)
+		s->s_newest->e_newer = e;
+	else
+		s->s_oldest = e;
+	s->s_newest = e;
+	s->s_count++;
+	return(e);
+}
+
+static void
+flush(struct worker *w)
+{
+	int		i, n;
+
+	for (i = 0; i < w->w_nup; i += n) {
+		if ( (n = sendmmsg(w->w_upfd, w->w_upmsg + i, w->w_nup - i, 0)) < 0) {
+			if (errno != EINTR && errno != ECONNREFUSED)
+				err_ret("sendmmsg error to upstream");
+			n = (errno == EINTR) ? 0 : w->w_nup - i;
+		}
+	}
+	w->w_upsent += w->w_nup;
+	w->w_nup = 0;
+
+	for (i = 0; i < w->w_nout; i += n) {
+		if ( (n = sendmmsg(listenfd, w->w_outmsg + i, w->w_nout - i, 0)) < 0) {
+			if (errno == EINTR) {
+				n = 0;
+				continue;
+			}
+			err_ret("sendmmsg error");
+			n = 1;				/* skip the one that failed */
+		}
+	}
+	w->w_nout = 0;
+}
+
+/* Return a buffer for a datagram to "addr", to be sent at the next flush. */
+static unsigned char *
+queue_client(struct worker *w, const struct sockaddr_storage *addr,
+			 socklen_t len, int msglen)
+{
+	int		i;
+
+	if (w->w_nout == BATCH)
+		flush(w);
+	i = w->w_nout++;
+	memcpy(&w->w_outaddr[i], addr, len);
+	w->w_outmsg[i].msg_hdr.msg_namelen = len;
+	w->w_outiov[i].iov_len = msglen;
+	return(w->w_out[i]);
+}
+
+static void
+queue_upstream(struct worker *w, const unsigned char *query, int len,
+			   uint16_t id)
+{
+	int				i;
+	unsigned char	*ptr;
+
+	if (w->w_nup == BATCH)
+		flush(w);
+	i = w->w_nup++;
+	ptr = w->w_up[i];
+	memcpy(ptr, query, len);		/* just the header and question */
+	ptr[0] = id >> 8;
+	ptr[1] = id & 0xff;
+	memset(ptr + 6, 0, 6);			/* no answer, authority, additional */
+	w->w_upiov[i].iov_len = len;
+}
+
+/* include do_query */
+static void
+do_query(struct worker *w, unsigned char *msg, int len,
+		 struct sockaddr_storage *from, socklen_t fromlen)
+{
+	int				i, keylen, qend, fwd, age;
+	uint32_t		h, ttl;
+	double			t;
+	unsigned char	key[MAXKEY], *out;
+	struct shard	*s;
+	struct entry	*e;
+	struct waiter	*wt;
+
+	w->w_queries++;
+	if ((msg[2] & 0xf8) != 0 ||			/* a response, or not a QUERY */
+		(qend = get_question(msg, len, key, &keylen)) < 0) {
+		w->w_bad++;
+		return;
+	}
+
+	h = hash(key, keylen);
+	s = &shards[(h >> 16) % nshards];	/* buckets use the low bits */
+	t = now();
+	fwd = 0;
+	Pthread_mutex_lock(&s->s_lock);
+	e = lookup(s, h, key, keylen);
+	if (e != NULL && e->e_msg != NULL && t < e->e_expire) {
+			/* 4cached: the answer, with its ID and the time left */
+		out = queue_client(w, from, fromlen, e->e_len);
+		memcpy(out, e->e_msg, e->e_len);
+		out[0] = msg[0];
+		out[1] = msg[1];
+		age = t - e->e_stored;
+		for (i = 0; i < e->e_nttl; i++) {
+			ttl = (e->e_ttl[i] > age) ? e->e_ttl[i] - age : 0;
+			out[e->e_ttloff[i]] = ttl >> 24;
+			out[e->e_ttloff[i] + 1] = ttl >> 16;
+			out[e->e_ttloff[i] + 2] = ttl >> 8;
+			out[e->e_ttloff[i] + 3] = ttl;
+		}
+		make_newest(s, e);
+		Pthread_mutex_unlock(&s->s_lock);
+		w->w_hits++;
+		return;
+	}
+
+	if (e == NULL) {
+		e = insert(s, h, key, keylen, t);
+		fwd = 1;
+		w->w_misses++;
+	} else if (e->e_msg != NULL) {		/* expired: ask again */
+		free(e->e_msg);
+		e->e_msg = NULL;
+		make_newest(s, e);
+		fwd = 1;
+		w->w_misses++;
+	} else {							/* already asked */
+		if (t - e->e_sent > PENDTIMEO)
+			e->e_nwait = 0;
+		fwd = (t - e->e_sent > RETRY);
+		if (!fwd)
+			w->w_coalesced++;
+	}
+	if (e->e_wait == NULL) {
+		e->e_wait = Malloc(MAXWAIT * sizeof(struct waiter));
+		e->e_nwait = 0;
+	}
+	if (e->e_nwait < MAXWAIT) {
+		wt = &e->e_wait[e->e_nwait++];
+		memcpy(&wt->w_addr, from, fromlen);
+		wt->w_len = fromlen;
+		memcpy(wt->w_id, msg, 2);
+	}
+	if (fwd) {
+		e->e_upid = new_id(w);
+		e->e_sent = t;
+	}
+	Pthread_mutex_unlock(&s->s_lock);
+
+	if (fwd)
+		queue_upstream(w, msg, qend, e->e_upid);
+}
+/* end do_query */
+
+/* include do_answer */
+static void
+do_answer(struct worker *w, unsigned char *msg, int len)
+{
+	int				i, n, keylen, qend;
+	uint32_t		h;
+	long			ttl;
+	double			t;
+	unsigned char	key[MAXKEY], *out;
+	struct shard	*s;
+	struct entry	*e;
+	struct waiter	*wait;
+
+	if ((msg[2] & 0x80) == 0 ||
+		(qend = get_question(msg, len, key, &keylen)) < 0) {
+		w->w_bad++;
+		return;
+	}
+	w->w_answers++;
+
+	h = hash(key, keylen);
+	s = &shards[(h >> 16) % nshards];
+	t = now();
+	Pthread_mutex_lock(&s->s_lock);
+	e = lookup(s, h, key, keylen);
+	if (e == NULL || e->e_msg != NULL || e->e_upid != GET16(msg)) {
+		Pthread_mutex_unlock(&s->s_lock);
+		w->w_stale++;			/* answered already, or asked again */
+		return;
+	}
+	wait = e->e_wait;
+	n = e->e_nwait;
+	e->e_wait = NULL;
+	e->e_nwait = 0;
+
+	if ( (ttl = scan_ttls(e, msg, len, qend)) > 0) {
+		e->e_msg = Malloc(len);
+		memcpy(e->e_msg, msg, len);
+		e->e_len = len;
+		e->e_stored = t;
+		e->e_expire = t + ttl;
+	} else {
+		unlink_entry(s, e);		/* nothing to keep */
+		free_entry(e);
+	}
+	Pthread_mutex_unlock(&s->s_lock);
+
+	for (i = 0; i < n; i++) {
+		out = queue_client(w, &wait[i].w_addr, wait[i].w_len, len);
+		memcpy(out, msg, len);
+		memcpy(out, wait[i].w_id, 2);
+	}
+	free(wait);
+	if (verbose)
+		printf("answer for %s: %d waiting, ttl %ld\n", key_name(key), n, ttl);
+}
+/* end do_answer */
+
+static void *
+serve(void *arg)
+{
+	int						i, j, n;
+	struct worker			*w = arg;
+	unsigned char			buf[BATCH][MAXMSG];
+	struct sockaddr_storage	from[BATCH];
+	struct iovec			iov[BATCH];
+	struct mmsghdr			msgs[BATCH];
+	struct pollfd			fds[3];
+
+	for (i = 0; i < BATCH; i++) {
+		w->w_outiov[i].iov_base = w->w_out[i];
+		w->w_outmsg[i].msg_hdr.msg_name = &w->w_outaddr[i];
+		w->w_outmsg[i].msg_hdr.msg_iov = &w->w_outiov[i];
+		w->w_outmsg[i].msg_hdr.msg_iovlen = 1;
+		w->w_upiov[i].iov_base = w->w_up[i];
+		w->w_upmsg[i].msg_hdr.msg_iov = &w->w_upiov[i];
+		w->w_upmsg[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	fds[0].fd = listenfd;
+	fds[0].events = POLLIN;
+	fds[1].events = POLLIN;
+	fds[2].events = POLLIN;
+	for ( ; ; ) {
+		fds[1].fd = w->w_upfd;
+		fds[2].fd = w->w_oldfd;		/* skipped by poll() while -1 */
+		if (poll(fds, 3, INFTIM) < 0) {
+			if (errno == EINTR)
+				continue;
+			err_sys("poll error");
+		}
+
+		for (i = 0; i < BATCH; i++) {
+			bzero(&msgs[i], sizeof(msgs[i]));
+			iov[i].iov_base = buf[i];
+			iov[i].iov_len = MAXMSG;
+			msgs[i].msg_hdr.msg_name = &from[i];
+			msgs[i].msg_hdr.msg_namelen = sizeof(from[i]);
+			msgs[i].msg_hdr.msg_iov = &iov[i];
+			msgs[i].msg_hdr.msg_iovlen = 1;
+		}
+			/* 4answers first: they may let us reply to several clients */
+		for (j = 1; j <= 2; j++) {
+			if ((fds[j].revents & (POLLIN | POLLERR)) == 0)
+				continue;
+			if ( (n = recvmmsg(fds[j].fd, msgs, BATCH, MSG_DONTWAIT, NULL)) > 0)
+				for (i = 0; i < n; i++)
+					do_answer(w, buf[i], msgs[i].msg_len);
+			for (i = 0; i < BATCH; i++)
+				msgs[i].msg_hdr.msg_namelen = sizeof(from[i]);
+		}
+		if (fds[0].revents & (POLLIN | POLLERR)) {
+			if ( (n = recvmmsg(listenfd, msgs, BATCH, MSG_DONTWAIT, NULL)) > 0)
+				for (i = 0; i < n; i++)
+					do_query(w, buf[i], msgs[i].msg_len, &from[i],
+							 msgs[i].msg_hdr.msg_namelen);
+		}
+		flush(w);
+
+		if (now() - w->w_upsince >= PENDTIMEO) {
+				/* 4new source port; what the old one sent is PENDTIMEO old */
+			if (w->w_oldfd >= 0)
+				Close(w->w_oldfd);
+			w->w_oldfd = w->w_upfd;
+			w->w_upfd = Udp_connect(uphost, upserv);
+			w->w_upsince = now();
+		}
+	}
+	return(NULL);
+}
+
+static void
+sig_int(int signo)
+{
+	int				i;
+	long			q, hit, miss, coal, bad, up, ans, stale, entries;
+	struct worker	*w;
+
+	q = hit = miss = coal = bad = up = ans = stale = entries = 0;
+	for (i = 0; i < nworkers; i++) {
+		w = &workers[i];
+		q += w->w_queries;
+		hit += w->w_hits;
+		miss += w->w_misses;
+		coal += w->w_coalesced;
+		bad += w->w_bad;
+		up += w->w_upsent;
+		ans += w->w_answers;
+		stale += w->w_stale;
+	}
+	for (i = 0; i < nshards; i++)
+		entries += shards[i].s_count;
+	printf("\n%ld queries: %ld hits, %ld misses, %ld coalesced, %ld bad\n",
+		   q, hit, miss, coal, bad);
+	printf("%ld sent upstream, %ld answers, %ld stale; %ld entries cached\n",
+		   up, ans, stale, entries);
+	exit(0);
+}
+
+int
+main(int argc, char **argv)
+{
+	int		c, i, maxentries, n;
+
+	nworkers = 1;
+	nshards = 16;
+	maxentries = 65536;
+	opterr = 0;		/* don't want getopt() writing to stderr */
+	while ( (c = getopt(argc, argv, "c:s:t:v")) != -1) {
+		switch (c) {
+		case 'c':
+			maxentries = atoi(optarg);
+			break;
+
+		case 's':
+			nshards = atoi(optarg);
+			break;
+
+		case 't':
+			nworkers = atoi(optarg);
+			break;
+
+		case 'v':
+			verbose = 1;
+			break;
+
+		case '?':
+			err_quit("usage: dnscache [ -c #entries ] [ -s #shards ] "
+					 "[ -t #threads ] [ -v ]\n"
+					 "                <service or port> <upstream> "
+					 "[ <upstream port> ]");
+		}
+	}
+	if (optind != argc - 2 && optind != argc - 3)
+		err_quit("usage: dnscache [ options ] <service or port> <upstream> "
+				 "[ <upstream port> ]");
+	if (nshards < 1 || nworkers < 1 || maxentries < nshards)
+		err_quit("need at least one shard, one thread and one entry per shard");
+	uphost = argv[optind + 1];
+	upserv = (optind == argc - 3) ? argv[optind + 2] : "domain";
+
+	maxper = maxentries / nshards;
+	for (nbuckets = 1; nbuckets < maxper; nbuckets <<= 1)
+		;
+	shards = Calloc(nshards, sizeof(struct shard));
+	for (i = 0; i < nshards; i++) {
+		Pthread_mutex_init(&shards[i].s_lock, NULL);
+		shards[i].s_hash = Calloc(nbuckets, sizeof(struct entry *));
+	}
+
+	listenfd = Udp_server(NULL, argv[optind], NULL);
+	n = 4 * 1024 * 1024;
+	setsockopt(listenfd, SOL_SOCKET, SO_RCVBUF, &n, sizeof(n));
+
+	workers = Calloc(nworkers, sizeof(struct worker));
+	for (i = 0; i < nworkers; i++) {
+		workers[i].w_upfd = Udp_connect(uphost, upserv);
+		workers[i].w_oldfd = -1;
+		workers[i].w_upsince = now();
+	}
+	Signal(SIGINT, sig_int);
+	Signal(SIGTERM, sig_int);
+
+	for (i = 1; i < nworkers; i++)
+		Pthread_create(&workers[i].w_tid, NULL, serve, &workers[i]);
+	serve(&workers[0]);		/* never returns */
+	exit(0);
+}
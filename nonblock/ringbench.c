@@ -0,0 +1,255 @@
+/*
+ * System calls to relay a stream through a buffer of -b bytes, the way
+ * strclinonb relays stdin to the socket.  A child writes -n MB into one
+ * socketpair; the parent polls, reads into the buffer from that one and
+ * writes from the buffer to a second socketpair; another child reads
+ * that in -r byte pieces and checks it.  The socket buffers are set to
+ * -s bytes, so that reads and writes are often partial.  The parent's
+ * read(), write() and poll() calls are counted for each buffer:
+ *
+ *	array	strclinonb's: fill to the end of the array, start again at
+ *			the front only when it is empty
+ *	ring	a ring, one read() or write() of the span up to the end
+ *	ringv	a ring, readv() or writev() of both spans
+ *	mirror	a ring from mirror_alloc(), one read() or write() of all
+ */
+#include	"unp.h"
+
+enum { B_ARRAY, B_RING, B_RINGV, B_MIRROR };
+static const char	*bname[] = { "array", "ring", "ringv", "mirror" };
+
+static char		*buf;
+static size_t	bufsize, head, tail;		/* data is [head, tail) */
+static long		nread, nwrite, npoll;
+
+static void
+producer(int fd, long nbytes)
+{
+	long	i, j, n;
+	char	chunk[65536];
+
+	for (i = 0; i < nbytes; i += n) {
+		n = min(nbytes - i, (long) sizeof(chunk));
+		for (j = 0; j < n; j++)
+			chunk[j] = (i + j) % 251;
+		Writen(fd, chunk, n);
+	}
+	exit(0);
+}
+
+static void
+consumer(int fd, long nbytes, int rsize)
+{
+	long	i, j;
+	ssize_t	n;
+	char	*chunk;
+
+	chunk = Malloc(rsize);
+	for (i = 0; (n = Read(fd, chunk, rsize)) > 0; i += n)
+		for (j = 0; j < n; j++)
+			if (chunk[j] != (char) ((i + j) % 251))
+				err_quit("byte %ld is wrong", i + j);
+	if (i != nbytes)
+		err_quit("got %ld bytes, not %ld", i, nbytes);
+	exit(0);
+}
+
+	/* 4read() or readv() into the buffer; returns what read() did */
+static ssize_t
+fill(int mode, int fd)
+{
+	ssize_t			n;
+	size_t			off, nfree;
+	struct iovec	iov[2];
+
+	nread++;
+	if (mode == B_ARRAY) {
+		if ( (n = read(fd, buf + tail, bufsize - tail)) > 0)
+			tail += n;
+		return(n);
+	}
+	nfree = bufsize - (tail - head);
+	off = tail % bufsize;
+	if (mode == B_MIRROR || mode == B_RING)
+		n = read(fd, buf + off,
+				 mode == B_MIRROR ? nfree : min(nfree, bufsize - off));
+	else {
+		iov[0].iov_base = buf + off;
+		iov[0].iov_len = min(nfree, bufsize - off);
+		iov[1].iov_base = buf;
+		iov[1].iov_len = nfree - iov[0].iov_len;
+		n = readv(fd, iov, iov[1].iov_len > 0 ? 2 : 1);
+	}
+	if (n > 0)
+		tail += n;
+	return(n);
+}
+
+	/* 4write() or writev() from the buffer */
+static void
+drain(int mode, int fd)
+{
+	ssize_t			n;
+	size_t			off, len;
+	struct iovec	iov[2];
+
+	nwrite++;
+	len = tail - head;
+	off = (mode == B_ARRAY) ? head : head % bufsize;
+	if (mode == B_ARRAY || mode == B_MIRROR)
+		n = write(fd, buf + off, len);
+	else if (mode == B_RING)
+		n = write(fd, buf + off, min(len, bufsize - off));
+	else {
+		iov[0].iov_base = buf + off;
+		iov[0].iov_len = min(len, bufsize - off);
+		iov[1].iov_base = buf;
+		iov[1].iov_len = len - iov[0].iov_len;
+		n = writev(fd, iov, iov[1].iov_len > 0 ? 2 : 1);
+	}
+	if (n < 0) {
+		if (errno != EWOULDBLOCK)
+			err_sys("write error");
+		return;
+	}
+	head += n;
+	if (mode == B_ARRAY && head == tail)
+		head = tail = 0;		/* back to beginning of buffer */
+}
+
+static void
+bench(int mode, long nbytes, int rsize, int sbufsize)
+{
+	int				i, eof, in[2], out[2], val;
+	ssize_t			n;
+	pid_t			pid[2];
+	struct pollfd	fds[2];
+	struct timeval	start, end;
+
+	if (mode == B_MIRROR) {
+		if ( (buf = mirror_alloc(bufsize)) == NULL)
+			err_sys("mirror_alloc error");
+	} else
+		buf = Malloc(bufsize);
+	head = tail = 0;
+	nread = nwrite = npoll = 0;
+
+	Socketpair(AF_UNIX, SOCK_STREAM, 0, in);
+	Socketpair(AF_UNIX, SOCK_STREAM, 0, out);
+	for (i = 0; i < 2; i++) {
+		Setsockopt(in[i], SOL_SOCKET, SO_SNDBUF, &sbufsize, sizeof(sbufsize));
+		Setsockopt(in[i], SOL_SOCKET, SO_RCVBUF, &sbufsize, sizeof(sbufsize));
+		Setsockopt(out[i], SOL_SOCKET, SO_SNDBUF, &sbufsize, sizeof(sbufsize));
+		Setsockopt(out[i], SOL_SOCKET, SO_RCVBUF, &sbufsize, sizeof(sbufsize));
+	}
+	fflush(stdout);		/* before the children inherit it */
+	if ( (pid[0] = Fork()) == 0) {
+		Close(in[0]); Close(out[0]); Close(out[1]);
+		producer(in[1], nbytes);
+	}
+	if ( (pid[1] = Fork()) == 0) {
+		Close(in[0]); Close(in[1]); Close(out[0]);
+		consumer(out[1], nbytes, rsize);
+	}
+	Close(in[1]);
+	Close(out[1]);
+	val = Fcntl(in[0], F_GETFL, 0);
+	Fcntl(in[0], F_SETFL, val | O_NONBLOCK);
+	val = Fcntl(out[0], F_GETFL, 0);
+	Fcntl(out[0], F_SETFL, val | O_NONBLOCK);
+
+	Gettimeofday(&start, NULL);
+	eof = 0;
+	fds[0].events = POLLIN;
+	fds[1].events = POLLOUT;
+	while (!eof || tail != head) {
+			/* 4a negative fd is skipped, even for POLLHUP */
+		fds[0].fd = (!eof && (mode == B_ARRAY ? tail < bufsize
+								: tail - head < bufsize)) ? in[0] : -1;
+		fds[1].fd = (tail != head) ? out[0] : -1;
+		Poll(fds, 2, INFTIM);
+		npoll++;
+
+		if (fds[0].revents) {
+			if ( (n = fill(mode, in[0])) == 0)
+				eof = 1;
+			else if (n > 0)
+				fds[1].revents |= POLLOUT;	/* try and write below */
+			else if (errno != EWOULDBLOCK)
+				err_sys("read error");
+		}
+		if ((fds[1].revents & POLLOUT) && tail != head)
+			drain(mode, out[0]);
+	}
+	Close(out[0]);
+	Close(in[0]);
+	for (i = 0; i < 2; i++) {
+		if (waitpid(pid[i], &val, 0) < 0)
+			err_sys("waitpid error");
+		if (!WIFEXITED(val) || WEXITSTATUS(val) != 0)
+			err_quit("%s: child failed", bname[mode]);
+	}
+	Gettimeofday(&end, NULL);
+	tv_sub(&end, &start);
+
+	printf("%-6s %8ld reads %8ld writes %8ld polls %7.0f bytes/read "
+		   "%6.1f ms\n", bname[mode], nread, nwrite, npoll,
+		   (double) nbytes / nread, end.tv_sec * 1e3 + end.tv_usec / 1e3);
+
+	if (mode == B_MIRROR)
+		mirror_free(buf, bufsize);
+	else
+		free(buf);
+}
+
+int
+main(int argc, char **argv)
+{
+	int		c, i, m, rsize, sbufsize;
+	long	nbytes;
+
+	bufsize = MAXLINE;
+	nbytes = 64L * 1024 * 1024;
+	rsize = 1000;
+	sbufsize = 8192;
+	opterr = 0;
+	while ( (c = getopt(argc, argv, "b:n:r:s:")) != -1) {
+		switch (c) {
+		case 'b':
+			bufsize = atol(optarg);
+			break;
+		case 'n':
+			nbytes = atol(optarg) * 1024 * 1024;
+			break;
+		case 'r':
+			rsize = atoi(optarg);
+			break;
+		case 's':
+			sbufsize = atoi(optarg);
+			break;
+		case '?':
+			err_quit("unrecognized option: %c", optopt);
+		}
+	}
+	if (bufsize == 0 || bufsize % sysconf(_SC_PAGESIZE) != 0 ||
+		nbytes < 1 || rsize < 1)
+		err_quit("usage: ringbench [ -b bufsize (page multiple) ] [ -n MB ] "
+				 "[ -r readsize ] [ -s sockbufsize ] [ array | ring | ringv "
+				 "| mirror ] ...");
+	printf("%ld MB through %ld bytes, read by %d, socket buffers %d\n",
+		   nbytes / (1024 * 1024), (long) bufsize, rsize, sbufsize);
+
+	if (optind == argc) {
+		for (m = B_ARRAY; m <= B_MIRROR; m++)
+			bench(m, nbytes, rsize, sbufsize);
+	}
+	for (i = optind; i < argc; i++) {
+		for (m = B_ARRAY; m <= B_MIRROR; m++)
+			if (strcmp(argv[i], bname[m]) == 0)
+				break;
+		if (m > B_MIRROR)
+			err_quit("unknown buffer: %s", argv[i]);
+		bench(m, nbytes, rsize, sbufsize);
+	}
+	exit(0);
+}
@@ -0,0 +1,91 @@
+/*
+ * strclinonb with the buffering done by bufev: one bufev each for stdin,
+ * stdout and the socket, and callbacks that move what stdin's has read to
+ * the socket's output and what the socket's has read to stdout's.  The
+ * four pointers into two MAXLINE arrays become growable rings, and a
+ * side that cannot keep up holds the other back (the watermarks) instead
+ * of the program stopping at MAXLINE.
+ */
+#include	"unpbufev.h"
+
+static struct bufev	*tin, *tout, *sock;
+
+static void
+to_sock(struct bufev *bev, void *arg)	/* stdin read or socket drained */
+{
+	bufev_move(tin, sock);
+}
+
+static void
+to_stdout(struct bufev *bev, void *arg)	/* socket read or stdout drained */
+{
+	bufev_move(sock, tout);
+}
+
+static void
+tin_event(struct bufev *bev, int what, void *arg)
+{
+	if (what == BEV_EOF) {
+#ifdef	VOL2
+		fprintf(stderr, "%s: EOF on stdin\n", gf_time());
+#endif
+		bufev_shutdown(sock);		/* send FIN once all is written */
+	} else {
+		errno = bev->be_errno;
+		err_sys("read error on stdin");
+	}
+}
+
+static void
+sock_event(struct bufev *bev, int what, void *arg)
+{
+	if (what == BEV_EOF) {
+		if ((tin->be_flags & BEV_EOFDONE) == 0)
+			err_quit("str_cli: server terminated prematurely");
+	} else {
+		errno = bev->be_errno;
+		err_sys("error on socket");
+	}
+}
+
+static void
+tout_event(struct bufev *bev, int what, void *arg)
+{
+	errno = bev->be_errno;
+	err_sys("write error to stdout");
+}
+
+void
+str_cli(FILE *fp, int sockfd)
+{
+	int				i;
+	struct pollfd	fds[3];
+
+	tin = bufev_new(fileno(fp));
+	tout = bufev_new(STDOUT_FILENO);
+	sock = bufev_new(sockfd);
+	bufev_disable(tout, BEV_READ);
+	bufev_setcb(tin, to_sock, NULL, tin_event, NULL);
+	bufev_setcb(tout, NULL, to_stdout, tout_event, NULL);
+	bufev_setcb(sock, to_stdout, to_sock, sock_event, NULL);
+
+	while (!bufev_done(sock) || bufev_outlen(tout) > 0) {
+		fds[0].events = bufev_events(tin);
+		fds[1].events = bufev_events(tout);
+		fds[2].events = bufev_events(sock);
+			/* 4else a pipe at EOF keeps returning POLLHUP */
+		fds[0].fd = fds[0].events ? tin->be_fd : -1;
+		fds[1].fd = fds[1].events ? tout->be_fd : -1;
+		fds[2].fd = fds[2].events ? sock->be_fd : -1;
+
+		Poll(fds, 3, INFTIM);
+
+		for (i = 0; i < 3; i++)
+			if (fds[i].revents)
+				bufev_handle(i == 0 ? tin : i == 1 ? tout : sock,
+							 fds[i].revents);
+	}
+	bufev_free(tin);
+	bufev_free(tout);
+	bufev_free(sock);
+}
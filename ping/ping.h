@@ -13,20 +13,23 @@ char	*host;
 int		 nsent;				/* add 1 for each sendto() */
 pid_t	 pid;				/* our PID */
 int		 sockfd;
+int		 tsflags;			/* TSTAMP_xxx enabled on sockfd */
 int		 verbose;
 
 			/* function prototypes */
 void	 init_v6(void);
-void	 proc_v4(char *, ssize_t, struct msghdr *, struct timeval *);
-void	 proc_v6(char *, ssize_t, struct msghdr *, struct timeval *);
+void	 proc_v4(char *, ssize_t, struct msghdr *, struct timespec *);
+void	 proc_v6(char *, ssize_t, struct msghdr *, struct timespec *);
 void	 send_v4(void);
 void	 send_v6(void);
 void	 readloop(void);
 void	 sig_alrm(int);
 void	 tv_sub(struct timeval *, struct timeval *);
+void	 tx_reap(void);
+void	 tx_sendtime(int, struct timeval *, struct timespec *);
 
 struct proto {
-  void	 (*fproc)(char *, ssize_t, struct msghdr *, struct timeval *);
+  void	 (*fproc)(char *, ssize_t, struct msghdr *, struct timespec *);
   void	 (*fsend)(void);
   void	 (*finit)(void);
   struct sockaddr  *sasend;	/* sockaddr{} for send, from getaddrinfo */
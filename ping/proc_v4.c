@@ -1,13 +1,14 @@
 #include	"ping.h"
 
 void
-proc_v4(char *ptr, ssize_t len, struct msghdr *msg, struct timeval *tvrecv)
+proc_v4(char *ptr, ssize_t len, struct msghdr *msg, struct timespec *tsrecv)
 {
 	int				hlen1, icmplen;
 	double			rtt;
 	struct ip		*ip;
 	struct icmp		*icmp;
 	struct timeval	*tvsend;
+	struct timespec	tssend;
 
 	ip = (struct ip *) ptr;		/* start of IP header */
 	hlen1 = ip->ip_hl << 2;		/* length of IP header */
@@ -25,8 +26,8 @@ proc_v4(char *ptr, ssize_t len, struct msghdr *msg, struct timeval *tvrecv)
 			return;			/* not enough data to use */
 
 		tvsend = (struct timeval *) icmp->icmp_data;
-		tv_sub(tvrecv, tvsend);
-		rtt = tvrecv->tv_sec * 1000.0 + tvrecv->tv_usec / 1000.0;
+		tx_sendtime(icmp->icmp_seq, tvsend, &tssend);
+		rtt = tstamp_msec(tsrecv, &tssend);
 
 		printf("%d bytes from %s: seq=%u, ttl=%d, rtt=%.3f ms\n",
 				icmplen, Sock_ntop_host(pr->sarecv, pr->salen),
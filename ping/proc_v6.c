@@ -1,12 +1,13 @@
 #include	"ping.h"
 
 void
-proc_v6(char *ptr, ssize_t len, struct msghdr *msg, struct timeval* tvrecv)
+proc_v6(char *ptr, ssize_t len, struct msghdr *msg, struct timespec *tsrecv)
 {
 #ifdef	IPV6
 	double				rtt;
 	struct icmp6_hdr	*icmp6;
 	struct timeval		*tvsend;
+	struct timespec		tssend;
 	struct cmsghdr		*cmsg;
 	int					hlim;
 
@@ -21,8 +22,8 @@ proc_v6(char *ptr, ssize_t len, struct msghdr *msg, struct timeval* tvrecv)
 			return;			/* not enough data to use */
 
 		tvsend = (struct timeval *) (icmp6 + 1);
-		tv_sub(tvrecv, tvsend);
-		rtt = tvrecv->tv_sec * 1000.0 + tvrecv->tv_usec / 1000.0;
+		tx_sendtime(icmp6->icmp6_seq, tvsend, &tssend);
+		rtt = tstamp_msec(tsrecv, &tssend);
 
 		hlim = -1;
 		for (cmsg = CMSG_FIRSTHDR(msg); cmsg != NULL; cmsg = CMSG_NXTHDR(msg, cmsg)) {
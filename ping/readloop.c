@@ -9,7 +9,7 @@ readloop(void)
 	struct msghdr	msg;
 	struct iovec	iov;
 	ssize_t			n;
-	struct timeval	tval;
+	struct timespec	tsrecv;
 
 	sockfd = Socket(pr->sasend->sa_family, SOCK_RAW, pr->icmpproto);
 	setuid(getuid());		/* don't need special permissions any more */
@@ -19,6 +19,14 @@ readloop(void)
 	size = 60 * 1024;		/* OK if setsockopt fails */
 	setsockopt(sockfd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
 
+		/* take RTTs from kernel timestamps, if the system has them */
+	tsflags = tstamp_enable(sockfd, TSTAMP_RX | TSTAMP_TX);
+	if (verbose)
+		printf("kernel timestamps:%s%s%s\n",
+			   (tsflags & TSTAMP_TX) ? " transmit" : "",
+			   (tsflags & TSTAMP_RX) ? " receive" : "",
+			   (tsflags == 0) ? " none" : "");
+
 	sig_alrm(SIGALRM);		/* send first packet */
 
 	iov.iov_base = recvbuf;
@@ -32,13 +40,16 @@ readloop(void)
 		msg.msg_controllen = sizeof(controlbuf);
 		n = recvmsg(sockfd, &msg, 0);
 		if (n < 0) {
-			if (errno == EINTR)
+			if (errno == EINTR) {
+				if (tsflags & TSTAMP_TX)
+					tx_reap();	/* don't let the error queue fill up */
 				continue;
-			else
+			} else
 				err_sys("recvmsg error");
 		}
 
-		Gettimeofday(&tval, NULL);
-		(*pr->fproc)(recvbuf, n, &msg, &tval);
+		if (tstamp_recv(&msg, &tsrecv) == 0)
+			tstamp_now(&tsrecv);
+		(*pr->fproc)(recvbuf, n, &msg, &tsrecv);
 	}
 }
@@ -0,0 +1,44 @@
+#include	"ping.h"
+
+#define	NTXSTAMP	1024	/* # of kernel transmit timestamps remembered */
+
+static struct {
+  uint32_t			tx_id;		/* counts sends from 0, same as nsent */
+  struct timespec	tx_ts;		/* when the kernel sent the packet */
+} txstamp[NTXSTAMP];
+
+/*
+ * Move all the transmit timestamps waiting on the socket's error
+ * queue into our table.
+ */
+void
+tx_reap(void)
+{
+	uint32_t		id;
+	struct timespec	ts;
+
+	while (Tstamp_txreap(sockfd, &id, &ts) > 0) {
+		txstamp[id % NTXSTAMP].tx_id = id;
+		txstamp[id % NTXSTAMP].tx_ts = ts;
+	}
+}
+
+/*
+ * Return the time the echo request with sequence number "seq" was sent:
+ * the kernel's transmit timestamp if we have it, else the user-space
+ * time that send_v4() or send_v6() stored in the packet.
+ */
+void
+tx_sendtime(int seq, struct timeval *tvsend, struct timespec *tssend)
+{
+	if (tsflags & TSTAMP_TX) {
+		tx_reap();
+		if ((txstamp[seq % NTXSTAMP].tx_id & 0xffff) == seq &&
+			txstamp[seq % NTXSTAMP].tx_ts.tv_sec != 0) {
+			*tssend = txstamp[seq % NTXSTAMP].tx_ts;
+			return;
+		}
+	}
+	tssend->tv_sec = tvsend->tv_sec;
+	tssend->tv_nsec = tvsend->tv_usec * 1000;
+}
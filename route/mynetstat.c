@@ -1,15 +1,21 @@
+#ifdef	__linux__
+#include	"unprtnl.h"
+#include	"unpifi.h"
+#else
 #include	"unproute.h"
+#endif
 
 void	pr_rtable(int);
 void	pr_iflist(int);
+void	pr_lookup(int, char **);
 
 int
 main(int argc, char **argv)
 {
-	int family;
+	int family = 0;
 
-	if (argc != 2)
-		err_quit("usage: mynetstat <inet4|inet6|all>");
+	if (argc < 2)
+		err_quit("usage: mynetstat <inet4|inet6|all> [ address ... ]");
 	if (strcmp(argv[1], "inet4") == 0)
 		family = AF_INET;
 #ifdef	AF_INET6
@@ -25,9 +31,186 @@ main(int argc, char **argv)
 
 	pr_iflist(family);
 
+	if (argc > 2)
+		pr_lookup(family, argv + 2);
+
 	exit(0);
 }
 
+#ifdef	__linux__
+/*
+ * Linux has neither routing sockets nor the sysctl() that dumps them, so
+ * the routes come from rtnetlink (rtnl_route.c) and the interfaces from
+ * get_ifi_info(), which uses rtnetlink there too.
+ */
+static const char *
+rt_ntop(int family, const void *addr)
+{
+	static char	str[INET6_ADDRSTRLEN];
+
+	return(Inet_ntop(family, addr, str, sizeof(str)));
+}
+
+static void
+pr_route(const struct rtroute *rt)
+{
+	char	ifname[IF_NAMESIZE];
+
+	printf("dest: %s/%d", rt_ntop(rt->rt_family, rt->rt_dst), rt->rt_plen);
+	if (rt->rt_hasgw)
+		printf(", gateway: %s", rt_ntop(rt->rt_family, rt->rt_gw));
+	if (rt->rt_ifindex != 0 && if_indextoname(rt->rt_ifindex, ifname) != NULL)
+		printf(", interface: %s", ifname);
+	if (rt->rt_type != RTN_UNICAST)
+		printf(", type %d", rt->rt_type);
+	if (rt->rt_table == RT_TABLE_LOCAL)
+		printf(", table local");
+	printf("\n");
+}
+
+void
+pr_rtable(int family)
+{
+	int				i, n;
+	struct rtroute	*routes;
+
+	if ( (n = rtnl_routes(family, &routes)) < 0)
+		err_sys("rtnl_routes error");
+	for (i = 0; i < n; i++)
+		pr_route(&routes[i]);
+	free(routes);
+}
+
+void
+pr_iflist(int family)
+{
+	int				i, flags;
+	u_char			*ptr;
+	struct ifi_info	*ifi, *ifihead;
+	static const int	families[] = { AF_INET, AF_INET6 };
+
+	for (i = 0; i < 2; i++) {
+		if (family != 0 && family != families[i])
+			continue;
+		ifihead = get_ifi_info(families[i], 1);
+		for (ifi = ifihead; ifi != NULL; ifi = ifi->ifi_next) {
+			if ((ifi->ifi_myflags & IFI_ALIAS) == 0) {
+				flags = ifi->ifi_flags;
+				printf("interface: %s: <", ifi->ifi_name);
+				if (flags & IFF_UP)				printf("UP ");
+				if (flags & IFF_BROADCAST)		printf("BCAST ");
+				if (flags & IFF_MULTICAST)		printf("MCAST ");
+				if (flags & IFF_LOOPBACK)		printf("LOOP ");
+				if (flags & IFF_POINTOPOINT)	printf("P2P ");
+				printf(">\n");
+				if (ifi->ifi_hlen == 6) {
+					ptr = ifi->ifi_haddr;
+					printf("  %x:%x:%x:%x:%x:%x\n", *ptr, *(ptr+1),
+							*(ptr+2), *(ptr+3), *(ptr+4), *(ptr+5));
+				}
+			}
+			printf("  IP addr: %s\n", Sock_ntop_host(ifi->ifi_addr,
+					families[i] == AF_INET ? sizeof(struct sockaddr_in) :
+											 sizeof(struct sockaddr_in6)));
+			if (ifi->ifi_brdaddr != NULL)
+				printf("  bcast addr: %s\n", Sock_ntop_host(ifi->ifi_brdaddr,
+						sizeof(struct sockaddr_in)));
+		}
+		free_ifi_info(ifihead);
+	}
+}
+
+/*
+ * Load the routes into longest prefix match tables (rtlpm.c) and print
+ * the route each address would take.  The next hop number of a prefix
+ * is one more than the index of the first route with the same gateway,
+ * interface, and type, so all the routes through one router share a
+ * next hop.  As in the kernel, the local table has its own LPM table,
+ * searched first; the main one is searched only if it has no match.
+ */
+void
+pr_lookup(int family, char **addrs)
+{
+	int				i, j, k, n, nh, nnh, fam;
+	int				*nhroute;		/* next hop -> index in routes[] */
+	char			ifname[IF_NAMESIZE];
+	struct rtroute	*routes, *rt, *r2;
+	struct rtlpm	*lpm[2];		/* [0] local, [1] main */
+	struct in_addr	in4;
+	struct in6_addr	in6;
+
+	if ( (n = rtnl_routes(family, &routes)) < 0)
+		err_sys("rtnl_routes error");
+	for (k = 0; k < 2; k++)
+		if ( (lpm[k] = rtlpm_alloc()) == NULL)
+			err_sys("rtlpm_alloc error");
+	nhroute = Malloc((n + 1) * sizeof(int));
+
+	for (nnh = i = 0; i < n; i++) {
+		rt = &routes[i];
+		for (nh = 1; nh <= nnh; nh++) {
+			r2 = &routes[nhroute[nh]];
+			if (r2->rt_family == rt->rt_family &&
+				r2->rt_ifindex == rt->rt_ifindex &&
+				r2->rt_type == rt->rt_type && r2->rt_hasgw == rt->rt_hasgw &&
+				memcmp(r2->rt_gw, rt->rt_gw, sizeof(rt->rt_gw)) == 0)
+				break;
+		}
+		if (nh > nnh) {
+			if (nnh == RTLPM_MAXNH)
+				err_quit("more than %d next hops", RTLPM_MAXNH);
+			nhroute[nh = ++nnh] = i;
+		}
+		k = (rt->rt_table == RT_TABLE_LOCAL) ? 0 : 1;
+		if (rtlpm_add(lpm[k], rt->rt_family, rt->rt_dst, rt->rt_plen, nh) < 0)
+			err_quit("rtlpm_add error");
+	}
+	for (k = 0; k < 2; k++)
+		if (rtlpm_build(lpm[k]) < 0)
+			err_quit("rtlpm_build error");
+
+	for (j = 0; addrs[j] != NULL; j++) {
+		if (inet_pton(AF_INET, addrs[j], &in4) == 1)
+			fam = AF_INET;
+		else if (inet_pton(AF_INET6, addrs[j], &in6) == 1)
+			fam = AF_INET6;
+		else {
+			err_msg("%s: not an address", addrs[j]);
+			continue;
+		}
+		for (k = 0, nh = 0; k < 2 && nh == 0; k++)
+			nh = (fam == AF_INET) ? rtlpm_lookup4(lpm[k], ntohl(in4.s_addr))
+								  : rtlpm_lookup6(lpm[k], &in6);
+		printf("%s: ", addrs[j]);
+		if (nh == 0)
+			printf("no route\n");
+		else {
+			rt = &routes[nhroute[nh]];
+			if (rt->rt_hasgw)
+				printf("gateway %s", rt_ntop(rt->rt_family, rt->rt_gw));
+			else if (rt->rt_type == RTN_LOCAL)
+				printf("local");
+			else
+				printf("direct");
+			if (rt->rt_ifindex != 0 && if_indextoname(rt->rt_ifindex, ifname))
+				printf(", interface %s", ifname);
+			printf("\n");
+		}
+	}
+	for (k = 0; k < 2; k++)
+		rtlpm_free(lpm[k]);
+	free(nhroute);
+	free(routes);
+}
+
+#else	/* routing sockets */
+
+void
+pr_lookup(int family, char **addrs)
+{
+	err_quit("lookups need rtnetlink");
+}
+
 void
 pr_rtable(int family)
 {
@@ -106,3 +289,4 @@ pr_iflist(int family)
 			err_quit("unexpected message type %d", ifm->ifm_type);
 	}
 }
+#endif
@@ -0,0 +1,196 @@
+/*
+ * Lookups per second in the longest prefix match tables of rtlpm.c,
+ * loaded with a synthetic table the size of a full Internet routing
+ * table: by default 900,000 IPv4 prefixes, mostly /24s with some /16
+ * to /23 and a few longer than /24, and 200,000 IPv6 prefixes in
+ * 2000::/3, mostly /48 and /32 to /44.  Half of the addresses looked up
+ * fall inside a prefix of the table and half are random.  A sample of
+ * the results is checked against a linear search.
+ */
+
+#include	"unprtnl.h"
+
+#define	NADDR	(1 << 20)		/* addresses to look up, used over and over */
+#define	NLOOP	20				/* times through them */
+#define	NCHECK	200				/* lookups checked by linear search */
+#define	NNH		256				/* next hops */
+
+struct pfx {
+  u_char	p_addr[16];
+  int		p_plen;
+  int		p_nh;
+};
+
+static uint64_t	seed = 88172645463325252ULL;
+
+static uint32_t
+rnd(void)						/* xorshift64 */
+{
+	seed ^= seed << 13;
+	seed ^= seed >> 7;
+	seed ^= seed << 17;
+	return(seed >> 32);
+}
+
+/* Prefix length from a table of cumulative percentages. */
+static int
+rnd_plen(const int (*dist)[2])
+{
+	int		r;
+
+	r = rnd() % 100;
+	while (r >= (*dist)[1])
+		dist++;
+	return((*dist)[0]);
+}
+
+static const int	dist4[][2] = {
+	{ 8, 1 }, { 12, 2 }, { 16, 6 }, { 19, 9 }, { 20, 14 }, { 21, 19 },
+	{ 22, 29 }, { 23, 39 }, { 24, 98 }, { 28, 99 }, { 32, 100 }
+};
+static const int	dist6[][2] = {
+	{ 29, 5 }, { 32, 20 }, { 36, 25 }, { 40, 35 }, { 44, 45 },
+	{ 48, 95 }, { 56, 98 }, { 64, 100 }
+};
+
+static void
+make_pfx(struct pfx *p, int family)
+{
+	int		i, alen;
+
+	alen = (family == AF_INET) ? 4 : 16;
+	for (i = 0; i < alen; i += 4)
+		*(uint32_t *) &p->p_addr[i] = rnd();
+	if (family == AF_INET) {
+		p->p_plen = rnd_plen(dist4);
+		p->p_addr[0] = 1 + p->p_addr[0] % 223;	/* unicast */
+	} else {
+		p->p_plen = rnd_plen(dist6);
+		p->p_addr[0] = 0x20 | (p->p_addr[0] & 0x1f);	/* 2000::/3 */
+	}
+	for (i = p->p_plen; i < alen * 8; i++)		/* zero the host part */
+		p->p_addr[i / 8] &= ~(0x80 >> (i % 8));
+	p->p_nh = 1 + rnd() % NNH;
+}
+
+/* An address inside a random prefix of the table, or a random one. */
+static void
+make_addr(u_char *addr, const struct pfx *pfx, int npfx, int family)
+{
+	int					i, alen;
+	const struct pfx	*p;
+
+	alen = (family == AF_INET) ? 4 : 16;
+	for (i = 0; i < alen; i += 4)
+		*(uint32_t *) &addr[i] = rnd();
+	if (rnd() & 1) {
+		p = &pfx[rnd() % npfx];
+		for (i = 0; i < p->p_plen; i++) {
+			addr[i / 8] &= ~(0x80 >> (i % 8));
+			addr[i / 8] |= p->p_addr[i / 8] & (0x80 >> (i % 8));
+		}
+	}
+}
+
+/* The answer the hard way: the longest prefix, the first of equals. */
+static int
+linear(const u_char *addr, const struct pfx *pfx, int npfx)
+{
+	int		i, j, best, bestlen;
+
+	best = 0;
+	bestlen = -1;
+	for (i = 0; i < npfx; i++) {
+		if (pfx[i].p_plen <= bestlen)
+			continue;
+		for (j = 0; j < pfx[i].p_plen / 8; j++)
+			if (addr[j] != pfx[i].p_addr[j])
+				break;
+		if (j < pfx[i].p_plen / 8)
+			continue;
+		if (pfx[i].p_plen % 8 != 0 &&
+			((addr[j] ^ pfx[i].p_addr[j]) & (0xff00 >> (pfx[i].p_plen % 8))))
+			continue;
+		best = pfx[i].p_nh;
+		bestlen = pfx[i].p_plen;
+	}
+	return(best);
+}
+
+static int
+lookup(struct rtlpm *lpm, int family, const u_char *addr)
+{
+	uint32_t	a4;
+
+	if (family == AF_INET6)
+		return(rtlpm_lookup6(lpm, (const struct in6_addr *) addr));
+	memcpy(&a4, addr, 4);
+	return(rtlpm_lookup4(lpm, ntohl(a4)));
+}
+
+static void
+bench(int family, int npfx)
+{
+	int				i, j, alen, sum;
+	double			sec;
+	u_char			*addrs;
+	struct pfx		*pfx;
+	struct rtlpm	*lpm;
+	struct timeval	start, end;
+
+	alen = (family == AF_INET) ? 4 : 16;
+	pfx = Malloc(npfx * sizeof(struct pfx));
+	addrs = Malloc(NADDR * alen);
+	for (i = 0; i < npfx; i++)
+		make_pfx(&pfx[i], family);
+	for (i = 0; i < NADDR; i++)
+		make_addr(addrs + i * alen, pfx, npfx, family);
+
+	if ( (lpm = rtlpm_alloc()) == NULL)
+		err_sys("rtlpm_alloc error");
+	Gettimeofday(&start, NULL);
+	for (i = 0; i < npfx; i++)
+		if (rtlpm_add(lpm, family, pfx[i].p_addr, pfx[i].p_plen,
+					  pfx[i].p_nh) < 0)
+			err_quit("rtlpm_add error");
+	if (family == AF_INET && rtlpm_build(lpm) < 0)
+		err_quit("rtlpm_build error");
+	Gettimeofday(&end, NULL);
+	tv_sub(&end, &start);
+	printf("%s: %d prefixes loaded in %.0f ms, %.1f MB\n",
+		   family == AF_INET ? "IPv4" : "IPv6", npfx,
+		   end.tv_sec * 1e3 + end.tv_usec / 1e3,
+		   rtlpm_size(lpm, family) / 1048576.0);
+
+	for (i = 0; i < NCHECK; i++) {
+		if (lookup(lpm, family, addrs + i * alen) !=
+			linear(addrs + i * alen, pfx, npfx))
+			err_quit("lookup %d does not match the linear search", i);
+	}
+
+	sum = 0;
+	Gettimeofday(&start, NULL);
+	for (j = 0; j < NLOOP; j++)
+		for (i = 0; i < NADDR; i++)
+			sum += lookup(lpm, family, addrs + i * alen);
+	Gettimeofday(&end, NULL);
+	tv_sub(&end, &start);
+	sec = end.tv_sec + end.tv_usec / 1e6;
+	printf("  %.1f million lookups/sec, %.1f ns each (checksum %d)\n",
+		   NLOOP * (double) NADDR / sec / 1e6, sec * 1e9 / NLOOP / NADDR, sum);
+
+	rtlpm_free(lpm);
+	free(addrs);
+	free(pfx);
+}
+
+int
+main(int argc, char **argv)
+{
+	if (argc > 3)
+		err_quit("usage: rtbench [ #IPv4prefixes [ #IPv6prefixes ] ]");
+
+	bench(AF_INET, argc > 1 ? atoi(argv[1]) : 900000);
+	bench(AF_INET6, argc > 2 ? atoi(argv[2]) : 200000);
+	exit(0);
+}
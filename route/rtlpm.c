@@ -0,0 +1,374 @@
+/*
+ * Longest prefix match over a routing table, for lookups at a rate a
+ * linear search of the rtroute{}s could never sustain.
+ *
+ * IPv4 uses DIR-24-8: a table of 2^24 16-bit entries indexed by the top
+ * 24 bits of the address, each either a next hop or, with the top bit
+ * set, the number of a group of 256 entries indexed by the low 8 bits
+ * for the few /24s that contain longer prefixes.  A lookup is one or
+ * two memory references.  The 32 MB table is calloc'ed, so only the
+ * pages that routes cover are ever touched.  The prefixes are collected
+ * by rtlpm_add() and rtlpm_build() writes them all, shortest first, so
+ * that longer prefixes simply overwrite the entries they cover; it must
+ * be called after the last add.  Until it has been, or if it fails,
+ * every IPv4 lookup finds no route.
+ *
+ * IPv6 indexes a table of 2^16 slots by the top 16 bits of the address.
+ * A slot holds the next hop of the longest prefix of 16 bits or less
+ * that covers it, and the root of a path-compressed binary trie of the
+ * longer prefixes that start with those 16 bits.  A trie node exists
+ * only where a prefix ends or two prefixes diverge, and a lookup compares
+ * whole 64-bit words rather than stepping one bit at a time.  The first
+ * level takes out the dozen or so levels the binary trie would need at
+ * the top, where a full table is densest.  The nodes live in one array
+ * and refer to each other by index.
+ *
+ * Next hops are small integers from the caller, 1 to RTLPM_MAXNH; a
+ * lookup that matches nothing returns 0.  If the same prefix is added
+ * twice, the first one wins, as the kernel lists the route with the
+ * lowest metric first.
+ */
+
+#include	"unprtnl.h"
+
+#define	TBL24_SIZE	(1 << 24)
+#define	TBL8_FLAG	0x8000		/* entry is a group number, not a next hop */
+#define	TBL8_MAX	0x8000		/* # groups the 15 bits can number */
+#define	TBL8_BYTES	(256 * sizeof(uint16_t))
+
+struct pfx4 {
+  uint32_t	p_addr;				/* host byte order */
+  int		p_plen;
+  int		p_nh;
+  int		p_seq;				/* order added */
+};
+
+struct node6 {
+  uint64_t	n_hi, n_lo;			/* prefix, host byte order, masked */
+  uint32_t	n_child[2];			/* index in l_node, 0 if none */
+  uint16_t	n_plen;
+  uint16_t	n_nh;
+};
+
+struct slot6 {
+  uint32_t	s_root;				/* trie of the longer prefixes, 0 if none */
+  uint16_t	s_nh;				/* longest prefix of 16 bits or less */
+  uint16_t	s_plen;				/* and its length */
+};
+
+struct rtlpm {
+  uint16_t		*l_tbl24;
+  uint16_t		*l_tbl8;		/* groups of 256 */
+  int			 l_ntbl8;
+  struct pfx4	*l_pfx4;		/* all added, for rtlpm_build() */
+  int			 l_npfx4, l_maxpfx4;
+
+  struct node6	*l_node;		/* l_node[0] is unused, so 0 means none */
+  uint32_t		 l_nnode, l_maxnode;
+  struct slot6	*l_slot6;		/* 2^16 of them */
+};
+
+struct rtlpm *
+rtlpm_alloc(void)
+{
+	struct rtlpm	*lpm;
+
+	if ( (lpm = calloc(1, sizeof(struct rtlpm))) == NULL)
+		return(NULL);
+	lpm->l_nnode = 1;
+	return(lpm);
+}
+
+void
+rtlpm_free(struct rtlpm *lpm)
+{
+	free(lpm->l_tbl24);
+	free(lpm->l_tbl8);
+	free(lpm->l_pfx4);
+	free(lpm->l_node);
+	free(lpm->l_slot6);
+	free(lpm);
+}
+
+/* Bytes the table for "family" takes. */
+size_t
+rtlpm_size(const struct rtlpm *lpm, int family)
+{
+	if (family == AF_INET)
+		return((lpm->l_tbl24 ? TBL24_SIZE : 0) * sizeof(uint16_t) +
+			   lpm->l_ntbl8 * TBL8_BYTES);
+	return((lpm->l_slot6 ? 65536 * sizeof(struct slot6) : 0) +
+		   lpm->l_nnode * sizeof(struct node6));
+}
+
+/* include rtlpm_lookup4 */
+int
+rtlpm_lookup4(const struct rtlpm *lpm, uint32_t addr)
+		/* addr in host byte order */
+{
+	int		e;
+
+	if (lpm->l_tbl24 == NULL)
+		return(0);				/* not built */
+	e = lpm->l_tbl24[addr >> 8];
+	if (e & TBL8_FLAG)
+		e = lpm->l_tbl8[((e & ~TBL8_FLAG) << 8) | (addr & 0xff)];
+	return(e);
+}
+/* end rtlpm_lookup4 */
+
+static int
+pfx4_cmp(const void *a1, const void *a2)
+{
+	const struct pfx4	*p1 = a1, *p2 = a2;
+
+	if (p1->p_plen != p2->p_plen)
+		return(p1->p_plen - p2->p_plen);
+	return(p2->p_seq - p1->p_seq);		/* first added is written last */
+}
+
+/* Write the IPv4 prefixes added so far into the tables. */
+int
+rtlpm_build(struct rtlpm *lpm)
+{
+	int				i, g, idx, n;
+	uint16_t		e, *ptr;
+	struct pfx4		*p;
+
+		/* 4start over: fresh zero pages cost nothing until written */
+	free(lpm->l_tbl24);
+	if ( (lpm->l_tbl24 = calloc(TBL24_SIZE, sizeof(uint16_t))) == NULL)
+		return(-1);
+	lpm->l_ntbl8 = 0;
+	qsort(lpm->l_pfx4, lpm->l_npfx4, sizeof(struct pfx4), pfx4_cmp);
+
+	for (i = 0; i < lpm->l_npfx4; i++) {
+		p = &lpm->l_pfx4[i];
+		if (p->p_plen <= 24) {
+				/* 4no groups yet: they come from the longer ones, later */
+			idx = p->p_addr >> 8;
+			for (n = 1 << (24 - p->p_plen); n > 0; n--)
+				lpm->l_tbl24[idx++] = p->p_nh;
+			continue;
+		}
+
+		idx = p->p_addr >> 8;
+		if ( ((e = lpm->l_tbl24[idx]) & TBL8_FLAG) == 0) {
+				/* 4new group, starting out as the /24 it replaces */
+			if (lpm->l_ntbl8 == TBL8_MAX)
+				goto bad;
+			g = lpm->l_ntbl8++;
+			if ((g & (g - 1)) == 0) {	/* 0, 1, 2, 4, ...: double */
+				n = (g == 0) ? 1 : 2 * g;
+				if ( (ptr = realloc(lpm->l_tbl8, n * TBL8_BYTES)) == NULL)
+					goto bad;
+				lpm->l_tbl8 = ptr;
+			}
+			for (n = 0; n < 256; n++)
+				lpm->l_tbl8[g * 256 + n] = e;
+			lpm->l_tbl24[idx] = e = TBL8_FLAG | g;
+		}
+		ptr = &lpm->l_tbl8[((e & ~TBL8_FLAG) << 8) | (p->p_addr & 0xff)];
+		for (n = 1 << (32 - p->p_plen); n > 0; n--)
+			*ptr++ = p->p_nh;
+	}
+	return(0);
+
+bad:
+	free(lpm->l_tbl24);		/* half built: lookups find nothing */
+	lpm->l_tbl24 = NULL;
+	return(-1);
+}
+
+	/* bit "i" of the address, counting from the most significant */
+#define	BIT6(hi, lo, i)	((i) < 64 ? ((hi) >> (63 - (i))) & 1 : \
+									((lo) >> (127 - (i))) & 1)
+
+/* Nonzero if the first "plen" bits of the address and the node match. */
+static int
+match6(const struct node6 *n, uint64_t hi, uint64_t lo)
+{
+	if (n->n_plen <= 64)
+		return(n->n_plen == 0 ||
+			   ((hi ^ n->n_hi) >> (64 - n->n_plen)) == 0);
+	return(hi == n->n_hi &&
+		   ((lo ^ n->n_lo) >> (128 - n->n_plen)) == 0);
+}
+
+/* Number of leading bits two addresses have in common. */
+static int
+common6(uint64_t hi1, uint64_t lo1, uint64_t hi2, uint64_t lo2)
+{
+	if (hi1 != hi2)
+		return(__builtin_clzll(hi1 ^ hi2));
+	if (lo1 != lo2)
+		return(64 + __builtin_clzll(lo1 ^ lo2));
+	return(128);
+}
+
+static void
+load6(const struct in6_addr *addr, uint64_t *hi, uint64_t *lo)
+{
+	uint32_t	w[4];
+
+	memcpy(w, addr->s6_addr, 16);
+	*hi = ((uint64_t) ntohl(w[0]) << 32) | ntohl(w[1]);
+	*lo = ((uint64_t) ntohl(w[2]) << 32) | ntohl(w[3]);
+}
+
+static void
+mask6(uint64_t *hi, uint64_t *lo, int plen)
+{
+	if (plen <= 64) {
+		*hi = (plen == 0) ? 0 : *hi & (~0ULL << (64 - plen));
+		*lo = 0;
+	} else if (plen < 128)
+		*lo &= ~0ULL << (128 - plen);
+}
+
+static uint32_t
+node6_new(struct rtlpm *lpm, uint64_t hi, uint64_t lo, int plen, int nh)
+{
+	struct node6	*n;
+
+	n = &lpm->l_node[lpm->l_nnode];
+	n->n_hi = hi;
+	n->n_lo = lo;
+	n->n_plen = plen;
+	n->n_nh = nh;
+	n->n_child[0] = n->n_child[1] = 0;
+	return(lpm->l_nnode++);
+}
+
+static int
+rtlpm_add6(struct rtlpm *lpm, const struct in6_addr *prefix, int plen, int nh)
+{
+	int				c;
+	uint32_t		*link, new, slot;
+	uint64_t		hi, lo, shi, slo;
+	struct node6	*n, *ptr;
+	struct slot6	*sp;
+
+		/* 4room for the two nodes a split can take, so pointers stay valid */
+	if (lpm->l_nnode + 2 > lpm->l_maxnode) {
+		new = lpm->l_maxnode ? 2 * lpm->l_maxnode : 1024;
+		if ( (ptr = realloc(lpm->l_node, new * sizeof(struct node6))) == NULL)
+			return(-1);
+		lpm->l_node = ptr;
+		lpm->l_maxnode = new;
+	}
+
+	if (lpm->l_slot6 == NULL &&
+		(lpm->l_slot6 = calloc(65536, sizeof(struct slot6))) == NULL)
+		return(-1);
+
+	load6(prefix, &hi, &lo);
+	mask6(&hi, &lo, plen);
+
+	if (plen <= 16) {
+			/* 4every slot it covers, unless a longer one got there first */
+		for (slot = hi >> 48; slot < (hi >> 48) + (1 << (16 - plen)); slot++) {
+			sp = &lpm->l_slot6[slot];
+			if (sp->s_nh == 0 || plen > sp->s_plen) {
+				sp->s_nh = nh;
+				sp->s_plen = plen;
+			}
+		}
+		return(0);
+	}
+
+	for (link = &lpm->l_slot6[hi >> 48].s_root; *link != 0;
+		 link = &n->n_child[BIT6(hi, lo, n->n_plen)]) {
+		n = &lpm->l_node[*link];
+		c = common6(hi, lo, n->n_hi, n->n_lo);
+		c = min(c, min(n->n_plen, plen));
+		if (c < n->n_plen) {
+				/* 4diverges inside this node's prefix: split it at c */
+			shi = hi;
+			slo = lo;
+			mask6(&shi, &slo, c);
+			new = node6_new(lpm, shi, slo, c, (c == plen) ? nh : 0);
+			lpm->l_node[new].n_child[BIT6(n->n_hi, n->n_lo, c)] = *link;
+			if (c < plen)
+				lpm->l_node[new].n_child[BIT6(hi, lo, c)] =
+									node6_new(lpm, hi, lo, plen, nh);
+			*link = new;
+			return(0);
+		}
+		if (n->n_plen == plen) {
+			if (n->n_nh == 0)			/* first one added wins */
+				n->n_nh = nh;
+			return(0);
+		}
+	}
+	*link = node6_new(lpm, hi, lo, plen, nh);
+	return(0);
+}
+
+/* include rtlpm_lookup6 */
+int
+rtlpm_lookup6(const struct rtlpm *lpm, const struct in6_addr *addr)
+{
+	int					best;
+	uint32_t			i;
+	uint64_t			hi, lo;
+	const struct node6	*n;
+	const struct slot6	*sp;
+
+	if (lpm->l_slot6 == NULL)
+		return(0);
+	load6(addr, &hi, &lo);
+
+	sp = &lpm->l_slot6[hi >> 48];
+	best = sp->s_nh;
+	for (i = sp->s_root; i != 0; i = n->n_child[BIT6(hi, lo, n->n_plen)]) {
+		n = &lpm->l_node[i];
+		if (!match6(n, hi, lo))
+			break;
+		if (n->n_nh != 0)
+			best = n->n_nh;
+		if (n->n_plen == 128)
+			break;
+	}
+	return(best);
+}
+/* end rtlpm_lookup6 */
+
+/*
+ * Add a prefix ("plen" bits of the address at "prefix", in network byte
+ * order) with next hop "nh".  IPv4 prefixes take effect at the next
+ * rtlpm_build().
+ */
+int
+rtlpm_add(struct rtlpm *lpm, int family, const void *prefix, int plen, int nh)
+{
+	int				n;
+	uint32_t		addr;
+	struct pfx4		*p;
+
+	if (nh <= 0 || nh > RTLPM_MAXNH)
+		return(-1);
+	if (family == AF_INET6) {
+		if (plen < 0 || plen > 128)
+			return(-1);
+		return(rtlpm_add6(lpm, prefix, plen, nh));
+	}
+	if (family != AF_INET || plen < 0 || plen > 32)
+		return(-1);
+
+	if (lpm->l_npfx4 == lpm->l_maxpfx4) {
+		n = lpm->l_maxpfx4 ? 2 * lpm->l_maxpfx4 : 256;
+		if ( (p = realloc(lpm->l_pfx4, n * sizeof(struct pfx4))) == NULL)
+			return(-1);
+		lpm->l_pfx4 = p;
+		lpm->l_maxpfx4 = n;
+	}
+	memcpy(&addr, prefix, 4);
+	addr = ntohl(addr);
+	p = &lpm->l_pfx4[lpm->l_npfx4];
+	p->p_addr = (plen == 0) ? 0 : addr & (~0U << (32 - plen));
+	p->p_plen = plen;
+	p->p_nh = nh;
+	p->p_seq = lpm->l_npfx4++;
+	return(0);
+}
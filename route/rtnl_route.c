@@ -0,0 +1,156 @@
+/*
+ * Dump the local and main routing tables over rtnetlink, the Linux
+ * counterpart of net_rt_dump() in libroute, which needs sysctl() and
+ * routing sockets.  Each RTM_NEWROUTE message in the reply becomes an
+ * rtroute{}, with rt_table saying which table it is from; routes in the
+ * default and policy routing tables are skipped.  The kernel looks in
+ * the local table (the host's own and broadcast addresses, and
+ * 127.0.0.0/8) before the main one, and a match there wins whatever its
+ * prefix length, so a caller doing lookups must do the same.  For a
+ * multipath route only the first next hop is kept.
+ */
+
+#include	"unprtnl.h"
+
+#ifdef	__linux__
+#include	<linux/netlink.h>
+#include	<linux/rtnetlink.h>
+
+#define	RTNL_BUFSIZE	32768
+
+/* Fill in *rt from an RTM_NEWROUTE message; return 0, or -1 to skip it. */
+static int
+rtnl_parse(struct nlmsghdr *nh, struct rtroute *rt)
+{
+	int					len, table, alen, sublen;
+	struct rtmsg		*rtm;
+	struct rtattr		*rta, *sub;
+	struct rtnexthop	*rtnh;
+
+	rtm = NLMSG_DATA(nh);
+	if (rtm->rtm_family != AF_INET && rtm->rtm_family != AF_INET6)
+		return(-1);
+	alen = (rtm->rtm_family == AF_INET) ? 4 : 16;
+	bzero(rt, sizeof(*rt));
+	rt->rt_family = rtm->rtm_family;
+	rt->rt_plen = rtm->rtm_dst_len;
+	rt->rt_type = rtm->rtm_type;
+	table = rtm->rtm_table;
+
+	len = RTM_PAYLOAD(nh);
+	for (rta = RTM_RTA(rtm); RTA_OK(rta, len); rta = RTA_NEXT(rta, len)) {
+		switch (rta->rta_type) {
+		case RTA_TABLE:
+			table = *(uint32_t *) RTA_DATA(rta);
+			break;
+		case RTA_DST:
+			memcpy(rt->rt_dst, RTA_DATA(rta), alen);
+			break;
+		case RTA_GATEWAY:
+			memcpy(rt->rt_gw, RTA_DATA(rta), alen);
+			rt->rt_hasgw = 1;
+			break;
+		case RTA_OIF:
+			rt->rt_ifindex = *(int *) RTA_DATA(rta);
+			break;
+		case RTA_PRIORITY:
+			rt->rt_priority = *(uint32_t *) RTA_DATA(rta);
+			break;
+		case RTA_MULTIPATH:				/* first next hop only */
+			rtnh = RTA_DATA(rta);
+			if (RTA_PAYLOAD(rta) < sizeof(*rtnh))
+				break;
+			rt->rt_ifindex = rtnh->rtnh_ifindex;
+			sublen = rtnh->rtnh_len - sizeof(*rtnh);
+			for (sub = RTNH_DATA(rtnh); RTA_OK(sub, sublen);
+				 sub = RTA_NEXT(sub, sublen)) {
+				if (sub->rta_type == RTA_GATEWAY) {
+					memcpy(rt->rt_gw, RTA_DATA(sub), alen);
+					rt->rt_hasgw = 1;
+				}
+			}
+			break;
+		}
+	}
+	rt->rt_table = table;
+	return((table == RT_TABLE_MAIN || table == RT_TABLE_LOCAL) ? 0 : -1);
+}
+
+/* include rtnl_routes */
+int
+rtnl_routes(int family, struct rtroute **routesp)
+{
+	int				fd, n, nroute, maxroute, done;
+	char			*buf;
+	struct nlmsghdr	*nh;
+	struct rtroute	*routes, *ptr;
+	struct {
+	  struct nlmsghdr	nh;
+	  struct rtmsg		rtm;
+	} req;
+
+	if ( (fd = socket(AF_NETLINK, SOCK_RAW, NETLINK_ROUTE)) < 0)
+		return(-1);
+	bzero(&req, sizeof(req));
+	req.nh.nlmsg_len = sizeof(req);
+	req.nh.nlmsg_type = RTM_GETROUTE;
+	req.nh.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+	req.nh.nlmsg_seq = 1;
+	req.rtm.rtm_family = family;		/* AF_UNSPEC for both */
+	if (send(fd, &req, sizeof(req), 0) != sizeof(req)) {
+		close(fd);
+		return(-1);
+	}
+
+	buf = Malloc(RTNL_BUFSIZE);
+	routes = NULL;
+	nroute = maxroute = 0;
+	for (done = 0; !done; ) {
+		if ( (n = recv(fd, buf, RTNL_BUFSIZE, 0)) <= 0)
+			goto bad;
+		for (nh = (struct nlmsghdr *) buf; NLMSG_OK(nh, n);
+			 nh = NLMSG_NEXT(nh, n)) {
+			if (nh->nlmsg_type == NLMSG_DONE) {
+				done = 1;
+				break;
+			}
+			if (nh->nlmsg_type == NLMSG_ERROR) {
+				errno = -((struct nlmsgerr *) NLMSG_DATA(nh))->error;
+				goto bad;
+			}
+			if (nh->nlmsg_type != RTM_NEWROUTE)
+				continue;
+			if (nroute == maxroute) {
+				maxroute = maxroute ? 2 * maxroute : 64;
+				if ( (ptr = realloc(routes, maxroute * sizeof(*ptr))) == NULL)
+					goto bad;
+				routes = ptr;
+			}
+			if (rtnl_parse(nh, &routes[nroute]) == 0)
+				nroute++;
+		}
+	}
+	free(buf);
+	close(fd);
+	*routesp = routes;
+	return(nroute);
+
+bad:
+	n = errno;
+	free(buf);
+	free(routes);
+	close(fd);
+	errno = n;
+	return(-1);
+}
+/* end rtnl_routes */
+
+#else	/* not Linux */
+
+int
+rtnl_routes(int family, struct rtroute **routesp)
+{
+	errno = ENOSYS;
+	return(-1);
+}
+#endif
@@ -0,0 +1,40 @@
+/* Our own header for the Linux routing table programs in this directory,
+   which use rtnetlink where the others use routing sockets and sysctl.
+   Include this file, instead of "unproute.h". */
+
+#ifndef	__unp_rtnl_h
+#define	__unp_rtnl_h
+
+#include	"unp.h"
+#ifdef	__linux__
+#include	<linux/rtnetlink.h>	/* RTN_xxx constants */
+#endif
+
+struct rtroute {				/* one route from the local or main table */
+  int		rt_table;			/* RT_TABLE_LOCAL or RT_TABLE_MAIN */
+  int		rt_family;			/* AF_INET or AF_INET6 */
+  int		rt_plen;			/* prefix length */
+  u_char	rt_dst[16];			/* prefix, network byte order */
+  u_char	rt_gw[16];			/* gateway, if rt_hasgw */
+  int		rt_hasgw;
+  int		rt_ifindex;			/* outgoing interface, 0 if none */
+  int		rt_type;			/* RTN_UNICAST, RTN_BLACKHOLE, ... */
+  uint32_t	rt_priority;		/* metric */
+};
+
+#define	RTLPM_MAXNH	0x7fff		/* next hops are 1 to this, 0 is none */
+
+struct rtlpm;					/* opaque, see rtlpm.c */
+
+			/* function prototypes */
+int		 rtnl_routes(int, struct rtroute **);
+
+struct rtlpm	*rtlpm_alloc(void);
+int		 rtlpm_add(struct rtlpm *, int, const void *, int, int);
+int		 rtlpm_build(struct rtlpm *);
+int		 rtlpm_lookup4(const struct rtlpm *, uint32_t);
+int		 rtlpm_lookup6(const struct rtlpm *, const struct in6_addr *);
+size_t	 rtlpm_size(const struct rtlpm *, int);
+void	 rtlpm_free(struct rtlpm *);
+
+#endif	/* __unp_rtnl_h */
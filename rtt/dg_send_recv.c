@@ -11,6 +11,9 @@ static struct hdr {
   uint32_t	seq;	/* sequence # */
   uint32_t	ts;		/* timestamp when sent */
 } sendhdr, recvhdr;
+static int	tsflags;		/* TSTAMP_xxx enabled on the socket */
+static struct timespec	tssend, tsrecv;
+static char	controlbuf[256];	/* receive timestamp, if any */
 
 static void	sig_alrm(int signo);
 static sigjmp_buf	jmpbuf;
@@ -21,12 +24,15 @@ dg_send_recv(int fd, const void *outbuff, size_t outbytes,
 			 const SA *destaddr, socklen_t destlen)
 {
 	ssize_t			n;
+	uint32_t		id;
+	struct timespec	ts;
 	struct iovec	iovsend[2], iovrecv[2];
 
 	if (rttinit == 0) {
 		rtt_init(&rttinfo);		/* first time we're called */
 		rttinit = 1;
 		rtt_d_flag = 1;
+		tsflags = tstamp_enable(fd, TSTAMP_RX | TSTAMP_TX);
 	}
 
 	sendhdr.seq++;
@@ -47,6 +53,7 @@ dg_send_recv(int fd, const void *outbuff, size_t outbytes,
 	iovrecv[0].iov_len = sizeof(struct hdr);
 	iovrecv[1].iov_base = inbuff;
 	iovrecv[1].iov_len = inbytes;
+	msgrecv.msg_control = controlbuf;
 /* end dgsendrecv1 */
 
 /* include dgsendrecv2 */
@@ -58,6 +65,7 @@ sendagain:
 	fprintf(stderr, "send %4d: ", sendhdr.seq);
 #endif
 	sendhdr.ts = rtt_ts(&rttinfo);
+	tstamp_now(&tssend);
 	Sendmsg(fd, &msgsend, 0);
 
 	alarm(rtt_start(&rttinfo));	/* calc timeout value & start timer */
@@ -79,6 +87,7 @@ sendagain:
 	}
 
 	do {
+		msgrecv.msg_controllen = sizeof(controlbuf);
 		n = Recvmsg(fd, &msgrecv, 0);
 #ifdef	RTT_DEBUG
 		fprintf(stderr, "recv %4d\n", recvhdr.seq);
@@ -87,7 +96,16 @@ sendagain:
 
 	alarm(0);			/* stop SIGALRM timer */
 		/* 4calculate & store new RTT estimator values */
-	rtt_stop(&rttinfo, rtt_ts(&rttinfo) - recvhdr.ts);
+	if (recvhdr.ts == sendhdr.ts) {
+			/* reply to our latest send: use the kernel's timestamps */
+		if (tsflags & TSTAMP_TX)
+			while (Tstamp_txreap(fd, &id, &ts) > 0)
+				tssend = ts;		/* the last one is for our latest send */
+		if (tstamp_recv(&msgrecv, &tsrecv) == 0)
+			tstamp_now(&tsrecv);
+		rtt_stop_ts(&rttinfo, &tssend, &tsrecv);
+	} else
+		rtt_stop(&rttinfo, rtt_ts(&rttinfo) - recvhdr.ts);
 
 	return(n - sizeof(struct hdr));	/* return size of received datagram */
 }
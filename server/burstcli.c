@@ -0,0 +1,94 @@
+/*
+ * Bursty load for comparing a fixed pool of children with serv11's pool
+ * that grows and shrinks.  Every <ms/burst> ms a burst of <#conns/burst>
+ * clients connect at once, each a thread; each client makes <#requests>
+ * requests of <#bytes> on its connection, pausing <thinkms> ms between
+ * them, so that it keeps a child busy for a while as a keep-alive client
+ * would.  What is measured is the time from the start of connect() to
+ * the end of the first reply, which includes any time spent waiting in
+ * the listen queue for a free child.
+ */
+
+#include	"unpthread.h"
+
+#define	MAXN	16384		/* max # bytes to request from server */
+
+static char		*host, *port;
+static int		nrequest, nbytes, thinkms;
+static double	*lat;		/* ms, one per connection */
+
+static void *
+client(void *arg)
+{
+	int				i, fd;
+	ssize_t			n;
+	char			request[MAXLINE], reply[MAXN];
+	struct timeval	start, end;
+
+	snprintf(request, sizeof(request), "%d\n", nbytes);
+	Gettimeofday(&start, NULL);
+	fd = Tcp_connect(host, port);
+	for (i = 0; i < nrequest; i++) {
+		if (i > 0)
+			poll(NULL, 0, thinkms);
+		Write(fd, request, strlen(request));
+		if ( (n = Readn(fd, reply, nbytes)) != nbytes)
+			err_quit("server returned %d bytes", n);
+		if (i == 0) {
+			Gettimeofday(&end, NULL);
+			tv_sub(&end, &start);
+			lat[(long) arg] = end.tv_sec * 1e3 + end.tv_usec / 1e3;
+		}
+	}
+	Close(fd);
+	return(NULL);
+}
+
+static int
+dblcmp(const void *a, const void *b)
+{
+	double	x = *(const double *) a, y = *(const double *) b;
+
+	return(x < y ? -1 : x > y);
+}
+
+int
+main(int argc, char **argv)
+{
+	int			i, j, nburst, nconn, burstms, n;
+	pthread_t	*tids;
+
+	if (argc != 9)
+		err_quit("usage: burstcli <hostname or IPaddr> <port> <#bursts> "
+				 "<#conns/burst> <ms/burst> <#requests/conn> <thinkms> "
+				 "<#bytes/request>");
+	host = argv[1];
+	port = argv[2];
+	nburst = atoi(argv[3]);
+	nconn = atoi(argv[4]);
+	burstms = atoi(argv[5]);
+	nrequest = atoi(argv[6]);
+	thinkms = atoi(argv[7]);
+	nbytes = atoi(argv[8]);
+	if (nbytes <= 0 || nbytes > MAXN || nrequest < 1)
+		err_quit("#bytes/request must be 1 to %d, #requests/conn >= 1", MAXN);
+
+	n = nburst * nconn;
+	lat = Calloc(n, sizeof(double));
+	tids = Calloc(n, sizeof(pthread_t));
+	for (i = 0; i < nburst; i++) {
+		if (i > 0)
+			poll(NULL, 0, burstms);
+		for (j = 0; j < nconn; j++)
+			Pthread_create(&tids[i * nconn + j], NULL, client,
+						   (void *) (long) (i * nconn + j));
+	}
+	for (i = 0; i < n; i++)
+		Pthread_join(tids[i], NULL);
+
+	qsort(lat, n, sizeof(double), dblcmp);
+	printf("%d connections, first reply in ms: p50 %.1f, p90 %.1f, "
+		   "p99 %.1f, max %.1f\n", n, lat[n / 2], lat[n * 9 / 10],
+		   lat[n * 99 / 100], lat[n - 1]);
+	exit(0);
+}
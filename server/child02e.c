@@ -0,0 +1,72 @@
+#include	"unp.h"
+#include	<sys/epoll.h>
+
+#define	MAXACCEPT	4		/* connections taken per wakeup */
+
+pid_t
+child_make(int i, int listenfd, int addrlen)
+{
+	pid_t	pid;
+	void	child_main(int, int, int);
+
+	if ( (pid = Fork()) > 0)
+		return(pid);		/* parent */
+
+	child_main(i, listenfd, addrlen);	/* never returns */
+	return(0);							/* not reached */
+}
+
+/*
+ * Every child waits in its own epoll instance, with the listening socket
+ * added EPOLLEXCLUSIVE: a new connection wakes one of them, not all as
+ * select() does in child02l.c, and no lock is needed as in child03.c
+ * and child04.c.  The socket is nonblocking, since the child woken may
+ * still find nothing to accept, and it takes up to MAXACCEPT connections
+ * that are waiting before it waits again.
+ */
+void
+child_main(int i, int listenfd, int addrlen)
+{
+	int					j, n, epfd, connfd[MAXACCEPT];
+	void				web_child(int);
+	socklen_t			clilen;
+	struct sockaddr		*cliaddr;
+	struct epoll_event	ev;
+
+	cliaddr = Malloc(addrlen);
+
+	printf("child %ld starting\n", (long) getpid());
+	Fcntl(listenfd, F_SETFL, Fcntl(listenfd, F_GETFL, 0) | O_NONBLOCK);
+	if ( (epfd = epoll_create1(0)) < 0)
+		err_sys("epoll_create1 error");
+	ev.events = EPOLLIN | EPOLLEXCLUSIVE;
+	ev.data.fd = listenfd;
+	if (epoll_ctl(epfd, EPOLL_CTL_ADD, listenfd, &ev) < 0)
+		err_sys("epoll_ctl error");
+
+	for ( ; ; ) {
+		if (epoll_wait(epfd, &ev, 1, -1) < 0) {
+			if (errno == EINTR)
+				continue;
+			err_sys("epoll_wait error");
+		}
+
+		for (n = 0; n < MAXACCEPT; n++) {
+			clilen = addrlen;
+			if ( (connfd[n] = accept(listenfd, cliaddr, &clilen)) < 0) {
+				if (errno == EAGAIN || errno == EWOULDBLOCK)
+					break;		/* none left */
+				if (errno == EINTR || errno == ECONNABORTED) {
+					n--;
+					continue;
+				}
+				err_sys("accept error");
+			}
+		}
+
+		for (j = 0; j < n; j++) {
+			web_child(connfd[j]);	/* process the request */
+			Close(connfd[j]);
+		}
+	}
+}
@@ -0,0 +1,62 @@
+/* include child_make */
+#include	"unp.h"
+#include	"child10.h"
+
+pid_t
+child_make(int i, int listenfd, int addrlen)
+{
+	int		sockfd[2];
+	pid_t	pid;
+	void	child_main(int, int, int);
+
+	Socketpair(AF_LOCAL, SOCK_STREAM, 0, sockfd);
+
+	if ( (pid = Fork()) > 0) {
+		Close(sockfd[1]);
+		cptr[i].child_pid = pid;
+		cptr[i].child_pipefd = sockfd[0];
+		cptr[i].child_nout = 0;
+		return(pid);		/* parent */
+	}
+
+	Dup2(sockfd[1], STDERR_FILENO);		/* child's stream pipe to parent */
+	Close(sockfd[0]);
+	Close(sockfd[1]);
+	Close(listenfd);					/* child does not need this open */
+	child_main(i, listenfd, addrlen);	/* never returns */
+	return(0);							/* not reached */
+}
+/* end child_make */
+
+/*
+ * Each message from the parent carries up to MAXFDPASS connections, and
+ * more messages may be waiting behind it in the stream pipe: that is the
+ * child's queue, never more than CHILDQ long since the parent counts what
+ * it has passed.  One byte goes back as each connection is finished.
+ */
+/* include child_main */
+void
+child_main(int i, int listenfd, int addrlen)
+{
+	char			c;
+	int				j, nfd, connfd[MAXFDPASS];
+	ssize_t			n;
+	void			web_child(int);
+
+	printf("child %ld starting\n", (long) getpid());
+	for ( ; ; ) {
+		nfd = MAXFDPASS;
+		if ( (n = Read_fds(STDERR_FILENO, &c, 1, connfd, &nfd)) == 0)
+			err_quit("read_fds returned 0");
+		if (nfd == 0)
+			err_quit("no descriptor from read_fds");
+
+		for (j = 0; j < nfd; j++) {
+			web_child(connfd[j]);		/* process request */
+			Close(connfd[j]);
+
+			Write(STDERR_FILENO, "", 1);	/* tell parent one is done */
+		}
+	}
+}
+/* end child_main */
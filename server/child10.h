@@ -0,0 +1,13 @@
+#define	CHILDQ	8			/* max connections queued for one child, <= MAXFDPASS */
+
+typedef struct {
+  pid_t		child_pid;		/* process ID */
+  int		child_pipefd;	/* parent's stream pipe to/from child */
+  int		child_nout;		/* # connections passed and not yet done */
+  int		child_heap;		/* its index in heap[] */
+  int		child_npend;	/* # descriptors in child_pend[] */
+  int		child_pend[MAXFDPASS];	/* accepted, not yet passed */
+  long		child_count;	/* # connections handled */
+} Child;
+
+extern Child	*cptr;	/* array of Child structures; calloc'ed */
@@ -0,0 +1,67 @@
+/* include child_make */
+#include	"unp.h"
+#include	"child11.h"
+
+pid_t
+child_make(int i, int listenfd, int addrlen)
+{
+	pid_t	pid;
+	void	child_main(int, int, int);
+
+	board[i].sl_status = SL_IDLE;		/* before it runs: parent counts it */
+	board[i].sl_dying = 0;
+	board[i].sl_count = 0;
+	if ( (pid = Fork()) > 0) {
+		board[i].sl_pid = pid;
+		return(pid);		/* parent */
+	}
+
+	child_main(i, listenfd, addrlen);	/* never returns */
+	return(0);							/* not reached */
+}
+/* end child_make */
+
+static volatile sig_atomic_t	quit;
+
+static void
+sig_term(int signo)
+{
+	quit = 1;
+}
+
+/*
+ * The parent asks an idle child to go away with SIGTERM.  The handler
+ * interrupts accept() rather than restarting it, and if a connection
+ * was accepted just as the signal arrived it is served before exiting.
+ */
+/* include child_main */
+void
+child_main(int i, int listenfd, int addrlen)
+{
+	int				connfd;
+	void			web_child(int);
+	socklen_t		clilen;
+	struct sockaddr	*cliaddr;
+
+	cliaddr = Malloc(addrlen);
+	Signal(SIGINT, SIG_DFL);
+	Signal_intr(SIGTERM, sig_term);
+
+	for ( ; ; ) {
+		if (quit)
+			exit(0);
+		clilen = addrlen;
+		if ( (connfd = accept(listenfd, cliaddr, &clilen)) < 0) {
+			if (errno == EINTR || errno == ECONNABORTED)
+				continue;
+			err_sys("accept error");
+		}
+
+		board[i].sl_status = SL_BUSY;
+		web_child(connfd);		/* process the request */
+		Close(connfd);
+		board[i].sl_count++;
+		board[i].sl_status = SL_IDLE;
+	}
+}
+/* end child_main */
@@ -0,0 +1,16 @@
+/*
+ * The scoreboard: one slot per possible child, in shared memory, so that
+ * the parent can see which children are idle without asking them.
+ */
+#define	SL_EMPTY	0		/* no child in this slot */
+#define	SL_IDLE		1		/* waiting in accept() */
+#define	SL_BUSY		2		/* serving a connection */
+
+typedef struct {
+  pid_t			sl_pid;			/* process ID, set by parent */
+  volatile int	sl_status;		/* SL_xxx, set by the child */
+  int			sl_dying;		/* told to exit; set by parent */
+  volatile long	sl_count;		/* # connections handled */
+} Slot;
+
+extern Slot	*board;	/* maxchildren of them, in shared memory */
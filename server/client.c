@@ -5,33 +5,56 @@
 int
 main(int argc, char **argv)
 {
-	int		i, j, fd, nchildren, nloops, nbytes;
+	int		c, i, j, fd, nchildren, nloops, nbytes;
 	pid_t	pid;
 	ssize_t	n;
 	char	request[MAXLINE], reply[MAXN];
+	struct tcp_opts	opt;
 
+	bzero(&opt, sizeof(opt));
+	opterr = 0;
+	while ( (c = getopt(argc, argv, "fs:")) != -1) {
+		switch (c) {
+		case 'f':
+			opt.to_fastopen = 1;	/* request goes in the SYN */
+			break;
+		case 's':					/* e.g. 127.0.0.0/24: see tcp_srcpool.c */
+			opt.to_srcpool = Tcp_srcpool_alloc(optarg);
+			break;
+		case '?':
+			err_quit("unrecognized option: %c", optopt);
+		}
+	}
+	argc -= optind - 1;
+	argv += optind - 1;
 	if (argc != 6)
-		err_quit("usage: client <hostname or IPaddr> <port> <#children> "
-				 "<#loops/child> <#bytes/request>");
+		err_quit("usage: client [ -f ] [ -s srcaddrs ] <hostname or IPaddr> "
+				 "<port> <#children> <#loops/child> <#bytes/request>");
 
 	nchildren = atoi(argv[3]);
 	nloops = atoi(argv[4]);
 	nbytes = atoi(argv[5]);
 	snprintf(request, sizeof(request), "%d\n", nbytes); /* newline at end */
+	opt.to_data = request;
+	opt.to_datalen = strlen(request);
 
 	for (i = 0; i < nchildren; i++) {
 		if ( (pid = Fork()) == 0) {		/* child */
 			for (j = 0; j < nloops; j++) {
-				fd = Tcp_connect(argv[1], argv[2]);
-
-				Write(fd, request, strlen(request));
+				fd = Tcp_connect_opt(argv[1], argv[2], &opt);	/* sends request */
 
 				if ( (n = Readn(fd, reply, nbytes)) != nbytes)
 					err_quit("server returned %d bytes", n);
 
 				Close(fd);		/* TIME_WAIT on client, not server */
 			}
-			printf("child %d done\n", i);
+			if (opt.to_srcpool != NULL)
+				printf("child %d done, %ld connections from %d addresses, "
+					   "%ld times out of ports\n", i,
+					   opt.to_srcpool->sp_nconnect, opt.to_srcpool->sp_n,
+					   opt.to_srcpool->sp_nexhaust);
+			else
+				printf("child %d done\n", i);
 			exit(0);
 		}
 		/* parent loops around to fork() again */
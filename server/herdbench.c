@@ -0,0 +1,206 @@
+/*
+ * How many children does each connection wake?  For each way the
+ * preforked servers have their children wait for a connection, fork
+ * -n children that do nothing but accept and close, then make -c
+ * connections one at a time, each after the last has been closed, so
+ * that every one arrives with all the children waiting.  Two numbers
+ * per connection are printed: the times a child came back from waiting
+ * to call accept(), and the children's voluntary context switches, from
+ * getrusage().  The second is the one that shows the herd: a child woken
+ * in select(), a lock or accept() that finds another got there first is
+ * put back to sleep by the kernel without ever returning, but it was
+ * still scheduled to find that out.  One per connection is the least.
+ *
+ *	serv02		all block in accept()
+ *	serv02l		all block in select(), then accept()
+ *	serv03		fcntl() lock around accept()
+ *	serv04		process-shared pthread mutex around accept()
+ *	serv02e		epoll_wait() with EPOLLEXCLUSIVE, nonblocking accept()
+ */
+
+#include	"unpthread.h"
+#include	<sys/epoll.h>
+#include	<sys/mman.h>
+#include	<sys/resource.h>
+
+enum { M_ACCEPT, M_SELECT, M_FCNTL, M_PTHREAD, M_EPOLLEX };
+static const char	*mname[] = { "serv02", "serv02l", "serv03", "serv04",
+								 "serv02e" };
+
+static long				*wakeups;	/* per child, in shared memory */
+static pthread_mutex_t	*mptr;		/* for M_PTHREAD, in shared memory */
+static int				lockfd;		/* for M_FCNTL */
+
+static void
+lock(int mode, int type)
+{
+	struct flock	fl;
+
+	if (mode == M_PTHREAD) {
+		if (type == F_WRLCK)
+			Pthread_mutex_lock(mptr);
+		else
+			Pthread_mutex_unlock(mptr);
+	} else if (mode == M_FCNTL) {
+		bzero(&fl, sizeof(fl));
+		fl.l_type = type;
+		fl.l_whence = SEEK_SET;
+		while (fcntl(lockfd, F_SETLKW, &fl) < 0)
+			if (errno != EINTR)
+				err_sys("fcntl error");
+	}
+}
+
+static void
+child(int i, int mode, int listenfd)
+{
+	int					connfd, epfd;
+	fd_set				rset;
+	struct epoll_event	ev;
+
+	if (mode == M_EPOLLEX) {
+		if ( (epfd = epoll_create1(0)) < 0)
+			err_sys("epoll_create1 error");
+		ev.events = EPOLLIN | EPOLLEXCLUSIVE;
+		ev.data.fd = listenfd;
+		if (epoll_ctl(epfd, EPOLL_CTL_ADD, listenfd, &ev) < 0)
+			err_sys("epoll_ctl error");
+	}
+	FD_ZERO(&rset);
+
+	for ( ; ; ) {
+		if (mode == M_SELECT) {
+			FD_SET(listenfd, &rset);
+			Select(listenfd + 1, &rset, NULL, NULL, NULL);
+		} else if (mode == M_EPOLLEX) {
+			if (epoll_wait(epfd, &ev, 1, -1) < 0)
+				continue;
+		}
+		lock(mode, F_WRLCK);
+		wakeups[i]++;
+		connfd = accept(listenfd, NULL, NULL);
+		lock(mode, F_UNLCK);
+		if (connfd >= 0)
+			Close(connfd);
+		else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+			err_sys("accept error");
+	}
+}
+
+static void
+bench(int mode, int nchildren, int nconn)
+{
+	int					i, listenfd, fd;
+	long				nwake;
+	char				c, path[] = "/tmp/herdbench.XXXXXX";
+	pid_t				*pids;
+	socklen_t			len;
+	struct sockaddr_in	servaddr;
+	struct rusage		ru0, ru1;
+	struct timeval		start, end;
+	pthread_mutexattr_t	mattr;
+
+	listenfd = Socket(AF_INET, SOCK_STREAM, 0);
+	bzero(&servaddr, sizeof(servaddr));
+	servaddr.sin_family = AF_INET;
+	servaddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	Bind(listenfd, (SA *) &servaddr, sizeof(servaddr));
+	Listen(listenfd, LISTENQ);
+	len = sizeof(servaddr);
+	Getsockname(listenfd, (SA *) &servaddr, &len);
+	if (mode == M_SELECT || mode == M_EPOLLEX)
+		Fcntl(listenfd, F_SETFL, Fcntl(listenfd, F_GETFL, 0) | O_NONBLOCK);
+	if (mode == M_FCNTL) {
+		lockfd = Mkstemp(path);
+		Unlink(path);
+	} else if (mode == M_PTHREAD) {
+		Pthread_mutexattr_init(&mattr);
+		Pthread_mutexattr_setpshared(&mattr, PTHREAD_PROCESS_SHARED);
+		Pthread_mutex_init(mptr, &mattr);
+	}
+	bzero(wakeups, nchildren * sizeof(long));
+
+	if (getrusage(RUSAGE_CHILDREN, &ru0) < 0)
+		err_sys("getrusage error");
+	pids = Calloc(nchildren, sizeof(pid_t));
+	for (i = 0; i < nchildren; i++)
+		if ( (pids[i] = Fork()) == 0)
+			child(i, mode, listenfd);		/* never returns */
+	poll(NULL, 0, 200);						/* let them all start waiting */
+
+	Gettimeofday(&start, NULL);
+	for (i = 0; i < nconn; i++) {
+		fd = Socket(AF_INET, SOCK_STREAM, 0);
+		Connect(fd, (SA *) &servaddr, sizeof(servaddr));
+		if (Read(fd, &c, 1) != 0)			/* until the child closes it */
+			err_quit("data from child");
+		Close(fd);
+	}
+	Gettimeofday(&end, NULL);
+	tv_sub(&end, &start);
+
+	for (i = 0; i < nchildren; i++)
+		kill(pids[i], SIGTERM);
+	while (wait(NULL) > 0)
+		;
+	if (getrusage(RUSAGE_CHILDREN, &ru1) < 0)
+		err_sys("getrusage error");
+
+	nwake = 0;
+	for (i = 0; i < nchildren; i++)
+		nwake += wakeups[i];
+	printf("%-8s %6.2f wakeups/conn, %6.2f csw/conn, %6.1f us/conn\n",
+		   mname[mode], (double) nwake / nconn,
+		   (double) (ru1.ru_nvcsw - ru0.ru_nvcsw) / nconn,
+		   (end.tv_sec * 1e6 + end.tv_usec) / nconn);
+
+	Close(listenfd);
+	if (mode == M_FCNTL)
+		Close(lockfd);
+	free(pids);
+}
+
+int
+main(int argc, char **argv)
+{
+	int		c, i, m, nchildren, nconn;
+	long	*meter(int);
+
+	nchildren = 8;
+	nconn = 2000;
+	opterr = 0;
+	while ( (c = getopt(argc, argv, "c:n:")) != -1) {
+		switch (c) {
+		case 'c':
+			nconn = atoi(optarg);
+			break;
+		case 'n':
+			nchildren = atoi(optarg);
+			break;
+		case '?':
+			err_quit("unrecognized option: %c", optopt);
+		}
+	}
+	if (nchildren < 1 || nconn < 1)
+		err_quit("usage: herdbench [ -n #children ] [ -c #conns ] "
+				 "[ serv02 | serv02l | serv03 | serv04 | serv02e ] ...");
+
+	wakeups = meter(nchildren);
+	mptr = Mmap(0, sizeof(pthread_mutex_t), PROT_READ | PROT_WRITE,
+				MAP_ANON | MAP_SHARED, -1, 0);
+	printf("%d children, %d connections\n", nchildren, nconn);
+
+	if (optind == argc) {
+		for (m = M_ACCEPT; m <= M_EPOLLEX; m++)
+			bench(m, nchildren, nconn);
+	}
+	for (i = optind; i < argc; i++) {
+		for (m = M_ACCEPT; m <= M_EPOLLEX; m++)
+			if (strcmp(argv[i], mname[m]) == 0)
+				break;
+		if (m > M_EPOLLEX)
+			err_quit("unknown server: %s", argv[i]);
+		bench(m, nchildren, nconn);
+	}
+	exit(0);
+}
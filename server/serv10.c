@@ -0,0 +1,188 @@
+/*
+ * serv05 with a dispatcher that keeps up with high connection rates.
+ * The listening socket is nonblocking and every epoll_wait() wakeup
+ * accepts everything that is ready; each connection goes to the child
+ * with the fewest outstanding, the top of a heap, instead of to the first
+ * idle one found by a scan of cptr[]; and a child's connections from one
+ * wakeup go to it in one write_fds() instead of one write_fd() apiece.
+ * A child may have up to CHILDQ connections outstanding, so it starts on
+ * the next as soon as it finishes one, without waiting for the parent.
+ */
+
+/* include serv10a */
+#include	"unp.h"
+#include	"child10.h"
+#include	<sys/epoll.h>
+
+#define	MAXEVENTS	64
+
+Child			*cptr;
+static int		nchildren;
+static int		*heap;		/* child indexes, fewest outstanding on top */
+
+static void
+heap_swap(int a, int b)
+{
+	int		t;
+
+	t = heap[a];
+	heap[a] = heap[b];
+	heap[b] = t;
+	cptr[heap[a]].child_heap = a;
+	cptr[heap[b]].child_heap = b;
+}
+
+static void
+heap_up(int h)						/* child at heap[h] has fewer now */
+{
+	while (h > 0 &&
+		   cptr[heap[(h - 1) / 2]].child_nout > cptr[heap[h]].child_nout) {
+		heap_swap(h, (h - 1) / 2);
+		h = (h - 1) / 2;
+	}
+}
+
+static void
+heap_down(int h)					/* child at heap[h] has more now */
+{
+	int		l;
+
+	while ( (l = 2 * h + 1) < nchildren) {
+		if (l + 1 < nchildren &&
+			cptr[heap[l + 1]].child_nout < cptr[heap[l]].child_nout)
+			l++;
+		if (cptr[heap[l]].child_nout >= cptr[heap[h]].child_nout)
+			break;
+		heap_swap(h, l);
+		h = l;
+	}
+}
+
+int
+main(int argc, char **argv)
+{
+	int					listenfd, i, j, e, nev, epfd, connfd, listening;
+	int					nflush, *flush;
+	void				sig_int(int);
+	pid_t				child_make(int, int, int);
+	ssize_t				n;
+	char				buf[MAXFDPASS];
+	Child				*c;
+	socklen_t			addrlen, clilen;
+	struct sockaddr		*cliaddr;
+	struct epoll_event	ev, events[MAXEVENTS];
+
+	listenfd = -1;
+	if (argc == 3)
+		listenfd = Tcp_listen(NULL, argv[1], &addrlen);
+	else if (argc == 4)
+		listenfd = Tcp_listen(argv[1], argv[2], &addrlen);
+	else
+		err_quit("usage: serv10 [ <host> ] <port#> <#children>");
+	Fcntl(listenfd, F_SETFL, Fcntl(listenfd, F_GETFL, 0) | O_NONBLOCK);
+	cliaddr = Malloc(addrlen);
+
+	nchildren = atoi(argv[argc-1]);
+	cptr = Calloc(nchildren, sizeof(Child));
+	heap = Calloc(nchildren, sizeof(int));
+	flush = Calloc(nchildren, sizeof(int));
+
+		/* 4prefork all the children */
+	for (i = 0; i < nchildren; i++) {
+		child_make(i, listenfd, addrlen);	/* parent returns */
+		heap[i] = i;
+		cptr[i].child_heap = i;
+	}
+
+	if ( (epfd = epoll_create1(EPOLL_CLOEXEC)) < 0)
+		err_sys("epoll_create1 error");
+	ev.events = EPOLLIN;
+	for (i = 0; i <= nchildren; i++) {
+		ev.data.u32 = i;				/* nchildren: the listening socket */
+		if (epoll_ctl(epfd, EPOLL_CTL_ADD,
+					  i < nchildren ? cptr[i].child_pipefd : listenfd, &ev) < 0)
+			err_sys("epoll_ctl error");
+	}
+	listening = 1;
+
+	Signal(SIGINT, sig_int);
+
+	for ( ; ; ) {
+		if ( (nev = epoll_wait(epfd, events, MAXEVENTS, -1)) < 0) {
+			if (errno == EINTR)
+				continue;
+			err_sys("epoll_wait error");
+		}
+
+		nflush = 0;
+		for (e = 0; e < nev; e++) {
+			if ( (i = events[e].data.u32) < nchildren) {
+					/* 4children that finished connections */
+				if ( (n = Read(cptr[i].child_pipefd, buf, sizeof(buf))) == 0)
+					err_quit("child %d terminated unexpectedly", i);
+				cptr[i].child_nout -= n;
+				heap_up(cptr[i].child_heap);
+				continue;
+			}
+
+				/* 4accept all that are ready, while someone has room */
+			while (cptr[heap[0]].child_nout < CHILDQ) {
+				clilen = addrlen;
+				if ( (connfd = accept(listenfd, cliaddr, &clilen)) < 0) {
+					if (errno == EAGAIN || errno == EWOULDBLOCK)
+						break;
+					if (errno == EINTR || errno == ECONNABORTED)
+						continue;
+					err_sys("accept error");
+				}
+				c = &cptr[heap[0]];
+				if (c->child_npend == 0)
+					flush[nflush++] = heap[0];
+				c->child_pend[c->child_npend++] = connfd;
+				c->child_nout++;
+				c->child_count++;
+				heap_down(0);
+			}
+		}
+
+			/* 4one message per child for all it was given */
+		for (j = 0; j < nflush; j++) {
+			c = &cptr[flush[j]];
+			Write_fds(c->child_pipefd, "", 1, c->child_pend, c->child_npend);
+			while (c->child_npend > 0)
+				Close(c->child_pend[--c->child_npend]);
+		}
+
+			/* 4stop watching the listening socket if everyone is full */
+		if (listening != (cptr[heap[0]].child_nout < CHILDQ)) {
+			listening = !listening;
+			ev.events = listening ? EPOLLIN : 0;
+			ev.data.u32 = nchildren;
+			if (epoll_ctl(epfd, EPOLL_CTL_MOD, listenfd, &ev) < 0)
+				err_sys("epoll_ctl error");
+		}
+	}
+}
+/* end serv10a */
+
+void
+sig_int(int signo)
+{
+	int		i;
+	void	pr_cpu_time(void);
+
+		/* 4terminate all children */
+	for (i = 0; i < nchildren; i++)
+		kill(cptr[i].child_pid, SIGTERM);
+	while (wait(NULL) > 0)		/* wait for all children */
+		;
+	if (errno != ECHILD)
+		err_sys("wait error");
+
+	pr_cpu_time();
+
+	for (i = 0; i < nchildren; i++)
+		printf("child %d, %ld connections\n", i, cptr[i].child_count);
+
+	exit(0);
+}
@@ -0,0 +1,140 @@
+/*
+ * Prefork with the number of children adjusted to the load, like Apache's
+ * prefork MPM.  serv02 through serv05 fork a fixed number of children:
+ * too many waste memory while idle, too few and a burst of clients waits
+ * in the listen queue.  Here the children mark themselves idle or busy in
+ * a scoreboard in shared memory, and every TICK ms the parent counts the
+ * idle ones.  Fewer than minspare and it forks more, one on the first
+ * tick, then twice as many each tick while still short, up to MAXRATE per
+ * tick and maxchildren in all.  More than maxspare and it tells one idle
+ * child per tick to exit, so the pool shrinks slowly after a burst.
+ */
+
+/* include serv11a */
+#include	"unp.h"
+#include	"child11.h"
+#include	<sys/mman.h>
+
+#define	TICK		100		/* ms between looks at the scoreboard */
+#define	MAXRATE		32		/* most children forked per tick */
+
+Slot			*board;
+static int		maxchildren;
+static long		nspawned, nreaped, npeak, ndone;
+
+int
+main(int argc, char **argv)
+{
+	int			listenfd, i, n, minspare, maxspare, nidle, nlive, rate;
+	pid_t		pid;
+	socklen_t	addrlen;
+	void		sig_int(int);
+	pid_t		child_make(int, int, int);
+
+	listenfd = -1;
+	if (argc == 5)
+		listenfd = Tcp_listen(NULL, argv[1], &addrlen);
+	else if (argc == 6)
+		listenfd = Tcp_listen(argv[1], argv[2], &addrlen);
+	else
+		err_quit("usage: serv11 [ <host> ] <port#> <minspare> <maxspare> "
+				 "<maxchildren>");
+	minspare = atoi(argv[argc-3]);
+	maxspare = atoi(argv[argc-2]);
+	maxchildren = atoi(argv[argc-1]);
+	if (minspare < 1 || maxspare < minspare || maxchildren < minspare)
+		err_quit("need 1 <= minspare <= maxspare, minspare <= maxchildren");
+
+	board = Mmap(0, maxchildren * sizeof(Slot), PROT_READ | PROT_WRITE,
+				 MAP_ANON | MAP_SHARED, -1, 0);
+	bzero(board, maxchildren * sizeof(Slot));
+
+		/* 4start with minspare */
+	for (i = 0; i < minspare; i++)
+		child_make(i, listenfd, addrlen);	/* parent returns */
+	nspawned = minspare;
+
+	Signal(SIGINT, sig_int);
+	rate = 1;
+
+	for ( ; ; ) {
+			/* 4reap the children that have exited */
+		while ( (pid = waitpid(-1, NULL, WNOHANG)) > 0) {
+			for (i = 0; i < maxchildren; i++)
+				if (board[i].sl_pid == pid) {
+					board[i].sl_pid = 0;
+					board[i].sl_status = SL_EMPTY;
+					ndone += board[i].sl_count;
+					nreaped++;
+					break;
+				}
+		}
+
+			/* 4count the idle ones, ask the dying again */
+		nidle = nlive = 0;
+		for (i = 0; i < maxchildren; i++) {
+			if (board[i].sl_pid == 0)
+				continue;
+			nlive++;
+			if (board[i].sl_dying)
+				kill(board[i].sl_pid, SIGTERM);	/* in case it missed it */
+			else if (board[i].sl_status == SL_IDLE)
+				nidle++;
+		}
+		npeak = max(npeak, nlive);
+
+		if (nidle < minspare && nlive < maxchildren) {
+			n = min(rate, min(minspare - nidle, maxchildren - nlive));
+			for (i = 0; i < maxchildren && n > 0; i++) {
+				if (board[i].sl_pid == 0) {
+					child_make(i, listenfd, addrlen);	/* parent returns */
+					nspawned++;
+					n--;
+				}
+			}
+			rate = min(2 * rate, MAXRATE);
+		} else {
+			rate = 1;
+			if (nidle > maxspare) {
+				for (i = 0; i < maxchildren; i++) {
+					if (board[i].sl_pid != 0 && !board[i].sl_dying &&
+						board[i].sl_status == SL_IDLE) {
+						board[i].sl_dying = 1;
+						kill(board[i].sl_pid, SIGTERM);
+						break;
+					}
+				}
+			}
+		}
+
+		poll(NULL, 0, TICK);
+	}
+}
+/* end serv11a */
+
+void
+sig_int(int signo)
+{
+	int		i;
+	long	count;
+	void	pr_cpu_time(void);
+
+		/* 4terminate all children */
+	for (i = 0; i < maxchildren; i++)
+		if (board[i].sl_pid != 0)
+			kill(board[i].sl_pid, SIGTERM);
+	while (wait(NULL) > 0)		/* wait for all children */
+		;
+	if (errno != ECHILD)
+		err_sys("wait error");
+
+	count = ndone;
+	for (i = 0; i < maxchildren; i++)
+		if (board[i].sl_pid != 0)
+			count += board[i].sl_count;
+
+	pr_cpu_time();
+	printf("%ld connections, %ld children forked, %ld exited, at most %ld "
+		   "at once\n", count, nspawned, nreaped, npeak);
+	exit(0);
+}
@@ -0,0 +1,147 @@
+/*
+ * serv06 with a thread cache.  serv06 creates a new detached thread with
+ * the default attributes for every client: a pthread_create() on the
+ * path of every connection, and a stack of the default size (8 MB on
+ * Linux) mapped and unmapped each time.  Here a thread that is done with
+ * its client parks itself on a free list and waits on its own condition
+ * variable for another; the main thread gives each new connection to the
+ * most recently parked thread, whose stack is most likely still in
+ * cache, and creates a thread only if none is parked.  Threads are
+ * created with a small stack (-s, in KB) and there are at most -m of
+ * them; when all are busy the main thread stops accepting until one
+ * parks, leaving new clients in the listen queue.
+ */
+
+/* include serv12 */
+#include	"unpthread.h"
+#include	<limits.h>			/* PTHREAD_STACK_MIN */
+
+typedef struct cthread {
+  pthread_cond_t	ct_cond;	/* signaled when ct_fd is set */
+  int				ct_fd;		/* connection to serve, -1 while parked */
+  struct cthread	*ct_next;	/* on the free list */
+} Cthread;
+
+static pthread_mutex_t	cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t	cache_room = PTHREAD_COND_INITIALIZER;
+static pthread_attr_t	cache_attr;
+static Cthread			*cache_free;	/* parked threads, newest first */
+static int				cache_nthread, cache_max;
+static long				cache_ncreate, cache_nreuse;
+
+void *
+doit(void *arg)
+{
+	int		connfd;
+	Cthread	*ct = arg;
+	void	web_child(int);
+
+	for ( ; ; ) {
+		connfd = ct->ct_fd;
+		web_child(connfd);
+		Close(connfd);
+
+			/* 4park until the main thread has another */
+		Pthread_mutex_lock(&cache_mutex);
+		ct->ct_fd = -1;
+		ct->ct_next = cache_free;
+		cache_free = ct;
+		Pthread_cond_signal(&cache_room);
+		while (ct->ct_fd < 0)
+			Pthread_cond_wait(&ct->ct_cond, &cache_mutex);
+		Pthread_mutex_unlock(&cache_mutex);
+	}
+}
+
+void
+dispatch(int connfd)
+{
+	pthread_t	tid;
+	Cthread		*ct;
+
+	Pthread_mutex_lock(&cache_mutex);
+	while (cache_free == NULL && cache_nthread >= cache_max)
+		Pthread_cond_wait(&cache_room, &cache_mutex);
+
+	if ( (ct = cache_free) != NULL) {
+		cache_free = ct->ct_next;
+		ct->ct_fd = connfd;
+		cache_nreuse++;
+		Pthread_cond_signal(&ct->ct_cond);
+		Pthread_mutex_unlock(&cache_mutex);
+		return;
+	}
+
+	cache_nthread++;
+	cache_ncreate++;
+	Pthread_mutex_unlock(&cache_mutex);
+	ct = Malloc(sizeof(Cthread));
+	if ( (errno = pthread_cond_init(&ct->ct_cond, NULL)) != 0)
+		err_sys("pthread_cond_init error");
+	ct->ct_fd = connfd;
+	Pthread_create(&tid, &cache_attr, &doit, ct);
+}
+
+int
+main(int argc, char **argv)
+{
+	int				c, listenfd, connfd, stackkb;
+	void			sig_int(int);
+	socklen_t		clilen, addrlen;
+	struct sockaddr	*cliaddr;
+
+	cache_max = 1024;
+	stackkb = 64;
+	opterr = 0;
+	while ( (c = getopt(argc, argv, "m:s:")) != -1) {
+		switch (c) {
+		case 'm':
+			if ( (cache_max = atoi(optarg)) < 1)
+				err_quit("-m must be at least 1");
+			break;
+		case 's':
+			if ( (stackkb = atoi(optarg)) < 1)
+				err_quit("-s must be at least 1");
+			break;
+		case '?':
+			err_quit("unrecognized option: %c", optopt);
+		}
+	}
+	listenfd = -1;
+	if (optind == argc - 1)
+		listenfd = Tcp_listen(NULL, argv[optind], &addrlen);
+	else if (optind == argc - 2)
+		listenfd = Tcp_listen(argv[optind], argv[optind + 1], &addrlen);
+	else
+		err_quit("usage: serv12 [ -m maxthreads ] [ -s stackKB ] "
+				 "[ <host> ] <port#>");
+	cliaddr = Malloc(addrlen);
+
+	if ( (errno = pthread_attr_init(&cache_attr)) != 0)
+		err_sys("pthread_attr_init error");
+	pthread_attr_setdetachstate(&cache_attr, PTHREAD_CREATE_DETACHED);
+	if ( (errno = pthread_attr_setstacksize(&cache_attr,
+					max(stackkb * 1024, PTHREAD_STACK_MIN))) != 0)
+		err_sys("pthread_attr_setstacksize error");
+
+	Signal(SIGINT, sig_int);
+
+	for ( ; ; ) {
+		clilen = addrlen;
+		connfd = Accept(listenfd, cliaddr, &clilen);
+
+		dispatch(connfd);
+	}
+}
+/* end serv12 */
+
+void
+sig_int(int signo)
+{
+	void	pr_cpu_time(void);
+
+	pr_cpu_time();
+	printf("%ld threads created, %ld connections to a cached thread\n",
+		   cache_ncreate, cache_nreuse);
+	exit(0);
+}
@@ -0,0 +1,188 @@
+/*
+ * Hybrid of the prefork servers and the prethreaded ones: <#processes>
+ * children, each with <#threads> threads that accept and serve clients.
+ * A crash takes down one process's threads, not the server, while most
+ * of the concurrency is in threads, which are cheaper than processes.
+ * The two counts can be set independently: N x 1 is serv02 and 1 x M is
+ * serv09.  -a picks how the threads get their connections:
+ *
+ *	accept		one listening socket, opened before the fork, and every
+ *				thread blocks in accept() on it (the default)
+ *	reuseport	each process opens its own listening socket with
+ *				SO_REUSEPORT, and the kernel spreads connections over
+ *				them; its threads block in accept() on it
+ *	epollex		one listening socket, nonblocking; every thread waits in
+ *				its own epoll instance, added with EPOLLEXCLUSIVE so that
+ *				a connection wakes one thread, not all of them
+ *
+ * -b, -d and -f set the listen() backlog, TCP_DEFER_ACCEPT and the
+ * TCP Fast Open queue of the listening socket (tcp_listen_opt()).
+ * Connections per thread are counted in shared memory (meter()) and
+ * printed, by process, at the end.
+ */
+
+#include	"unpthread.h"
+#include	<sys/epoll.h>
+
+#define	ACC_ACCEPT		0
+#define	ACC_REUSEPORT	1
+#define	ACC_EPOLLEX		2
+
+static int			nprocesses, nthreads, accmode, listenfd;
+static const char	*host, *serv;
+static socklen_t	addrlen;
+static pid_t		*pids;
+static long			*cptr;		/* connections per thread, in shared memory */
+static struct tcp_opts	opt;
+
+static void *
+thread_main(void *arg)
+{
+	int					connfd, epfd;
+	long				i = (long) arg;
+	void				web_child(int);
+	socklen_t			clilen;
+	struct sockaddr		*cliaddr;
+	struct epoll_event	ev;
+
+	cliaddr = Malloc(addrlen);
+	epfd = -1;
+	if (accmode == ACC_EPOLLEX) {
+		if ( (epfd = epoll_create1(EPOLL_CLOEXEC)) < 0)
+			err_sys("epoll_create1 error");
+		ev.events = EPOLLIN | EPOLLEXCLUSIVE;
+		ev.data.fd = listenfd;
+		if (epoll_ctl(epfd, EPOLL_CTL_ADD, listenfd, &ev) < 0)
+			err_sys("epoll_ctl error");
+	}
+
+	for ( ; ; ) {
+		if (accmode == ACC_EPOLLEX &&
+			epoll_wait(epfd, &ev, 1, -1) < 0 && errno != EINTR)
+			err_sys("epoll_wait error");
+
+		clilen = addrlen;
+		if ( (connfd = accept(listenfd, cliaddr, &clilen)) < 0) {
+			if (errno == EAGAIN || errno == EWOULDBLOCK ||
+				errno == EINTR || errno == ECONNABORTED)
+				continue;		/* another thread got it first */
+			err_sys("accept error");
+		}
+		cptr[i]++;
+
+		web_child(connfd);		/* process the request */
+		Close(connfd);
+	}
+	return(NULL);				/* not reached */
+}
+
+static void
+process_main(int p)
+{
+	int			t;
+	pthread_t	tid;
+
+	if (accmode == ACC_REUSEPORT)
+		listenfd = Tcp_listen_opt(host, serv, &addrlen, &opt);
+
+	for (t = 1; t < nthreads; t++)
+		Pthread_create(&tid, NULL, thread_main,
+					   (void *) (long) (p * nthreads + t));
+	thread_main((void *) (long) (p * nthreads));	/* never returns */
+}
+
+int
+main(int argc, char **argv)
+{
+	int		c, p;
+	void	sig_int(int);
+	long	*meter(int);
+
+	accmode = ACC_ACCEPT;
+	opterr = 0;
+	while ( (c = getopt(argc, argv, "a:b:d:f:")) != -1) {
+		switch (c) {
+		case 'a':
+			if (strcmp(optarg, "accept") == 0)
+				accmode = ACC_ACCEPT;
+			else if (strcmp(optarg, "reuseport") == 0)
+				accmode = ACC_REUSEPORT;
+			else if (strcmp(optarg, "epollex") == 0)
+				accmode = ACC_EPOLLEX;
+			else
+				err_quit("-a accept, reuseport, or epollex");
+			break;
+		case 'b':
+			opt.to_backlog = atoi(optarg);
+			break;
+		case 'd':
+			opt.to_deferaccept = atoi(optarg);		/* seconds */
+			break;
+		case 'f':
+			opt.to_fastopen = atoi(optarg);			/* max pending */
+			break;
+		case '?':
+			err_quit("unrecognized option: %c", optopt);
+		}
+	}
+	if (optind == argc - 3) {
+		host = NULL;
+		serv = argv[optind];
+	} else if (optind == argc - 4) {
+		host = argv[optind];
+		serv = argv[optind + 1];
+	} else
+		err_quit("usage: serv13 [ -a accept|reuseport|epollex ] [ -b backlog ] "
+				 "[ -d deferaccept ] [ -f fastopenqlen ] [ <host> ] <port#> "
+				 "<#processes> <#threads>");
+	nprocesses = atoi(argv[argc-2]);
+	nthreads = atoi(argv[argc-1]);
+	if (nprocesses < 1 || nthreads < 1)
+		err_quit("need at least one process and one thread");
+
+	if (accmode == ACC_REUSEPORT)
+		opt.to_reuseport = 1;
+	else {
+		if (accmode == ACC_EPOLLEX)
+			opt.to_sockflags = SOCK_NONBLOCK;
+		listenfd = Tcp_listen_opt(host, serv, &addrlen, &opt);
+	}
+	cptr = meter(nprocesses * nthreads);
+	pids = Calloc(nprocesses, sizeof(pid_t));
+
+	for (p = 0; p < nprocesses; p++) {
+		if ( (pids[p] = Fork()) == 0)
+			process_main(p);	/* never returns */
+	}
+
+	Signal(SIGINT, sig_int);
+
+	for ( ; ; )
+		pause();	/* everything done by children */
+}
+
+void
+sig_int(int signo)
+{
+	int		p, t;
+	long	n;
+	void	pr_cpu_time(void);
+
+		/* 4terminate all children */
+	for (p = 0; p < nprocesses; p++)
+		kill(pids[p], SIGTERM);
+	while (wait(NULL) > 0)		/* wait for all children */
+		;
+	if (errno != ECHILD)
+		err_sys("wait error");
+
+	pr_cpu_time();
+
+	for (p = 0; p < nprocesses; p++) {
+		n = 0;
+		for (t = 0; t < nthreads; t++)
+			n += cptr[p * nthreads + t];
+		printf("process %d, %ld connections\n", p, n);
+	}
+	exit(0);
+}
@@ -16,6 +16,7 @@ char	*port;
 int		bindport;			/* 0 or TCP or UDP port number to bind */
 							/* set by -b or -l options */
 int		broadcast;			/* SO_BROADCAST */
+int		busypoll;			/* SO_BUSY_POLL, #usec */
 int		cbreak;				/* set terminal to cbreak mode */
 int		chunkwrite;			/* write in small chunks; not all-at-once */
 int		client = 1;			/* acting as client is the default */
@@ -24,9 +25,11 @@ int		crlf;				/* convert newline to CR/LF & vice versa */
 int		debug;				/* SO_DEBUG */
 int		dofork;				/* concurrent server, do a fork() */
 int		dontroute;			/* SO_DONTROUTE */
+int		duration = 10;		/* #secs to run parallel streams (-m) */
 char	foreignip[32];		/* foreign IP address, dotted-decimal string */
 int		foreignport;		/* foreign port number */
 int		halfclose;			/* TCP half close option */
+int		interval = 1;		/* #secs between reports for -m, 0 = none */
 int		ignorewerr;			/* true if write() errors should be ignored */
 int		iptos = -1;			/* IP_TOS opton */
 int		ipttl = -1;			/* IP_TTL opton */
@@ -34,17 +37,20 @@ char	joinip[32];			/* multicast IP address, dotted-decimal string */
 int		keepalive;			/* SO_KEEPALIVE */
 long	linger = -1;		/* 0 or positive turns on option */
 int		listenq = 5;		/* listen queue for TCP Server */
+int		listenfd = -1;		/* TCP server's listening socket */
 char	localip[32];		/* local IP address, dotted-decimal string */
 int		maxseg;				/* TCP_MAXSEG */
 int		mcastttl;			/* multicast TTL */
 int		msgpeek;			/* MSG_PEEK */
 int		nodelay;			/* TCP_NODELAY (Nagle algorithm) */
 int		nbuf = 1024;		/* number of buffers to write (sink mode) */
+int		nstreams;			/* # parallel streams, each its own thread */
 int		onesbcast;			/* set IP_ONESBCAST for 255.255.255.255 bcasts */
 int		pauseclose;			/* #ms to sleep after recv FIN, before close */
 int		pauseinit;			/* #ms to sleep before first read */
 int		pauselisten;		/* #ms to sleep after listen() */
 int		pauserw;			/* #ms to sleep before each read or write */
+int		pipeline;			/* request/response mode, #outstanding */
 int		reuseaddr;			/* SO_REUSEADDR */
 int		reuseport;			/* SO_REUSEPORT */
 int		readlen = 1024;		/* default read length for socket */
@@ -60,10 +66,14 @@ char   *wbuf;				/* pointer that is malloc'ed */
 int		server;				/* to act as server requires -s option */
 int		sigio;				/* send SIGIO */
 int		sourcesink;			/* source/sink mode */
+int		spinread;			/* spin on nonblocking reads */
 int		udp;				/* use UDP instead of TCP */
 int		urgwrite;			/* write urgent byte after this write */
 int		verbose;			/* each -v increments this by 1 */
 int		usewritev;			/* use writev() instead of write() */
+int		usecork;			/* TCP_CORK around each buffer's chunks */
+int		usemore;			/* MSG_MORE on all but a buffer's last chunk */
+int		zerocopy;			/* MSG_ZEROCOPY sends */
 
 struct sockaddr_in	cliaddr, servaddr;
 
@@ -79,14 +89,39 @@ main(int argc, char *argv[])
 		usage("");
 
 	opterr = 0;		/* don't want getopt() writing to stderr */
-	while ( (c = getopt(argc, argv, "2b:cf:g:hij:kl:n:op:q:r:st:uvw:x:y:ABCDEFG:H:IJ:KL:NO:P:Q:R:S:TU:VWX:YZ")) != -1) {
+	while ( (c = getopt(argc, argv, "0132a:b:cd:e:f:g:hij:kl:m:n:op:q:r:st:uvw:x:y:zABCDEFG:H:IJ:KL:M:NO:P:Q:R:S:TU:VWX:YZ")) != -1) {
 		switch (c) {
+#ifdef	MSG_ZEROCOPY
+		case '0':			/* send with MSG_ZEROCOPY */
+			zerocopy = 1;
+			break;
+#endif
+
+#ifdef	MSG_MORE
+		case '1':			/* MSG_MORE for all but a buffer's last chunk */
+			usemore = 1;
+			chunkwrite = 1;	/* implies this option too */
+			break;
+#endif
+
+#if	defined(TCP_CORK) || defined(TCP_NOPUSH)
+		case '3':			/* cork TCP around each buffer's chunks */
+			usecork = 1;
+			chunkwrite = 1;	/* implies this option too */
+			break;
+#endif
+
 #ifdef	IP_ONESBCAST
 		case '2':			/* use 255.255.255.255 as broadcast address */
 			onesbcast = 1;
 			break;
 #endif
 
+		case 'a':			/* request/response, n transactions outstanding */
+			if ( (pipeline = atoi(optarg)) < 1)
+				usage("-a must be at least 1");
+			break;
+
 		case 'b':
 			bindport = atoi(optarg);
 			break;
@@ -95,6 +130,14 @@ main(int argc, char *argv[])
 			crlf = 1;
 			break;
 
+		case 'd':			/* duration of parallel streams test */
+			duration = atoi(optarg);
+			break;
+
+		case 'e':			/* seconds between throughput reports */
+			interval = atoi(optarg);
+			break;
+
 		case 'f':			/* foreign IP address and port#: a.b.c.d.p */
 			if ( (ptr = strrchr(optarg, '.')) == NULL)
 				usage("invalid -f option");
@@ -135,6 +178,12 @@ main(int argc, char *argv[])
 			strcpy(localip, optarg);	/* save dotted-decimal IP */
 			break;
 
+		case 'm':			/* parallel streams, one thread each */
+			if ( (nstreams = atoi(optarg)) < 1 || nstreams > 128)
+				usage("-m must be between 1 and 128");
+			sourcesink = 1;	/* implies -i */
+			break;
+
 		case 'n':			/* number of buffers to write */
 			nbuf = atol(optarg);
 			break;
@@ -186,6 +235,10 @@ main(int argc, char *argv[])
 			sndtimeo = atol(optarg);
 			break;
 
+		case 'z':			/* spin on nonblocking reads (-a) */
+			spinread = 1;
+			break;
+
 		case 'A':			/* SO_REUSEADDR socket option */
 			reuseaddr = 1;
 			break;
@@ -238,6 +291,12 @@ main(int argc, char *argv[])
 			linger = atol(optarg);
 			break;
 
+#ifdef	SO_BUSY_POLL
+		case 'M':			/* SO_BUSY_POLL socket option */
+			busypoll = atoi(optarg);
+			break;
+#endif
+
 		case 'N':			/* SO_NODELAY socket option */
 			nodelay = 1;
 			break;
@@ -307,12 +366,28 @@ main(int argc, char *argv[])
 		usage("can't specify -L and -u");
 	if (udp && nodelay)
 		usage("can't specify -N and -u");
+	if (udp && (zerocopy || usemore || usecork))
+		usage("can't specify -0, -1 or -3 with -u");
+	if (zerocopy && chunkwrite)
+		usage("can't specify -0 with -k, -V, -1 or -3");
 #ifdef	notdef
 	if (udp == 0 && broadcast)
 		usage("can't specify -B with TCP");
 #endif
 	if (udp == 0 && foreignip[0] != 0)
 		usage("can't specify -f with TCP");
+	if (pipeline && nstreams)
+		usage("can't specify -a and -m");
+	if (pipeline && udp && connectudp == 0)
+		usage("can't specify -o and -a");
+	if (nstreams && dofork)
+		usage("can't specify -F and -m");
+	if (nstreams && udp && connectudp == 0)
+		usage("can't specify -o and -m");
+	if (nstreams && udp && writelen < 4)
+		usage("-w must be at least 4 with -u and -m");
+	if (nstreams > 1 && client && bindport != 0)
+		usage("can't bind one port for -m streams");
 
 	if (client) {
 		if (optind != argc-2)
@@ -338,7 +413,19 @@ main(int argc, char *argv[])
 	else
 		fd = servopen(host, port);
 
-	if (sourcesink) {		/* ignore stdin/stdout */
+	if (pipeline) {			/* request/response */
+		if (client)
+			rr_client(fd);
+		else
+			rr_server(fd);
+
+	} else if (nstreams) {	/* parallel source/sink, with reports */
+		if (client)
+			source_streams(fd, host, port);
+		else
+			sink_streams(fd);
+
+	} else if (sourcesink) {		/* ignore stdin/stdout */
 		if (client) {
 			if (udp)
 				source_udp(fd);
@@ -369,8 +456,11 @@ usage(const char *msg)
 "       sock [ options ] -s [ <IPaddr> ] <port>     (for server)\n"
 "       sock [ options ] -i <host> <port>           (for \"source\" client)\n"
 "       sock [ options ] -i -s [ <IPaddr> ] <port>  (for \"sink\" server)\n"
-"options: -b n  bind n as client's local port number\n"
+"options: -a n  request/response mode, n transactions outstanding (-w, -r sizes)\n"
+"         -b n  bind n as client's local port number\n"
 "         -c    convert newline to CR/LF & vice versa\n"
+"         -d n  # seconds to run the -m streams (default 10)\n"
+"         -e n  # seconds between -m throughput reports (default 1, 0 = none)\n"
 "         -f a.b.c.d.p  foreign IP address = a.b.c.d, foreign port # = p\n"
 "         -g a.b.c.d  loose source route\n"
 "         -h    issue TCP half close on standard input EOF\n"
@@ -380,6 +470,7 @@ usage(const char *msg)
 #endif
 "         -k    write or writev in chunks\n"
 "         -l a.b.c.d.p  client's local IP address = a.b.c.d, local port # = p\n"
+"         -m n  source/sink n parallel streams, one thread each; implies -i\n"
 "         -n n  # buffers to write for \"source\" client (default 1024)\n"
 "         -o    do NOT connect UDP client\n"
 "         -p n  # ms to pause before each read or write (source/sink)\n"
@@ -394,6 +485,7 @@ usage(const char *msg)
 "         -w n  # bytes per write() for \"source\" client (default 1024)\n"
 "         -x n  # ms for SO_RCVTIMEO (receive timeout)\n"
 "         -y n  # ms for SO_SNDTIMEO (send timeout)\n"
+"         -z    spin on nonblocking reads for request/response (-a)\n"
 "         -A    SO_REUSEADDR option\n"
 "         -B    SO_BROADCAST option\n"
 "         -C    set terminal to cbreak mode\n"
@@ -410,6 +502,9 @@ usage(const char *msg)
 #endif
 "         -K    SO_KEEPALIVE option\n"
 "         -L n  SO_LINGER option, n = linger time\n"
+#ifdef	SO_BUSY_POLL
+"         -M n  SO_BUSY_POLL option, n = usec to busy poll\n"
+#endif
 "         -N    TCP_NODELAY option\n"
 "         -O n  # ms to pause after listen, but before first accept\n"
 "         -P n  # ms to pause before first read or write (source/sink)\n"
@@ -425,6 +520,15 @@ usage(const char *msg)
 "         -X n  TCP_MAXSEG option (set MSS)\n"
 "         -Y    SO_DONTROUTE option\n"
 "         -Z    MSG_PEEK\n"
+#ifdef	MSG_ZEROCOPY
+"         -0    MSG_ZEROCOPY sends (source)\n"
+#endif
+#ifdef	MSG_MORE
+"         -1    MSG_MORE on all but the last chunk; enables -k too\n"
+#endif
+#if	defined(TCP_CORK) || defined(TCP_NOPUSH)
+"         -3    TCP_CORK around each buffer's chunks; enables -k too\n"
+#endif
 #ifdef	IP_ONESBCAST
 "         -2    IP_ONESBCAST option (255.255.255.255 for broadcast\n"
 #endif
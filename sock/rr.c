@@ -0,0 +1,342 @@
+#include	"sock.h"
+
+/*
+ * Request/response mode (-a n), like netperf's TCP_RR and UDP_RR.  The
+ * client sends a writelen-byte request and the server answers each one
+ * with a readlen-byte response, so both ends take the same -w and -r.
+ * The client keeps n transactions outstanding (1 = strict ping-pong)
+ * for "duration" seconds, reports the transaction rate and latency
+ * every "interval" seconds, and ends with latency percentiles and a
+ * histogram.
+ *
+ * For the lowest latency, -M sets SO_BUSY_POLL, so a blocking read
+ * polls the device queue, and -z spins on nonblocking reads instead of
+ * sleeping in the kernel.  Both burn a CPU; on loopback, unless each end
+ * has a CPU of its own, spinning just delays the other end.
+ *
+ * A UDP request carries a sequence number in its first 4 bytes, which
+ * the server copies to the response, so the client can tell a late
+ * response from a current one.  After UDP_TIMEO seconds with no
+ * response, everything outstanding counts as lost and is sent again.
+ */
+
+#define	UDP_TIMEO	1		/* seconds */
+
+#define	HIST_SUB	16		/* linear buckets per power of 2; 6% resolution */
+#define	HIST_NBKT	(HIST_SUB * 40)	/* up to 2^40 ns, about 18 minutes */
+
+static uint64_t	hist[HIST_NBKT];	/* latencies in ns */
+static uint64_t	hcount, hmin, hmax;
+static double	hsum;
+
+static int
+hist_bucket(uint64_t ns)
+{
+	int		shift;
+
+	if (ns < HIST_SUB)
+		return(ns);
+	for (shift = 0; (ns >> shift) >= 2 * HIST_SUB; shift++)
+		;
+	if ((shift + 1) * HIST_SUB >= HIST_NBKT)
+		return(HIST_NBKT - 1);
+	return((shift + 1) * HIST_SUB + (ns >> shift) - HIST_SUB);
+}
+
+static uint64_t
+hist_value(int i)		/* lower bound of bucket i */
+{
+	if (i < HIST_SUB)
+		return(i);
+	return((uint64_t) (HIST_SUB + i % HIST_SUB) << (i / HIST_SUB - 1));
+}
+
+static void
+hist_add(uint64_t ns)
+{
+	hist[hist_bucket(ns)]++;
+	if (hcount == 0 || ns < hmin)
+		hmin = ns;
+	if (ns > hmax)
+		hmax = ns;
+	hsum += ns;
+	hcount++;
+}
+
+static double
+hist_pct(double pct)	/* microseconds */
+{
+	int			i;
+	uint64_t	n, want;
+
+	want = hcount * pct / 100.0;
+	if (want >= hcount)
+		want = hcount - 1;
+	for (i = 0, n = 0; i < HIST_NBKT; i++) {
+		if ((n += hist[i]) > want)
+			return(hist_value(i) / 1000.0);
+	}
+	return(hmax / 1000.0);
+}
+
+static void
+hist_print(void)
+{
+	int			i, j, bar;
+	uint64_t	n, cum, peak;
+
+	if (hcount == 0) {
+		printf("no transactions completed\n");
+		return;
+	}
+	printf("latency usec: min %.2f  avg %.2f  p50 %.2f  p90 %.2f  p99 %.2f"
+		   "  p99.9 %.2f  max %.2f\n", hmin / 1000.0, hsum / hcount / 1000.0,
+		   hist_pct(50), hist_pct(90), hist_pct(99), hist_pct(99.9),
+		   hmax / 1000.0);
+
+		/* one line per power of 2 */
+	peak = 0;
+	for (i = 0; i < HIST_NBKT; i += HIST_SUB) {
+		for (j = 0, n = 0; j < HIST_SUB; j++)
+			n += hist[i + j];
+		if (n > peak)
+			peak = n;
+	}
+	cum = 0;
+	for (i = 0; i < HIST_NBKT; i += HIST_SUB) {
+		for (j = 0, n = 0; j < HIST_SUB; j++)
+			n += hist[i + j];
+		if (n == 0)
+			continue;
+		cum += n;
+		bar = 40 * n / peak;
+		printf("%10.2f - %10.2f usec %10llu %6.2f%% %.*s\n",
+			   hist_value(i) / 1000.0, hist_value(i + HIST_SUB) / 1000.0,
+			   (unsigned long long) n, 100.0 * cum / hcount, bar ? bar : 1,
+			   "****************************************");
+	}
+	fflush(stdout);
+}
+
+/*
+ * Read exactly "nbytes" from a TCP socket, or one datagram from a UDP
+ * socket.  Spin on nonblocking reads with -z.  Return the number of
+ * bytes read, 0 on EOF, or -1 if a UDP read timed out.
+ */
+static ssize_t
+rr_read(int fd, char *buf, size_t nbytes)
+{
+	ssize_t			n;
+	size_t			nleft;
+	double			tstart;
+	struct pollfd	pfd;
+
+	tstart = (udp && spinread) ? now() : 0;
+	for (nleft = nbytes; nleft > 0; ) {
+		if (udp && spinread == 0) {
+			pfd.fd = fd;
+			pfd.events = POLLIN;
+			if ( (n = poll(&pfd, 1, UDP_TIMEO * 1000)) == 0)
+				return(-1);
+			if (n < 0 && errno != EINTR)
+				err_sys("poll error");
+		}
+		if ( (n = recv(fd, buf, nleft, spinread ? MSG_DONTWAIT : 0)) < 0) {
+			if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+				if (tstart > 0 && now() - tstart > UDP_TIMEO)
+					return(-1);
+				continue;
+			}
+			err_sys("recv error");
+		} else if (n == 0 && udp == 0)
+			return(0);			/* EOF */
+		if (udp)
+			return(n);
+		buf += n;
+		nleft -= n;
+	}
+	return(nbytes);
+}
+
+static void
+rr_write(int fd, const char *buf, size_t nbytes)
+{
+	if (writen(fd, buf, nbytes) < 0) {
+		if (udp && ignorewerr)
+			return;				/* e.g. ECONNREFUSED from an earlier send */
+		err_sys("write error");
+	}
+}
+
+void
+rr_client(int fd)
+{
+	int			i;
+	uint32_t	seq, rseq, head, nlost, ntrans, lastntrans;
+	uint64_t	ns;
+	double		*sent, start, end, t, tnext, tlast, isum, imax;
+	ssize_t		n;
+	char		*req, *resp;
+
+	if (udp && (writelen < 4 || readlen < 4))
+		err_quit("UDP request/response needs -w and -r of at least 4");
+
+	sent = Calloc(pipeline, sizeof(double));	/* indexed by seq % pipeline */
+	req = Malloc(writelen);		/* rbuf and wbuf are sized for the other */
+	resp = Malloc(readlen);		/* direction on the server, so use our own */
+	pattern(req, writelen);
+
+	if (pauseinit)
+		sleep_us(pauseinit*1000);
+
+	start = now();
+	end = start + duration;
+	tlast = start;
+	tnext = (interval > 0) ? start + interval : 0;
+	nlost = ntrans = lastntrans = 0;
+	isum = imax = 0;
+
+		/* requests head ... seq-1 are outstanding */
+	for (head = seq = 0; seq < pipeline; seq++) {
+		sent[seq % pipeline] = now();
+		if (udp) {
+			rseq = htonl(seq);
+			memcpy(req, &rseq, sizeof(rseq));
+		}
+		rr_write(fd, req, writelen);
+	}
+
+	for ( ; ; ) {
+		if ( (n = rr_read(fd, resp, readlen)) == 0)
+			err_quit("server closed the connection");
+		t = now();
+
+		if (n < 0) {
+				/* UDP timeout: everything outstanding is lost; resend */
+			nlost += seq - head;
+			head = seq;
+			if (t >= end)
+				break;
+			for (i = 0; i < pipeline; i++, seq++) {
+				sent[seq % pipeline] = t;
+				rseq = htonl(seq);
+				memcpy(req, &rseq, sizeof(rseq));
+				rr_write(fd, req, writelen);
+			}
+			continue;
+		}
+
+		if (udp) {
+			memcpy(&rseq, resp, sizeof(rseq));
+			rseq = ntohl(rseq);
+			if ((int32_t) (rseq - head) < 0 || (int32_t) (rseq - seq) >= 0)
+				continue;		/* late response to a lost request */
+			nlost += rseq - head;	/* the ones it overtook were lost */
+			head = rseq;
+		}
+
+		ns = (t - sent[head % pipeline]) * 1e9;
+		hist_add(ns);
+		isum += ns;
+		if (ns > imax)
+			imax = ns;
+		head++;
+		ntrans++;
+
+		if (tnext > 0 && t >= tnext) {
+			printf("[RR]  %6.1f-%6.1f sec %10.0f trans/s  avg %8.2f  max %8.2f usec\n",
+				   tlast - start, t - start, (ntrans - lastntrans) / (t - tlast),
+				   isum / (ntrans - lastntrans) / 1000.0, imax / 1000.0);
+			fflush(stdout);
+			lastntrans = ntrans;
+			tlast = t;
+			tnext += interval;
+			isum = imax = 0;
+		}
+
+		if (t >= end) {
+			if (head == seq)
+				break;			/* the last response is in */
+			continue;			/* drain the pipeline, sending no more */
+		}
+
+		sent[seq % pipeline] = now();
+		if (udp) {
+			rseq = htonl(seq);
+			memcpy(req, &rseq, sizeof(rseq));
+		}
+		rr_write(fd, req, writelen);
+		seq++;
+		if (pauserw)
+			sleep_us(pauserw*1000);
+	}
+
+	printf("- - - - - - - - - - - - - - - - - - - - - - - - -\n");
+	printf("%u transactions in %.2f sec = %.0f trans/s, pipeline %d",
+		   ntrans, t - start, ntrans / (t - start), pipeline);
+	if (udp)
+		printf(", %u lost", nlost);
+	printf("\n");
+	hist_print();
+
+	free(sent);
+	free(req);
+	free(resp);
+	if (close(fd) < 0)
+		err_sys("close error");
+}
+
+/*
+ * Answer every request with one response until the client closes the
+ * connection.  A UDP server runs until it is killed.
+ */
+void
+rr_server(int fd)
+{
+	ssize_t				n;
+	socklen_t			len;
+	struct sockaddr_in	from;
+	char				*req, *resp;
+
+	if (udp && readlen < 4)
+		err_quit("UDP request/response needs -r of at least 4");
+	req = Malloc(writelen);
+	resp = Malloc(readlen);
+	pattern(resp, readlen);
+
+	if (pauseinit)
+		sleep_us(pauseinit*1000);
+
+	for ( ; ; ) {
+		if (udp) {
+			len = sizeof(from);
+			if ( (n = recvfrom(fd, req, writelen, spinread ? MSG_DONTWAIT : 0,
+							   (struct sockaddr *) &from, &len)) < 0) {
+				if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+					continue;
+				err_sys("recvfrom error");
+			}
+			if (n >= 4)
+				memcpy(resp, req, 4);	/* the client's sequence# */
+			if (sendto(fd, resp, readlen, 0, (struct sockaddr *) &from,
+					   len) != readlen && ignorewerr == 0)
+				err_sys("sendto error");
+			continue;
+		}
+
+		if ( (n = rr_read(fd, req, writelen)) == 0)
+			break;				/* client is done */
+		rr_write(fd, resp, readlen);
+		if (pauserw)
+			sleep_us(pauserw*1000);
+	}
+
+	if (pauseclose) {
+		if (verbose)
+				fprintf(stderr, "pausing before close\n");
+		sleep_us(pauseclose*1000);
+	}
+
+	if (close(fd) < 0)
+		err_sys("close error");
+}
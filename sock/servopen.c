@@ -94,6 +94,7 @@ servopen(char *host, char *port)
 	sockopts(fd, 0);	/* only set some socket options for fd */
 
 	listen(fd, listenq);
+	listenfd = fd;		/* sink_streams() accepts more connections */
 
 	if (pauselisten)
 		sleep_us(pauselisten*1000);		/* lets connection queue build up */
@@ -19,6 +19,7 @@
 				/* declare global variables */
 extern int		bindport;
 extern int		broadcast;
+extern int		busypoll;
 extern int		cbreak;
 extern int		chunkwrite;
 extern int		client;
@@ -27,27 +28,32 @@ extern int		crlf;
 extern int		debug;
 extern int		dofork;
 extern int		dontroute;
+extern int		duration;
 extern char		foreignip[];
 extern int		foreignport;
 extern int		halfclose;
 extern int		ignorewerr;
+extern int		interval;
 extern int		iptos;
 extern int		ipttl;
 extern char		joinip[];
 extern int		keepalive;
 extern long		linger;
 extern int		listenq;
+extern int		listenfd;
 extern char		localip[];
 extern int		maxseg;
 extern int		mcastttl;
 extern int		msgpeek;
 extern int		nodelay;
 extern int		nbuf;
+extern int		nstreams;
 extern int		onesbcast;
 extern int		pauseclose;
 extern int		pauseinit;
 extern int		pauselisten;
 extern int		pauserw;
+extern int		pipeline;
 extern int		reuseaddr;
 extern int		reuseport;
 extern int		readlen;
@@ -62,11 +68,15 @@ extern char	   *wbuf;
 extern int		server;
 extern int		sigio;
 extern int		sourcesink;
+extern int		spinread;
 extern int		sroute_cnt;
 extern int		udp;
 extern int		urgwrite;
 extern int		verbose;
 extern int		usewritev;
+extern int		usecork;
+extern int		usemore;
+extern int		zerocopy;
 
 extern struct sockaddr_in	cliaddr, servaddr;
 
@@ -88,17 +98,23 @@ int		crlf_strip(char *, int, const char *, int);
 void	join_mcast(int, struct sockaddr_in *);
 void	loop_tcp(int);
 void	loop_udp(int);
+double	now(void);
 void	pattern(char *, int);
+void	rr_client(int);
+void	rr_server(int);
 int		servopen(char *, char *);
 void	sink_tcp(int);
+void	sink_streams(int);
 void	sink_udp(int);
 void	source_tcp(int);
+void	source_streams(int, char *, char *);
 void	source_udp(int);
 void	sroute_doopt(int, char *);
 void	sroute_set(int);
 void	sleep_us(unsigned int);
 void	sockopts(int, int);
 ssize_t	dowrite(int, const void *, size_t);
+void	dowrite_done(int);
 
 void	TELL_WAIT(void);
 void	TELL_PARENT(pid_t);
@@ -11,6 +11,10 @@
 #include	<fcntl.h>
 #include	<sys/ioctl.h>
 
+#ifdef	FIOASYNC
+static void	sigio_func(int);
+#endif
+
 void
 sockopts(int sockfd, int doall)
 {
@@ -304,6 +308,34 @@ sockopts(int sockfd, int doall)
 #endif
     }
 
+    if (zerocopy) {
+		if (zc_enable(sockfd) < 0)
+			err_sys("SO_ZEROCOPY setsockopt error");
+		if (verbose)
+			fprintf(stderr, "SO_ZEROCOPY set\n");
+    }
+
+    if (doall && busypoll) {
+#ifdef	SO_BUSY_POLL
+		/* #usec to busy poll the device queue on a blocking read */
+        option = busypoll;
+        if (setsockopt(sockfd, SOL_SOCKET, SO_BUSY_POLL,
+										&option, sizeof(option)) < 0)
+            err_sys("SO_BUSY_POLL setsockopt error");
+
+        option = 0;
+		optlen = sizeof(option);
+        if (getsockopt(sockfd, SOL_SOCKET, SO_BUSY_POLL,
+										&option, &optlen) < 0)
+            err_sys("SO_BUSY_POLL getsockopt error");
+
+		if (verbose)
+			fprintf(stderr, "SO_BUSY_POLL: %d usec\n", option);
+#else
+		fprintf(stderr, "warning: SO_BUSY_POLL not supported by host\n");
+#endif
+    }
+
     if (recvdstaddr && udp) {
 #ifdef	IP_RECVDSTADDR
         option = 1;
@@ -328,8 +360,6 @@ sockopts(int sockfd, int doall)
 
     if (sigio) {
 #ifdef	FIOASYNC
-		static void sigio_func(int);
-
 		/*
 		 * Should be able to set this with fcntl(O_ASYNC) or fcntl(FASYNC),
 		 * but some systems (AIX?) only do it with ioctl().
@@ -31,7 +31,7 @@ source_tcp(int sockfd)
 				fprintf(stderr, "wrote %d byte of urgent data\n", n);
 		}
 
-		if ( (n = write(sockfd, wbuf, writelen)) != writelen) {
+		if ( (n = dowrite(sockfd, wbuf, writelen)) != writelen) {
 			if (ignorewerr) {
 				err_ret("write returned %d, expected %d", n, writelen);
 						/* also call getsockopt() to clear so_error */
@@ -49,6 +49,8 @@ source_tcp(int sockfd)
 			sleep_us(pauserw*1000);
 	}
 
+	dowrite_done(sockfd);
+
 	if (pauseclose) {
 		if (verbose)
 				fprintf(stderr, "pausing before close\n");
@@ -0,0 +1,484 @@
+#include	"sock.h"
+#include	"unpthread.h"
+#include	<sys/resource.h>
+
+/*
+ * Parallel throughput mode (-m n).  The client opens n connections (or
+ * connected UDP sockets) and gives each one its own thread, which writes
+ * writelen bytes at a time for "duration" seconds.  The server gives each
+ * connection it accepts its own thread (a UDP server tells the streams
+ * apart by the client's address).  Meanwhile the main thread prints the
+ * throughput of every stream and their sum every "interval" seconds, plus
+ * a TCP_INFO sample for each TCP stream, and the totals at the end.
+ *
+ * Each UDP datagram carries a sequence number in its first 4 bytes so the
+ * server can count the ones that were lost; a zero-length datagram ends
+ * the stream, as it does for sink_udp().
+ *
+ * The totals include the CPU time used per gigabyte moved, to compare
+ * the ways of sending (-0, -1, -3, -k, -V) on the same pair of hosts.
+ */
+
+#define	MAXSTREAMS	128
+
+static struct stream {
+  int			st_fd;			/* -1 for a UDP server's stream */
+  pthread_t		st_tid;
+  volatile int	st_done;		/* set once the stream has finished */
+  double		st_start, st_end;	/* seconds, from now() */
+  uint64_t		st_bytes;		/* written only by the stream's own thread */
+  uint64_t		st_lastbytes;	/* st_bytes at the previous report */
+  uint32_t		st_npkts;		/* UDP server: datagrams received */
+  uint32_t		st_nseq;		/* UDP server: highest sequence# + 1 */
+  uint32_t		st_lastpkts, st_lastseq;	/* at the previous report */
+  uint32_t		st_lastretrans;	/* TCP_INFO retransmits, previous report */
+  struct sockaddr_in	st_peer;	/* UDP server: the client's address */
+} streams[MAXSTREAMS];
+
+static int				nactive;	/* # entries in use in streams[] */
+static pthread_mutex_t	slock = PTHREAD_MUTEX_INITIALIZER;
+static volatile int		stop;		/* client: time is up */
+static struct rusage	ru0;		/* CPU used before the streams started */
+
+/*
+ * Seconds on a clock that doesn't jump; for measuring intervals only.
+ */
+double
+now(void)
+{
+	struct timespec	ts;
+
+#ifdef	CLOCK_MONOTONIC
+	if (clock_gettime(CLOCK_MONOTONIC, &ts) == -1)
+		err_sys("clock_gettime error");
+#else
+	tstamp_now(&ts);
+#endif
+	return(ts.tv_sec + ts.tv_nsec / 1e9);
+}
+
+/*
+ * Append a TCP_INFO sample for the stream to "buf": smoothed RTT,
+ * congestion window (in segments) and retransmits since the last sample.
+ */
+static void
+tcp_sample(struct stream *st, char *buf, size_t len)
+{
+#if	defined(TCP_INFO) && defined(__linux__)
+	struct tcp_info	ti;
+	socklen_t		tilen;
+
+	tilen = sizeof(ti);
+	if (udp || st->st_fd < 0 || st->st_done ||
+		getsockopt(st->st_fd, IPPROTO_TCP, TCP_INFO, &ti, &tilen) < 0)
+		return;
+	snprintf(buf + strlen(buf), len - strlen(buf),
+			 "  rtt %7.3f ms  cwnd %5u  retrans %u",
+			 ti.tcpi_rtt / 1000.0, ti.tcpi_snd_cwnd,
+			 ti.tcpi_total_retrans - st->st_lastretrans);
+	st->st_lastretrans = ti.tcpi_total_retrans;
+#endif
+}
+
+static void
+print_rate(const char *name, double t0, double t1, uint64_t nbytes,
+		   const char *extra)
+{
+	printf("%-5s %6.1f-%6.1f sec %10.2f MB %10.2f Mbit/s%s\n", name, t0, t1,
+		   nbytes / 1048576.0,
+		   (t1 > t0) ? nbytes * 8 / (t1 - t0) / 1e6 : 0.0, extra);
+}
+
+/*
+ * One line per stream for the interval [t0, t1] (seconds since "start"),
+ * then the sum if there is more than one stream.
+ */
+static void
+report_interval(double start, double t0, double t1)
+{
+	int				i, n;
+	uint64_t		bytes, delta, sum;
+	uint32_t		npkts, nseq, expect, got;
+	struct stream	*st;
+	char			name[8], extra[128];
+
+	Pthread_mutex_lock(&slock);
+	n = nactive;
+	Pthread_mutex_unlock(&slock);
+
+	sum = 0;
+	for (i = 0; i < n; i++) {
+		st = &streams[i];
+		bytes = st->st_bytes;
+		delta = bytes - st->st_lastbytes;
+		st->st_lastbytes = bytes;
+		sum += delta;
+		if (st->st_done && delta == 0)
+			continue;			/* finished before this interval */
+
+		extra[0] = 0;
+		if (udp && server) {
+			npkts = st->st_npkts;
+			nseq = st->st_nseq;
+			expect = nseq - st->st_lastseq;
+			got = npkts - st->st_lastpkts;
+			snprintf(extra, sizeof(extra), "  %u/%u lost",
+					 (expect > got) ? expect - got : 0, expect);
+			st->st_lastpkts = npkts;
+			st->st_lastseq = nseq;
+		} else
+			tcp_sample(st, extra, sizeof(extra));
+		snprintf(name, sizeof(name), "[%2d]", i + 1);
+		print_rate(name, t0 - start, t1 - start, delta, extra);
+	}
+	if (n > 1)
+		print_rate("[SUM]", t0 - start, t1 - start, sum, "");
+	fflush(stdout);
+}
+
+/*
+ * Each stream's total over its own lifetime, then the sum over the
+ * whole run.
+ */
+static void
+report_total(double start, double end)
+{
+	int				i;
+	uint64_t		sum;
+	double			user, sys;
+	struct rusage	ru;
+	struct stream	*st;
+	char			name[8], extra[64];
+
+	printf("- - - - - - - - - - - - - - - - - - - - - - - - -\n");
+	sum = 0;
+	for (i = 0; i < nactive; i++) {
+		st = &streams[i];
+		sum += st->st_bytes;
+		extra[0] = 0;
+		if (udp && server)
+			snprintf(extra, sizeof(extra), "  %u/%u lost",
+					 (st->st_nseq > st->st_npkts) ? st->st_nseq - st->st_npkts : 0,
+					 st->st_nseq);
+		snprintf(name, sizeof(name), "[%2d]", i + 1);
+		print_rate(name, st->st_start - start,
+				   (st->st_done ? st->st_end : end) - start,
+				   st->st_bytes, extra);
+	}
+	if (nactive > 1)
+		print_rate("[SUM]", 0.0, end - start, sum, "");
+
+	if (getrusage(RUSAGE_SELF, &ru) < 0)
+		err_sys("getrusage error");
+	user = (ru.ru_utime.tv_sec - ru0.ru_utime.tv_sec) +
+		   (ru.ru_utime.tv_usec - ru0.ru_utime.tv_usec) / 1e6;
+	sys  = (ru.ru_stime.tv_sec - ru0.ru_stime.tv_sec) +
+		   (ru.ru_stime.tv_usec - ru0.ru_stime.tv_usec) / 1e6;
+	printf("cpu   %.2f user + %.2f sys sec = %.3f sec/GB\n", user, sys,
+		   (sum > 0) ? (user + sys) / (sum / 1e9) : 0.0);
+	fflush(stdout);
+}
+
+static int
+all_done(void)
+{
+	int		i, done;
+
+	Pthread_mutex_lock(&slock);
+	done = (nactive > 0);
+	for (i = 0; i < nactive; i++)
+		if (streams[i].st_done == 0)
+			done = 0;
+	Pthread_mutex_unlock(&slock);
+	return(done);
+}
+
+/*
+ * Report every "interval" seconds until "end" (client), or, if "end"
+ * is 0, until every stream has finished (server).  Return the time the
+ * last interval ended.
+ */
+static double
+report_loop(double start, double end)
+{
+	double	t, tlast, next, wake;
+
+	tlast = start;
+	next = (interval > 0) ? start + interval : 0;
+	for ( ; ; ) {
+		t = now();
+		if ((end > 0 && t >= end) || (end == 0 && all_done()))
+			break;
+		if (next > 0 && t >= next) {
+			report_interval(start, tlast, t);
+			tlast = t;
+			next += interval;
+			continue;
+		}
+		wake = next;
+		if (end > 0 && (wake == 0 || end < wake))
+			wake = end;
+		if (end == 0 && (wake == 0 || wake - t > 0.1))
+			wake = t + 0.1;		/* server: look for the end often */
+		sleep_us((wake - t) * 1e6);
+	}
+	if (next > 0 && t > tlast)
+		report_interval(start, tlast, t);	/* the final, partial interval */
+	return(t);
+}
+
+static void *
+source_stream(void *arg)
+{
+	int				n, option;
+	uint32_t		seq, nseq;
+	socklen_t		optlen;
+	char			*buf;
+	struct stream	*st = arg;
+
+	buf = wbuf;
+	if (udp) {
+		buf = Malloc(writelen);		/* our own copy, for the sequence# */
+		memcpy(buf, wbuf, writelen);
+	}
+
+	for (seq = 0; stop == 0; ) {
+		if (udp) {
+			nseq = htonl(seq);
+			memcpy(buf, &nseq, sizeof(nseq));
+		}
+		if ( (n = dowrite(st->st_fd, buf, writelen)) != writelen) {
+			if (udp && errno == ENOBUFS)
+				continue;			/* interface queue full; try again */
+			if (ignorewerr) {
+				err_ret("write returned %d, expected %d", n, writelen);
+					/* also call getsockopt() to clear so_error */
+				optlen = sizeof(option);
+				if (getsockopt(st->st_fd, SOL_SOCKET, SO_ERROR,
+							   &option, &optlen) < 0)
+					err_sys("SO_ERROR getsockopt error");
+				continue;
+			}
+			err_sys("write returned %d, expected %d", n, writelen);
+		}
+		st->st_bytes += n;
+		seq++;
+		if (pauserw)
+			sleep_us(pauserw*1000);
+	}
+	st->st_end = now();
+	dowrite_done(st->st_fd);
+
+	if (udp) {
+		for (n = 0; n < 3; n++) {	/* in case one is lost */
+			write(st->st_fd, buf, 0);
+			sleep_us(10000);
+		}
+		free(buf);
+	}
+	st->st_done = 1;
+	return(NULL);
+}
+
+void
+source_streams(int fd, char *host, char *port)
+{
+	int		i;
+	double	start, end;
+
+	pattern(wbuf, writelen);	/* fill send buffer with a pattern */
+
+	streams[0].st_fd = fd;
+	for (i = 1; i < nstreams; i++)
+		streams[i].st_fd = cliopen(host, port);
+	nactive = nstreams;
+
+	if (pauseinit)
+		sleep_us(pauseinit*1000);
+
+	if (getrusage(RUSAGE_SELF, &ru0) < 0)
+		err_sys("getrusage error");
+	start = now();
+	for (i = 0; i < nstreams; i++) {
+		streams[i].st_start = start;
+		Pthread_create(&streams[i].st_tid, NULL, source_stream, &streams[i]);
+	}
+
+	end = report_loop(start, start + duration);
+	stop = 1;
+	for (i = 0; i < nstreams; i++)
+		Pthread_join(streams[i].st_tid, NULL);
+	report_total(start, end);
+
+	for (i = 0; i < nstreams; i++)
+		if (close(streams[i].st_fd) < 0)
+			err_sys("close error");		/* since SO_LINGER may be set */
+}
+
+static void *
+sink_stream(void *arg)
+{
+	int				n;
+	char			*buf;
+	struct stream	*st = arg;
+
+	buf = Malloc(readlen);		/* rbuf is shared by all the threads */
+	for ( ; ; ) {
+		if ( (n = read(st->st_fd, buf, readlen)) < 0) {
+			if (errno == EINTR)
+				continue;
+			err_sys("read error");
+		} else if (n == 0)
+			break;				/* peer closed the connection */
+		st->st_bytes += n;
+		if (pauserw)
+			sleep_us(pauserw*1000);
+	}
+	free(buf);
+	st->st_end = now();
+	st->st_done = 1;			/* leave the descriptor open until exit */
+	return(NULL);
+}
+
+static struct stream *
+add_stream(int fd)
+{
+	struct stream	*st;
+
+	Pthread_mutex_lock(&slock);
+	if (nactive >= MAXSTREAMS)
+		err_quit("more than %d streams", MAXSTREAMS);
+	st = &streams[nactive];
+	st->st_fd = fd;
+	st->st_start = now();
+	nactive++;
+	Pthread_mutex_unlock(&slock);
+	return(st);
+}
+
+/*
+ * TCP server: accept more connections for as long as the test runs.
+ * The client opens all its connections before it starts writing, so
+ * they are all queued by the time the first stream's data arrives.
+ */
+static void *
+acceptor(void *arg)
+{
+	int				fd;
+	socklen_t		len;
+	struct stream	*st;
+
+	for ( ; ; ) {
+		len = sizeof(cliaddr);
+		if ( (fd = accept(listenfd, (struct sockaddr *) &cliaddr, &len)) < 0) {
+			if (errno == EINTR || errno == ECONNABORTED)
+				continue;
+			err_sys("accept() error");
+		}
+		buffers(fd);
+		sockopts(fd, 1);
+		st = add_stream(fd);
+		Pthread_create(&st->st_tid, NULL, sink_stream, st);
+		Pthread_detach(st->st_tid);
+	}
+	return(NULL);
+}
+
+/*
+ * UDP server: one thread reads the socket and files each datagram
+ * under the stream of the address it came from.
+ */
+static void *
+sink_udpstreams(void *arg)
+{
+	int				fd, i, n;
+	uint32_t		seq;
+	socklen_t		len;
+	struct sockaddr_in	from;
+	struct stream	*st;
+
+	fd = (int) (long) arg;
+	for ( ; ; ) {
+		len = sizeof(from);
+		if ( (n = recvfrom(fd, rbuf, readlen, 0,
+						   (struct sockaddr *) &from, &len)) < 0) {
+			if (errno == EINTR)
+				continue;
+			err_sys("recvfrom error");
+		}
+
+		st = NULL;
+		for (i = 0; i < nactive; i++) {	/* we're the only writer */
+			if (streams[i].st_peer.sin_port == from.sin_port &&
+				streams[i].st_peer.sin_addr.s_addr == from.sin_addr.s_addr) {
+				st = &streams[i];
+				break;
+			}
+		}
+		if (st == NULL) {
+			if (n == 0)
+				continue;			/* a duplicate end marker */
+			Pthread_mutex_lock(&slock);
+			if (nactive >= MAXSTREAMS)
+				err_quit("more than %d streams", MAXSTREAMS);
+			st = &streams[nactive];
+			st->st_fd = -1;
+			st->st_peer = from;
+			st->st_start = now();
+			nactive++;
+			Pthread_mutex_unlock(&slock);
+		}
+		if (st->st_done)
+			continue;
+
+		if (n == 0) {				/* end of this stream */
+			st->st_end = now();
+			st->st_done = 1;
+			continue;
+		}
+		st->st_bytes += n;
+		st->st_npkts++;
+		if (n >= sizeof(seq)) {
+			memcpy(&seq, rbuf, sizeof(seq));
+			seq = ntohl(seq);
+			if (seq + 1 > st->st_nseq)
+				st->st_nseq = seq + 1;
+		}
+	}
+	return(NULL);
+}
+
+void
+sink_streams(int fd)
+{
+	int			n;
+	double		start, end;
+	pthread_t	tid;
+	struct stream	*st;
+
+	if (pauseinit)
+		sleep_us(pauseinit*1000);
+
+	if (getrusage(RUSAGE_SELF, &ru0) < 0)
+		err_sys("getrusage error");
+	start = now();
+	if (udp) {
+		Pthread_create(&tid, NULL, sink_udpstreams, (void *) (long) fd);
+		for (n = 0; n == 0; ) {		/* time starts at the first datagram */
+			sleep_us(10000);
+			Pthread_mutex_lock(&slock);
+			if ( (n = nactive) > 0)
+				start = streams[0].st_start;
+			Pthread_mutex_unlock(&slock);
+		}
+	} else {
+		st = add_stream(fd);
+		Pthread_create(&st->st_tid, NULL, sink_stream, st);
+		Pthread_detach(st->st_tid);
+		Pthread_create(&tid, NULL, acceptor, NULL);
+	}
+	Pthread_detach(tid);
+
+	end = report_loop(start, 0);
+	report_total(start, end);
+}
@@ -14,6 +14,8 @@
 #define	UIO_MAXIOV	16	/* we assume this; may not be true? */
 #endif
 
+static struct zcstate	zcs[FD_SETSIZE];	/* -0, indexed by descriptor */
+
 ssize_t
 dowrite(int fd, const void *vptr, size_t nbytes)
 {
@@ -21,6 +23,12 @@ dowrite(int fd, const void *vptr, size_t nbytes)
 	const char		*ptr;
 	int				chunksize, i, n, nleft, nwritten, ntotal;
 
+	if (zerocopy) {
+		if (fd >= FD_SETSIZE)
+			err_quit("descriptor %d too large for -0", fd);
+		return(writen_zc(fd, vptr, nbytes, &zcs[fd]));
+	}
+
 	if (chunkwrite == 0 && usewritev == 0)
 		return(write(fd, vptr, nbytes));		/* common case */
 
@@ -51,16 +59,42 @@ dowrite(int fd, const void *vptr, size_t nbytes)
 	if (i == UIO_MAXIOV)
 		err_quit("i == UIO_MAXIOV");
 
+	if (usecork && tcp_cork(fd, 1) < 0)	/* hold the chunks ... */
+		err_sys("TCP_CORK error");
+
 	if (usewritev)
-		return(writev(fd, iov, i+1));
+		ntotal = writev(fd, iov, i+1);
 	else {
 		ntotal = 0;
 		for (n = 0; n <= i; n++) {
-			nwritten = write(fd, iov[n].iov_base, iov[n].iov_len);
+			if (usemore)	/* MSG_MORE on all but the last chunk */
+				nwritten = writen_more(fd, iov[n].iov_base, iov[n].iov_len,
+									   n < i);
+			else
+				nwritten = write(fd, iov[n].iov_base, iov[n].iov_len);
 			if (nwritten != iov[n].iov_len)
 				return(-1);
 			ntotal += nwritten;
 		}
-		return(ntotal);
 	}
+
+	if (usecork && tcp_cork(fd, 0) < 0)	/* ... then send them together */
+		err_sys("TCP_CORK error");
+	return(ntotal);
+}
+
+/*
+ * Called before closing a descriptor written with dowrite(): wait for
+ * the kernel to finish with any zerocopy sends, and say how many of
+ * them it had to copy after all (all of them, over loopback).
+ */
+void
+dowrite_done(int fd)
+{
+	if (zerocopy == 0 || fd >= FD_SETSIZE)
+		return;
+	if (zc_reap(fd, &zcs[fd], 1) < 0)
+		err_sys("zc_reap error");
+	fprintf(stderr, "zerocopy: %u sends, %u copied by the kernel\n",
+			zcs[fd].zc_sent, zcs[fd].zc_copied);
 }
@@ -0,0 +1,64 @@
+/*
+ * str_echo09 does a readn() and a writen() for each 16-byte request.
+ * Here one read() takes whatever the client has sent, every complete
+ * frame in the buffer is answered, and all the replies go back in one
+ * write().  A frame cut off at the end of the buffer is moved to the
+ * front and completed by the next read().  A client that keeps many
+ * requests in flight gets many answered per pair of system calls.
+ */
+#include	"unp.h"
+#include	"sumframe.h"
+
+#define	INBUF	65536
+
+static char	in[INBUF];
+static char	out[2 * INBUF];	/* a reply is at most twice its request */
+
+void
+str_echo(int sockfd)
+{
+	ssize_t		n;
+	size_t		have, off, nout;
+	uint32_t	len, id;
+	char		*ptr;
+
+	have = 0;
+	for ( ; ; ) {
+		if ( (n = read(sockfd, in + have, sizeof(in) - have)) < 0) {
+			if (errno == EINTR)
+				continue;
+			err_sys("str_echo: read error");
+		} else if (n == 0)
+			return;		/* connection closed by other end */
+		have += n;
+
+			/* 4answer every complete frame */
+		off = nout = 0;
+		while (have - off >= FRAME_HDRLEN) {
+			frame_get_hdr(in + off, &len, &id);
+			if (len > FRAME_MAXLEN) {
+				err_msg("str_echo: %u-byte frame, closing", len);
+				return;
+			}
+			if (have - off < FRAME_HDRLEN + len)
+				break;		/* rest of it not here yet */
+
+			ptr = in + off + FRAME_HDRLEN;
+			if (len == FRAME_ARGSLEN) {
+				frame_put_hdr(out + nout, FRAME_SUMLEN, id);
+				frame_put64(out + nout + FRAME_HDRLEN,
+							frame_get64(ptr) + frame_get64(ptr + 8));
+				nout += FRAME_HDRLEN + FRAME_SUMLEN;
+			} else {
+				frame_put_hdr(out + nout, 0, id);
+				nout += FRAME_HDRLEN;
+			}
+			off += FRAME_HDRLEN + len;
+		}
+		if (nout > 0)
+			Writen(sockfd, out, nout);
+
+		memmove(in, in + off, have - off);
+		have -= off;
+	}
+}
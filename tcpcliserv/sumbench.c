@@ -0,0 +1,123 @@
+/*
+ * Requests per second to the sum server.  Sends -n requests over one
+ * connection, keeping up to -w of them in flight: each time round it
+ * writes as many new requests as the window allows in one write(), then
+ * reads what replies have come back.  -w 1 is str_cli09's one request,
+ * one reply.  By default it speaks the framed protocol of str_echo10
+ * (tcpserv10) and checks each reply's id; with -9 it sends struct args
+ * to str_echo09 (tcpserv09), which answers them one at a time.
+ */
+#include	"unp.h"
+#include	"sum.h"
+#include	"sumframe.h"
+
+#define	MAXWINDOW	4096
+#define	REQLEN		(FRAME_HDRLEN + FRAME_ARGSLEN)
+
+static char	out[MAXWINDOW * REQLEN];
+static char	in[65536];
+
+int
+main(int argc, char **argv)
+{
+	int					c, sockfd, old, window;
+	long				i, nreq, sent, recvd;
+	ssize_t				n;
+	size_t				have, off, nout;
+	uint32_t			len, id;
+	double				usec;
+	struct args			args;
+	struct result		result;
+	struct sockaddr_in	servaddr;
+	struct timeval		start, end;
+
+	old = 0;
+	nreq = 100000;
+	window = 64;
+	opterr = 0;
+	while ( (c = getopt(argc, argv, "9n:w:")) != -1) {
+		switch (c) {
+		case '9':
+			old = 1;
+			break;
+		case 'n':
+			nreq = atol(optarg);
+			break;
+		case 'w':
+			window = atoi(optarg);
+			break;
+		case '?':
+			err_quit("unrecognized option: %c", optopt);
+		}
+	}
+	if (optind != argc - 1 || nreq < 1 || window < 1 || window > MAXWINDOW)
+		err_quit("usage: sumbench [ -9 ] [ -n #requests ] [ -w window ] "
+				 "<IPaddress>");
+
+	sockfd = Socket(AF_INET, SOCK_STREAM, 0);
+	bzero(&servaddr, sizeof(servaddr));
+	servaddr.sin_family = AF_INET;
+	servaddr.sin_port = htons(SERV_PORT);
+	Inet_pton(AF_INET, argv[optind], &servaddr.sin_addr);
+	Connect(sockfd, (SA *) &servaddr, sizeof(servaddr));
+
+	Gettimeofday(&start, NULL);
+	sent = recvd = 0;
+	have = 0;
+	while (recvd < nreq) {
+			/* 4fill the window, one write() */
+		nout = 0;
+		for ( ; sent < nreq && sent - recvd < window; sent++) {
+			if (old) {
+				args.arg1 = sent;
+				args.arg2 = 2 * sent;
+				memcpy(out + nout, &args, sizeof(args));
+				nout += sizeof(args);
+			} else {
+				frame_put_hdr(out + nout, FRAME_ARGSLEN, (uint32_t) sent);
+				frame_put64(out + nout + FRAME_HDRLEN, sent);
+				frame_put64(out + nout + FRAME_HDRLEN + 8, 2 * sent);
+				nout += REQLEN;
+			}
+		}
+		if (nout > 0)
+			Writen(sockfd, out, nout);
+
+			/* 4take whatever replies are there */
+		if ( (n = Read(sockfd, in + have, sizeof(in) - have)) == 0)
+			err_quit("sumbench: server terminated prematurely");
+		have += n;
+		off = 0;
+		if (old) {
+			for ( ; have - off >= sizeof(result); off += sizeof(result)) {
+				memcpy(&result, in + off, sizeof(result));
+				if (result.sum != 3 * recvd)
+					err_quit("reply %ld: sum %ld", recvd, result.sum);
+				recvd++;
+			}
+		} else {
+			while (have - off >= FRAME_HDRLEN) {
+				frame_get_hdr(in + off, &len, &id);
+				if (len != FRAME_SUMLEN || id != (uint32_t) recvd)
+					err_quit("reply %ld: id %u, %u bytes", recvd, id, len);
+				if (have - off < FRAME_HDRLEN + len)
+					break;
+				i = frame_get64(in + off + FRAME_HDRLEN);
+				if (i != 3 * recvd)
+					err_quit("reply %ld: sum %ld", recvd, i);
+				recvd++;
+				off += FRAME_HDRLEN + len;
+			}
+		}
+		memmove(in, in + off, have - off);
+		have -= off;
+	}
+	Gettimeofday(&end, NULL);
+	tv_sub(&end, &start);
+
+	usec = end.tv_sec * 1e6 + end.tv_usec;
+	printf("%s, window %d: %ld requests in %.1f ms, %.0f requests/sec\n",
+		   old ? "str_echo09" : "str_echo10", window, nreq, usec / 1e3,
+		   nreq / (usec / 1e6));
+	exit(0);
+}
@@ -0,0 +1,43 @@
+#include	"unp.h"
+#include	"sumframe.h"
+
+void
+frame_put_hdr(char *ptr, uint32_t len, uint32_t id)
+{
+	len = htonl(len);
+	id = htonl(id);
+	memcpy(ptr, &len, 4);
+	memcpy(ptr + 4, &id, 4);
+}
+
+void
+frame_get_hdr(const char *ptr, uint32_t *lenp, uint32_t *idp)
+{
+	uint32_t	len, id;
+
+	memcpy(&len, ptr, 4);
+	memcpy(&id, ptr + 4, 4);
+	*lenp = ntohl(len);
+	*idp = ntohl(id);
+}
+
+void
+frame_put64(char *ptr, int64_t val)
+{
+	uint32_t	hi, lo;
+
+	hi = htonl((uint32_t) ((uint64_t) val >> 32));
+	lo = htonl((uint32_t) val);
+	memcpy(ptr, &hi, 4);
+	memcpy(ptr + 4, &lo, 4);
+}
+
+int64_t
+frame_get64(const char *ptr)
+{
+	uint32_t	hi, lo;
+
+	memcpy(&hi, ptr, 4);
+	memcpy(&lo, ptr + 4, 4);
+	return((int64_t) (((uint64_t) ntohl(hi) << 32) | ntohl(lo)));
+}
@@ -0,0 +1,17 @@
+/*
+ * Framed version of sum.h.  Every message is an 8-byte header, the length
+ * of the payload and a request id that the reply carries back, followed
+ * by the payload.  All integers are in network byte order, so unlike
+ * struct args the messages mean the same on any two hosts.  A request's
+ * payload is two 64-bit arguments, a reply's is their 64-bit sum; a reply
+ * with no payload means the request was not understood.
+ */
+#define	FRAME_HDRLEN	8		/* uint32 payload length, uint32 id */
+#define	FRAME_MAXLEN	4096	/* largest payload accepted */
+#define	FRAME_ARGSLEN	16		/* request payload */
+#define	FRAME_SUMLEN	8		/* reply payload */
+
+void		 frame_put_hdr(char *, uint32_t, uint32_t);
+void		 frame_get_hdr(const char *, uint32_t *, uint32_t *);
+void		 frame_put64(char *, int64_t);
+int64_t		 frame_get64(const char *);
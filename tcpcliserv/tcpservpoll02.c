@@ -0,0 +1,93 @@
+/*
+ * tcpservpoll01 with a bufev for each client.  tcpservpoll01 echoes with
+ * a blocking Writen(), so one client that sends but does not read stops
+ * the server for everyone once that client's socket buffer is full.
+ * Here what a client sends is moved to its own output buffer and written
+ * when poll() says the socket is writable; when the output reaches its
+ * high watermark the server stops reading from that client alone.
+ */
+#include	"unpbufev.h"
+#include	<limits.h>		/* for OPEN_MAX */
+
+#ifndef	OPEN_MAX
+#define	OPEN_MAX	1024	/* not in Linux's <limits.h> */
+#endif
+
+static void
+echo(struct bufev *bev, void *arg)	/* read some, or drained some */
+{
+	bufev_move(bev, bev);
+}
+
+int
+main(int argc, char **argv)
+{
+	int					i, maxi, listenfd, connfd, sockfd;
+	int					nready;
+	socklen_t			clilen;
+	struct pollfd		client[OPEN_MAX];
+	struct bufev		*bev[OPEN_MAX];
+	struct sockaddr_in	cliaddr, servaddr;
+
+	listenfd = Socket(AF_INET, SOCK_STREAM, 0);
+
+	bzero(&servaddr, sizeof(servaddr));
+	servaddr.sin_family      = AF_INET;
+	servaddr.sin_addr.s_addr = htonl(INADDR_ANY);
+	servaddr.sin_port        = htons(SERV_PORT);
+
+	Bind(listenfd, (SA *) &servaddr, sizeof(servaddr));
+
+	Listen(listenfd, LISTENQ);
+
+	client[0].fd = listenfd;
+	client[0].events = POLLRDNORM;
+	for (i = 1; i < OPEN_MAX; i++)
+		client[i].fd = -1;		/* -1 indicates available entry */
+	maxi = 0;					/* max index into client[] array */
+
+	for ( ; ; ) {
+		for (i = 1; i <= maxi; i++)
+			if (client[i].fd >= 0)
+				client[i].events = bufev_events(bev[i]);
+		nready = Poll(client, maxi+1, INFTIM);
+
+		if (client[0].revents & POLLRDNORM) {	/* new client connection */
+			clilen = sizeof(cliaddr);
+			connfd = Accept(listenfd, (SA *) &cliaddr, &clilen);
+
+			for (i = 1; i < OPEN_MAX; i++)
+				if (client[i].fd < 0) {
+					client[i].fd = connfd;	/* save descriptor */
+					break;
+				}
+			if (i == OPEN_MAX)
+				err_quit("too many clients");
+
+			bev[i] = bufev_new(connfd);
+			bufev_setcb(bev[i], echo, echo, NULL, NULL);
+			client[i].events = 0;
+			client[i].revents = 0;
+			if (i > maxi)
+				maxi = i;				/* max index in client[] array */
+
+			if (--nready <= 0)
+				continue;				/* no more ready descriptors */
+		}
+
+		for (i = 1; i <= maxi; i++) {	/* check all clients */
+			if ( (sockfd = client[i].fd) < 0 || client[i].revents == 0)
+				continue;
+			bufev_handle(bev[i], client[i].revents);
+			if (bufev_done(bev[i])) {
+					/*4closed or reset by client, all echoed */
+				Close(sockfd);
+				bufev_free(bev[i]);
+				client[i].fd = -1;
+			}
+
+			if (--nready <= 0)
+				break;					/* no more ready descriptors */
+		}
+	}
+}
@@ -1,16 +1,18 @@
 #include	"trace.h"
 
-struct proto	proto_v4 = { icmpcode_v4, recv_v4, NULL, NULL, NULL, NULL, 0,
-							 IPPROTO_ICMP, IPPROTO_IP, IP_TTL };
+struct proto	proto_v4 = { icmpcode_v4, recv_v4, match_v4, NULL, NULL, NULL,
+							 NULL, 0, IPPROTO_ICMP, IPPROTO_IP, IP_TTL };
 
 #ifdef	IPV6
-struct proto	proto_v6 = { icmpcode_v6, recv_v6, NULL, NULL, NULL, NULL, 0,
-							 IPPROTO_ICMPV6, IPPROTO_IPV6, IPV6_UNICAST_HOPS };
+struct proto	proto_v6 = { icmpcode_v6, recv_v6, match_v6, NULL, NULL, NULL,
+							 NULL, 0, IPPROTO_ICMPV6, IPPROTO_IPV6,
+							 IPV6_UNICAST_HOPS };
 #endif
 
 int		datalen = sizeof(struct rec);	/* defaults */
 int		max_ttl = 30;
 int		nprobes = 3;
+int		interval = 1;
 u_short	dport = 32768 + 666;
 
 int
@@ -21,8 +23,23 @@ main(int argc, char **argv)
 	char *h;
 
 	opterr = 0;		/* don't want getopt() writing to stderr */
-	while ( (c = getopt(argc, argv, "m:v")) != -1) {
+	while ( (c = getopt(argc, argv, "c:Ci:m:v")) != -1) {
 		switch (c) {
+		case 'c':
+			if ( (ncycles = atoi(optarg)) <= 0)
+				err_quit("invalid -c value");
+			continuous = 1;
+			break;
+
+		case 'C':
+			continuous = 1;
+			break;
+
+		case 'i':
+			if ( (interval = atoi(optarg)) <= 0)
+				err_quit("invalid -i value");
+			break;
+
 		case 'm':
 			if ( (max_ttl = atoi(optarg)) <= 1)
 				err_quit("invalid -m value");
@@ -38,7 +55,7 @@ main(int argc, char **argv)
 	}
 
 	if (optind != argc-1)
-		err_quit("usage: traceroute [ -m <maxttl> -v ] <hostname>");
+		err_quit("usage: traceroute [ -C -c <count> -i <secs> -m <maxttl> -v ] <hostname>");
 	host = argv[optind];
 
 	pid = getpid();
@@ -69,7 +86,10 @@ main(int argc, char **argv)
 	pr->sabind = Calloc(1, ai->ai_addrlen);
 	pr->salen = ai->ai_addrlen;
 
-	traceloop();
+	if (continuous)
+		mtrloop();
+	else
+		traceloop();
 
 	exit(0);
 }
@@ -0,0 +1,54 @@
+#include	"trace.h"
+
+/*
+ * Like recv_v4(), but for mtrloop(), which has probes for many TTLs
+ * outstanding at once: look at one received ICMP message and, if it is
+ * a reply to one of our probes, return its sequence number (taken from
+ * the UDP destination port, dport + seq) in *seqp.
+ *
+ * Return: -3 if not a reply to one of our probes
+ *		   -2 on ICMP time exceeded in transit
+ *		   -1 on ICMP port unreachable
+ *		 >= 0 return value is some other ICMP unreachable code
+ */
+
+int
+match_v4(char *ptr, ssize_t n, int *seqp)
+{
+	int				hlen1, hlen2, icmplen;
+	struct ip		*ip, *hip;
+	struct icmp		*icmp;
+	struct udphdr	*udp;
+
+	ip = (struct ip *) ptr;			/* start of IP header */
+	hlen1 = ip->ip_hl << 2;			/* length of IP header */
+
+	icmp = (struct icmp *) (ptr + hlen1);	/* start of ICMP header */
+	if ( (icmplen = n - hlen1) < 8)
+		return(-3);					/* not enough to look at ICMP header */
+
+	if ((icmp->icmp_type != ICMP_TIMXCEED ||
+		 icmp->icmp_code != ICMP_TIMXCEED_INTRANS) &&
+		icmp->icmp_type != ICMP_UNREACH)
+		return(-3);
+
+	if (icmplen < 8 + sizeof(struct ip))
+		return(-3);					/* not enough data to look at inner IP */
+
+	hip = (struct ip *) (ptr + hlen1 + 8);
+	hlen2 = hip->ip_hl << 2;
+	if (icmplen < 8 + hlen2 + 4)
+		return(-3);					/* not enough data to look at UDP ports */
+
+	udp = (struct udphdr *) (ptr + hlen1 + 8 + hlen2);
+	if (hip->ip_p != IPPROTO_UDP || udp->uh_sport != htons(sport))
+		return(-3);
+	if ( (*seqp = ntohs(udp->uh_dport) - dport) < 1 || *seqp > NPROBESEQ)
+		return(-3);
+
+	if (icmp->icmp_type == ICMP_TIMXCEED)
+		return(-2);					/* we hit an intermediate router */
+	if (icmp->icmp_code == ICMP_UNREACH_PORT)
+		return(-1);					/* have reached destination */
+	return(icmp->icmp_code);		/* 0, 1, 2, ... */
+}
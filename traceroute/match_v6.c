@@ -0,0 +1,42 @@
+#include	"trace.h"
+
+/*
+ * The IPv6 version of match_v4(); same return values.
+ */
+
+int
+match_v6(char *ptr, ssize_t n, int *seqp)
+{
+#ifdef	IPV6
+	struct ip6_hdr		*hip6;
+	struct icmp6_hdr	*icmp6;
+	struct udphdr		*udp;
+
+	icmp6 = (struct icmp6_hdr *) ptr;	/* ICMP header */
+	if (n < 8)
+		return(-3);					/* not enough to look at ICMP header */
+
+	if ((icmp6->icmp6_type != ICMP6_TIME_EXCEEDED ||
+		 icmp6->icmp6_code != ICMP6_TIME_EXCEED_TRANSIT) &&
+		icmp6->icmp6_type != ICMP6_DST_UNREACH)
+		return(-3);
+
+	if (n < 8 + sizeof(struct ip6_hdr) + 4)
+		return(-3);					/* not enough data to look at inner header */
+
+	hip6 = (struct ip6_hdr *) (ptr + 8);
+	udp = (struct udphdr *) (ptr + 8 + sizeof(struct ip6_hdr));
+	if (hip6->ip6_nxt != IPPROTO_UDP || udp->uh_sport != htons(sport))
+		return(-3);
+	if ( (*seqp = ntohs(udp->uh_dport) - dport) < 1 || *seqp > NPROBESEQ)
+		return(-3);
+
+	if (icmp6->icmp6_type == ICMP6_TIME_EXCEEDED)
+		return(-2);					/* we hit an intermediate router */
+	if (icmp6->icmp6_code == ICMP6_DST_UNREACH_NOPORT)
+		return(-1);					/* have reached destination */
+	return(icmp6->icmp6_code);		/* 0, 1, 2, ... */
+#else
+	return(-3);
+#endif
+}
@@ -0,0 +1,264 @@
+#include	"trace.h"
+
+/*
+ * Continuous traceroute (-C): every round sends one probe to every TTL
+ * at once instead of one probe at a time, then keeps going, like mtr,
+ * so loss and RTT per hop build up over time.  The reply for each probe
+ * is matched by its destination port, dport + seq, just as traceloop()
+ * does, but any number of probes may be outstanding.
+ */
+
+#define	PROBE_TIMEO	3		/* seconds until a probe counts as lost */
+#define	HOPWINDOW	20		/* Loss% and Avg cover the last # probes */
+
+static struct probe {
+  int				p_ttl;		/* 0 if not outstanding */
+  struct timespec	p_sent;		/* kernel transmit time, if we have it */
+} probes[NPROBESEQ + 1];		/* indexed by seq, 1..NPROBESEQ */
+
+static struct hop {
+  struct sockaddr_storage	hp_addr;	/* last responder, ss_family 0 if none */
+  int		hp_sent, hp_recv;		/* totals */
+  double	hp_last, hp_best, hp_worst;	/* ms, over all replies */
+  double	hp_win[HOPWINDOW];	/* ms, or -1 if lost: the last HOPWINDOW */
+  int		hp_nwin, hp_wpos;		/* # valid entries in hp_win[], next one */
+} *hops;						/* indexed by TTL, 1..max_ttl */
+
+static int		lasthop;		/* TTL at which the destination answered */
+static int		gotintr;
+
+static void
+sig_int(int signo)
+{
+	gotintr = 1;
+}
+
+static void
+hop_result(struct hop *h, double rtt)
+{
+	h->hp_win[h->hp_wpos] = rtt;
+	h->hp_wpos = (h->hp_wpos + 1) % HOPWINDOW;
+	if (h->hp_nwin < HOPWINDOW)
+		h->hp_nwin++;
+	if (rtt < 0)
+		return;					/* lost */
+
+	h->hp_last = rtt;
+	if (h->hp_recv == 0 || rtt < h->hp_best)
+		h->hp_best = rtt;
+	if (rtt > h->hp_worst)
+		h->hp_worst = rtt;
+	h->hp_recv++;
+}
+
+static void
+send_probe(int ttl)
+{
+	int				seq;
+	struct rec		*rec;
+	struct probe	*p;
+
+	seq = (nsent % NPROBESEQ) + 1;	/* the kernel numbers TX stamps nsent */
+	p = &probes[seq];
+	if (p->p_ttl != 0)
+		hop_result(&hops[p->p_ttl], -1);	/* seq reused; long since lost */
+
+	Setsockopt(sendfd, pr->ttllevel, pr->ttloptname, &ttl, sizeof(int));
+	rec = (struct rec *) sendbuf;
+	rec->rec_seq = seq;
+	rec->rec_ttl = ttl;
+	Gettimeofday(&rec->rec_tv, NULL);
+	p->p_ttl = ttl;
+	tstamp_now(&p->p_sent);
+
+	sock_set_port(pr->sasend, pr->salen, htons(dport + seq));
+	Sendto(sendfd, sendbuf, datalen, 0, pr->sasend, pr->salen);
+	nsent++;
+	hops[ttl].hp_sent++;
+}
+
+static void
+txreap(void)
+{
+	uint32_t		id;
+	struct timespec	ts;
+	struct probe	*p;
+
+	while (Tstamp_txreap(sendfd, &id, &ts) > 0) {
+		p = &probes[(id % NPROBESEQ) + 1];
+		if (p->p_ttl != 0)
+			p->p_sent = ts;
+	}
+}
+
+static void
+read_reply(void)
+{
+	int				seq, code;
+	ssize_t			n;
+	struct msghdr	msg;
+	struct iovec	iov;
+	struct timespec	tsrecv;
+	struct probe	*p;
+	struct hop		*h;
+	char			controlbuf[BUFSIZE], name[NI_MAXHOST];
+
+	iov.iov_base = recvbuf;
+	iov.iov_len = sizeof(recvbuf);
+	bzero(&msg, sizeof(msg));
+	msg.msg_name = pr->sarecv;
+	msg.msg_namelen = pr->salen;
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = controlbuf;
+	msg.msg_controllen = sizeof(controlbuf);
+	if ( (n = recvmsg(recvfd, &msg, 0)) < 0) {
+		if (errno == EINTR)
+			return;
+		err_sys("recvmsg error");
+	}
+	if (tstamp_recv(&msg, &tsrecv) == 0)
+		tstamp_now(&tsrecv);
+
+	if ( (code = (*pr->match)(recvbuf, n, &seq)) == -3) {
+		if (verbose)
+			printf(" (from %s: not one of our probes)\n",
+				   Sock_ntop_host(pr->sarecv, pr->salen));
+		return;
+	}
+	p = &probes[seq];
+	if (p->p_ttl == 0)
+		return;					/* duplicate, or already timed out */
+
+	if (tsflags & TSTAMP_TX)
+		txreap();
+	h = &hops[p->p_ttl];
+	hop_result(h, tstamp_msec(&tsrecv, &p->p_sent));
+	if (sock_cmp_addr((SA *) &h->hp_addr, pr->sarecv, pr->salen) != 0) {
+		memcpy(&h->hp_addr, pr->sarecv, pr->salen);
+		resolve_name(pr->sarecv, pr->salen, name, sizeof(name));
+			/* starts the lookup now, so the name is ready for print_hops() */
+	}
+	if (code == -1 && p->p_ttl < lasthop)
+		lasthop = p->p_ttl;		/* no point probing past the destination */
+	else if (code >= 0 && verbose)
+		printf(" (hop %d: ICMP %s)\n", p->p_ttl, (*pr->icmpcode)(code));
+	p->p_ttl = 0;
+}
+
+/*
+ * Count every probe sent more than PROBE_TIMEO seconds ago as lost.
+ * Return the number still outstanding.
+ */
+static int
+expire_probes(void)
+{
+	int				seq, nout;
+	struct timespec	now;
+
+	tstamp_now(&now);
+	nout = 0;
+	for (seq = 1; seq <= NPROBESEQ; seq++) {
+		if (probes[seq].p_ttl == 0)
+			continue;
+		if (tstamp_msec(&now, &probes[seq].p_sent) >= PROBE_TIMEO * 1000.0) {
+			hop_result(&hops[probes[seq].p_ttl], -1);
+			probes[seq].p_ttl = 0;
+		} else
+			nout++;
+	}
+	return(nout);
+}
+
+static void
+print_hops(void)
+{
+	int			ttl, i, nrecv;
+	double		sum;
+	struct hop	*h;
+	char		name[NI_MAXHOST], str[NI_MAXHOST + INET6_ADDRSTRLEN + 3];
+
+	if (isatty(STDOUT_FILENO))
+		printf("\033[H\033[J");		/* redraw from the top of the screen */
+	printf("%-44s %6s %5s %8s %8s %8s %8s\n",
+		   "", "Loss%", "Snt", "Last", "Avg", "Best", "Worst");
+
+	for (ttl = 1; ttl <= lasthop; ttl++) {
+		h = &hops[ttl];
+		if (h->hp_addr.ss_family == 0)
+			snprintf(str, sizeof(str), "???");
+		else if (resolve_name((SA *) &h->hp_addr, pr->salen,
+							  name, sizeof(name)))
+			snprintf(str, sizeof(str), "%s (%s)", name,
+					 Sock_ntop_host((SA *) &h->hp_addr, pr->salen));
+		else
+			snprintf(str, sizeof(str), "%s",
+					 Sock_ntop_host((SA *) &h->hp_addr, pr->salen));
+
+		nrecv = 0;
+		sum = 0.0;
+		for (i = 0; i < h->hp_nwin; i++) {
+			if (h->hp_win[i] >= 0) {
+				nrecv++;
+				sum += h->hp_win[i];
+			}
+		}
+		printf("%2d  %-40.40s %5.1f%% %5d", ttl, str,
+			   h->hp_nwin ? 100.0 * (h->hp_nwin - nrecv) / h->hp_nwin : 0.0,
+			   h->hp_sent);
+		if (h->hp_recv > 0)
+			printf(" %8.3f %8.3f %8.3f %8.3f\n", h->hp_last,
+				   nrecv ? sum / nrecv : 0.0, h->hp_best, h->hp_worst);
+		else
+			printf(" %8s %8s %8s %8s\n", "*", "*", "*", "*");
+	}
+	fflush(stdout);
+}
+
+void
+mtrloop(void)
+{
+	int				ttl, nround, nout, msec;
+	struct pollfd	fds[1];
+	struct timespec	start, now;
+
+	opensockets();
+	resolve_init();
+	Signal(SIGINT, sig_int);
+
+	hops = Calloc(max_ttl + 1, sizeof(struct hop));
+	lasthop = max_ttl;
+	fds[0].fd = recvfd;
+	fds[0].events = POLLIN;
+
+	for (nround = 0; gotintr == 0 && (ncycles == 0 || nround < ncycles); ) {
+		tstamp_now(&start);
+		for (ttl = 1; ttl <= lasthop; ttl++)
+			send_probe(ttl);
+		nround++;
+
+			/* wait for replies until the next round, or after the last
+			   round until everything is answered or timed out */
+		for ( ; gotintr == 0; ) {
+			nout = expire_probes();
+			tstamp_now(&now);
+			if (ncycles == 0 || nround < ncycles)
+				msec = interval * 1000 - (int) tstamp_msec(&now, &start);
+			else
+				msec = (nout > 0) ? 100 : 0;	/* recheck expiry often */
+			if (msec <= 0)
+				break;
+			if (poll(fds, 1, msec) < 0) {
+				if (errno == EINTR)
+					continue;
+				err_sys("poll error");
+			}
+			if (fds[0].revents & POLLIN)
+				read_reply();
+		}
+		if (isatty(STDOUT_FILENO))
+			print_hops();
+	}
+	if (isatty(STDOUT_FILENO) == 0)
+		print_hops();			/* just the final report */
+}
@@ -10,28 +10,38 @@ extern int gotalarm;
  */
 
 int
-recv_v6(int seq, struct timeval *tv)
+recv_v6(int seq, struct timespec *ts)
 {
 #ifdef	IPV6
 	int					hlen2, icmp6len, ret;
 	ssize_t				n;
-	socklen_t			len;
 	struct ip6_hdr		*hip6;
 	struct icmp6_hdr	*icmp6;
 	struct udphdr		*udp;
+	struct msghdr		msg;
+	struct iovec		iov;
+	char				controlbuf[BUFSIZE];
 
 	gotalarm = 0;
 	alarm(3);
 	for ( ; ; ) {
 		if (gotalarm)
 			return(-3);		/* alarm expired */
-		len = pr->salen;
-		n = recvfrom(recvfd, recvbuf, sizeof(recvbuf), 0, pr->sarecv, &len);
+		iov.iov_base = recvbuf;
+		iov.iov_len = sizeof(recvbuf);
+		bzero(&msg, sizeof(msg));
+		msg.msg_name = pr->sarecv;
+		msg.msg_namelen = pr->salen;
+		msg.msg_iov = &iov;
+		msg.msg_iovlen = 1;
+		msg.msg_control = controlbuf;
+		msg.msg_controllen = sizeof(controlbuf);
+		n = recvmsg(recvfd, &msg, 0);
 		if (n < 0) {
 			if (errno == EINTR)
 				continue;
 			else
-				err_sys("recvfrom error");
+				err_sys("recvmsg error");
 		}
 
 		icmp6 = (struct icmp6_hdr *) recvbuf; /* ICMP header */
@@ -73,10 +83,11 @@ recv_v6(int seq, struct timeval *tv)
 					Sock_ntop_host(pr->sarecv, pr->salen),
 					icmp6->icmp6_type, icmp6->icmp6_code);
 		}
-		/* Some other ICMP error, recvfrom() again */
+		/* Some other ICMP error, recvmsg() again */
 	}
 	alarm(0);					/* don't leave alarm running */
-	Gettimeofday(tv, NULL);		/* get time of packet arrival */
+	if (tstamp_recv(&msg, ts) == 0)
+		tstamp_now(ts);			/* get time of packet arrival */
 	return(ret);
 #endif
 }
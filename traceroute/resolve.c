@@ -0,0 +1,129 @@
+#include	"trace.h"
+#include	"unpthread.h"
+
+/*
+ * Reverse lookups for mtrloop(), done by one thread and cached, so that
+ * a slow or missing PTR record never holds up the probes.  The caller
+ * gets the numeric address until the name is known.
+ */
+
+#define	NCACHE		1024	/* power of 2; far more routers than any path */
+
+#define	RS_EMPTY	0
+#define	RS_PENDING	1		/* queued for the resolver thread */
+#define	RS_DONE		2
+
+static struct rcache {
+  int						rc_state;	/* RS_xxx */
+  socklen_t					rc_salen;
+  struct sockaddr_storage	rc_addr;
+  char						rc_name[NI_MAXHOST];	/* "" if none */
+} rcache[NCACHE];
+
+static int				rqueue[NCACHE];	/* indexes of RS_PENDING entries */
+static int				rqhead, rqtail;
+static pthread_mutex_t	rlock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t	rcond = PTHREAD_COND_INITIALIZER;
+
+static void	*resolver(void *);
+
+void
+resolve_init(void)
+{
+	pthread_t	tid;
+
+	Pthread_create(&tid, NULL, resolver, NULL);
+	Pthread_detach(tid);
+}
+
+static u_int
+addr_hash(const SA *sa)
+{
+	const u_char	*p;
+	u_int			i, len, h;
+
+	if (sa->sa_family == AF_INET) {
+		p = (const u_char *) &((const struct sockaddr_in *) sa)->sin_addr;
+		len = sizeof(struct in_addr);
+#ifdef	IPV6
+	} else if (sa->sa_family == AF_INET6) {
+		p = (const u_char *) &((const struct sockaddr_in6 *) sa)->sin6_addr;
+		len = sizeof(struct in6_addr);
+#endif
+	} else
+		return(0);
+
+	h = 2166136261U;		/* FNV-1a */
+	for (i = 0; i < len; i++)
+		h = (h ^ p[i]) * 16777619U;
+	return(h);
+}
+
+/*
+ * Copy the name of "sa" into "name" and return 1 if we know it.
+ * Otherwise queue a lookup (if one is not already queued) and return 0.
+ */
+int
+resolve_name(const SA *sa, socklen_t salen, char *name, size_t namelen)
+{
+	int				i, n, found;
+	struct rcache	*rc;
+
+	found = 0;
+	Pthread_mutex_lock(&rlock);
+	for (n = 0, i = addr_hash(sa) & (NCACHE - 1); n < NCACHE;
+		 n++, i = (i + 1) & (NCACHE - 1)) {
+		rc = &rcache[i];
+		if (rc->rc_state == RS_EMPTY) {
+			if (((rqtail + 1) & (NCACHE - 1)) == rqhead)
+				break;					/* queue full; ask again later */
+			rc->rc_state = RS_PENDING;	/* first time we've seen it */
+			rc->rc_salen = salen;
+			memcpy(&rc->rc_addr, sa, salen);
+			rqueue[rqtail] = i;
+			rqtail = (rqtail + 1) & (NCACHE - 1);
+			Pthread_cond_signal(&rcond);
+			break;
+		}
+		if (sock_cmp_addr((SA *) &rc->rc_addr, sa, salen) == 0) {
+			if (rc->rc_state == RS_DONE && rc->rc_name[0] != 0) {
+				snprintf(name, namelen, "%s", rc->rc_name);
+				found = 1;
+			}
+			break;
+		}
+	}
+	Pthread_mutex_unlock(&rlock);
+	return(found);
+}
+
+static void *
+resolver(void *arg)
+{
+	int						i;
+	socklen_t				salen;
+	struct sockaddr_storage	ss;
+	char					name[NI_MAXHOST];
+
+	for ( ; ; ) {
+		Pthread_mutex_lock(&rlock);
+		while (rqhead == rqtail)
+			Pthread_cond_wait(&rcond, &rlock);
+		i = rqueue[rqhead];
+		rqhead = (rqhead + 1) & (NCACHE - 1);
+		salen = rcache[i].rc_salen;
+		memcpy(&ss, &rcache[i].rc_addr, salen);
+		Pthread_mutex_unlock(&rlock);
+
+			/* blocks for as long as the DNS takes; only this thread waits */
+		if (getnameinfo((SA *) &ss, salen, name, sizeof(name),
+						NULL, 0, NI_NAMEREQD) != 0)
+			name[0] = 0;			/* no name; keep showing the address */
+
+		Pthread_mutex_lock(&rlock);
+		strcpy(rcache[i].rc_name, name);
+		rcache[i].rc_state = RS_DONE;
+		Pthread_mutex_unlock(&rlock);
+	}
+	return(NULL);
+}
@@ -5,6 +5,7 @@
 #include	<netinet/udp.h>
 
 #define	BUFSIZE		1500
+#define	NPROBESEQ	4096	/* mtrloop() cycles seq through 1..NPROBESEQ */
 
 struct rec {					/* format of outgoing UDP data */
   u_short	rec_seq;			/* sequence number */
@@ -24,20 +25,31 @@ pid_t	 pid;				/* our PID */
 int		 probe, nprobes;
 int		 sendfd, recvfd;	/* send on UDP sock, read on raw ICMP sock */
 int		 ttl, max_ttl;
+int		 continuous;		/* -C: probe all TTLs at once, repeatedly */
+int		 ncycles;			/* -c: # of rounds for -C, 0 = until SIGINT */
+int		 interval;			/* -i: seconds between rounds for -C */
+int		 tsflags;			/* TSTAMP_TX if enabled on sendfd */
 int		 verbose;
 
 			/* function prototypes */
 const char	*icmpcode_v4(int);
 const char	*icmpcode_v6(int);
-int		 recv_v4(int, struct timeval *);
-int		 recv_v6(int, struct timeval *);
+int		 match_v4(char *, ssize_t, int *);
+int		 match_v6(char *, ssize_t, int *);
+void	 mtrloop(void);
+void	 opensockets(void);
+int		 recv_v4(int, struct timespec *);
+int		 recv_v6(int, struct timespec *);
+void	 resolve_init(void);
+int		 resolve_name(const SA *, socklen_t, char *, size_t);
 void	 sig_alrm(int);
 void	 traceloop(void);
 void	 tv_sub(struct timeval *, struct timeval *);
 
 struct proto {
   const char	*(*icmpcode)(int);
-  int	 (*recv)(int, struct timeval *);
+  int	 (*recv)(int, struct timespec *);
+  int	 (*match)(char *, ssize_t, int *);
   struct sockaddr  *sasend;	/* sockaddr{} for send, from getaddrinfo */
   struct sockaddr  *sarecv;	/* sockaddr{} for receiving */
   struct sockaddr  *salast;	/* last sockaddr{} for receiving */
@@ -1,15 +1,15 @@
 #include	"trace.h"
 
+/*
+ * Create the raw socket for the ICMP replies and the UDP socket for the
+ * probes, common to traceloop() and mtrloop().
+ */
 void
-traceloop(void)
+opensockets(void)
 {
-	int					seq, code, done;
-	double				rtt;
-	struct rec			*rec;
-	struct timeval		tvrecv;
-
 	recvfd = Socket(pr->sasend->sa_family, SOCK_RAW, pr->icmpproto);
 	setuid(getuid());		/* don't need special permissions anymore */
+	tstamp_enable(recvfd, TSTAMP_RX);	/* else recv_xx() stamps arrivals */
 
 #ifdef	IPV6
 	if (pr->sasend->sa_family == AF_INET6 && verbose == 0) {
@@ -28,6 +28,19 @@ traceloop(void)
 	sport = (getpid() & 0xffff) | 0x8000;	/* our source UDP port # */
 	sock_set_port(pr->sabind, pr->salen, htons(sport));
 	Bind(sendfd, pr->sabind, pr->salen);
+	tsflags = tstamp_enable(sendfd, TSTAMP_TX);
+}
+
+void
+traceloop(void)
+{
+	int					seq, code, done;
+	uint32_t			id;
+	double				rtt;
+	struct rec			*rec;
+	struct timespec		tsrecv, tssend, ts;
+
+	opensockets();
 
 	sig_alrm(SIGALRM);
 
@@ -49,7 +62,7 @@ traceloop(void)
 			sock_set_port(pr->sasend, pr->salen, htons(dport + seq));
 			Sendto(sendfd, sendbuf, datalen, 0, pr->sasend, pr->salen);
 
-			if ( (code = (*pr->recv)(seq, &tvrecv)) == -3)
+			if ( (code = (*pr->recv)(seq, &tsrecv)) == -3)
 				printf(" *");		/* timeout, no reply */
 			else {
 				char	str[NI_MAXHOST];
@@ -64,8 +77,15 @@ traceloop(void)
 								Sock_ntop_host(pr->sarecv, pr->salen));
 					memcpy(pr->salast, pr->sarecv, pr->salen);
 				}
-				tv_sub(&tvrecv, &rec->rec_tv);
-				rtt = tvrecv.tv_sec * 1000.0 + tvrecv.tv_usec / 1000.0;
+				tssend.tv_sec = rec->rec_tv.tv_sec;
+				tssend.tv_nsec = rec->rec_tv.tv_usec * 1000;
+				if (tsflags & TSTAMP_TX) {
+						/* kernel numbers our sends 0, 1, ...; seq from 1 */
+					while (Tstamp_txreap(sendfd, &id, &ts) > 0)
+						if (id == seq - 1)
+							tssend = ts;
+				}
+				rtt = tstamp_msec(&tsrecv, &tssend);
 				printf("  %.3f ms", rtt);
 
 				if (code == -1)		/* port unreachable; at destination */
@@ -5,10 +5,15 @@ void
 cleanup(int signo)
 {
 	struct pcap_stat	stat;
+	unsigned int		nrecv, ndrop;
 
 	putc('\n', stdout);
 
-	if (verbose) {
+	if (verbose && ringfd >= 0) {
+		ring_stats(&nrecv, &ndrop);
+		printf("%u packets received by filter\n", nrecv);
+		printf("%u packets dropped by kernel\n", ndrop);
+	} else if (verbose) {
 		if (pcap_stats(pd, &stat) < 0)
 			err_quit("pcap_stats: %s\n", pcap_geterr(pd));
 		printf("%d packets received by filter\n", stat.ps_recv);
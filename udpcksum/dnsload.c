@@ -0,0 +1,344 @@
+/*
+ * A DNS query generator.  Every name in the list is built once into a
+ * complete IP datagram by dns_template(); each query sent is a copy of
+ * one with its own ID, patched in with an incremental checksum update
+ * by dns_setid(), so nothing is summed or formatted per query.  The
+ * copies go out up to "batch" at a time with sendmmsg() on a raw socket
+ * at the target rate, and the responses, read up to "batch" at a time
+ * with recvmmsg(), are matched to their queries by ID for the latency.
+ *
+ * A query that is unanswered after "timeo" seconds, or whose ID comes
+ * around again first, is lost.  At 65536 IDs per source port, the rate
+ * times the latency has to stay well below that.
+ *
+ * Without superuser privileges (or with -u) the queries are written to
+ * the UDP socket instead of the raw one, and the kernel builds the
+ * headers; the templates are still used for the DNS part.
+ *
+ * Against dnsstub on the same host:
+ *		dnsstub 9953 &
+ *		dnsload -r 100000 127.0.0.1 9953
+ */
+
+#include	"dnsquery.h"
+
+#define	MAXBATCH	256
+
+static double		 sent[65536];	/* by ID, 0 if not outstanding */
+static char			**names;
+static struct dnstmpl *tmpl;
+static int			 nnames;
+static uint32_t		*lat;			/* latency of every answer, usec */
+static long			 nlat, maxlat;
+
+static double
+now(void)
+{
+	struct timespec	ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return(ts.tv_sec + ts.tv_nsec / 1e9);
+}
+
+static void
+read_names(const char *file)
+{
+	int		n, maxnames;
+	char	line[MAXLINE], *ptr;
+	FILE	*fp;
+	static char	*deflt[] = {
+		"a.root-servers.net", "b.root-servers.net", "c.root-servers.net",
+		"d.root-servers.net", "e.root-servers.net", "f.root-servers.net",
+		"g.root-servers.net", "h.root-servers.net", "i.root-servers.net",
+		"j.root-servers.net", "k.root-servers.net", "l.root-servers.net",
+		"m.root-servers.net"
+	};
+
+	if (file == NULL) {
+		names = deflt;
+		nnames = sizeof(deflt) / sizeof(deflt[0]);
+		return;
+	}
+
+	fp = Fopen(file, "r");
+	maxnames = 0;
+	while (Fgets(line, sizeof(line), fp) != NULL) {
+		ptr = line + strspn(line, " \t");
+		if ( (n = strcspn(ptr, " \t\r\n#")) == 0)
+			continue;			/* blank line or comment */
+		ptr[n] = 0;
+		if (nnames == maxnames) {
+			maxnames = (maxnames == 0) ? 1024 : 2 * maxnames;
+			if ( (names = realloc(names, maxnames * sizeof(char *))) == NULL)
+				err_sys("realloc error");
+		}
+		names[nnames++] = strdup(ptr);
+	}
+	Fclose(fp);
+	if (nnames == 0)
+		err_quit("no names in %s", file);
+}
+
+static void
+add_latency(double sec)
+{
+	if (nlat == maxlat) {
+		maxlat = (maxlat == 0) ? 65536 : 2 * maxlat;
+		if ( (lat = realloc(lat, maxlat * sizeof(uint32_t))) == NULL)
+			err_sys("realloc error");
+	}
+	lat[nlat++] = sec * 1e6;
+}
+
+static int
+cmp_lat(const void *a, const void *b)
+{
+	uint32_t	la = *(const uint32_t *) a, lb = *(const uint32_t *) b;
+
+	return(la < lb ? -1 : la > lb);
+}
+
+int
+main(int argc, char **argv)
+{
+	int					c, i, n, udpfd, rawfd, sendfd, batch, nsec, type;
+	int					useudp, name, hdr;
+	long				nsent, nrecv, nlost, nunexp, due, nout;
+	uint16_t			id, nextid;
+	double				rate, timeo, start, t, end, wait, swept, sum;
+	char				*port, *file;
+	char				qbuf[MAXBATCH][DNS_MAXPKT], rbuf[MAXBATCH][512];
+	const int			on = 1;
+	socklen_t			len;
+	struct sockaddr_in	src, dst;
+	struct addrinfo		*ai;
+	struct iovec		qiov[MAXBATCH], riov[MAXBATCH];
+	struct mmsghdr		qmsg[MAXBATCH], rmsg[MAXBATCH];
+	struct pollfd		pfd;
+
+	rate = 10000;
+	nsec = 10;
+	batch = 32;
+	timeo = 1;
+	type = DNS_TYPE_A;
+	useudp = 0;
+	file = NULL;
+	opterr = 0;		/* don't want getopt() writing to stderr */
+	while ( (c = getopt(argc, argv, "b:d:f:q:r:uw:")) != -1) {
+		switch (c) {
+		case 'b':
+			batch = atoi(optarg);
+			break;
+
+		case 'd':
+			nsec = atoi(optarg);
+			break;
+
+		case 'f':
+			file = optarg;
+			break;
+
+		case 'q':
+			if (strcasecmp(optarg, "A") == 0)
+				type = DNS_TYPE_A;
+			else if (strcasecmp(optarg, "AAAA") == 0)
+				type = DNS_TYPE_AAAA;
+			else if ( (type = atoi(optarg)) <= 0 || type > 65535)
+				err_quit("unknown query type %s", optarg);
+			break;
+
+		case 'r':
+			rate = atof(optarg);
+			break;
+
+		case 'u':
+			useudp = 1;
+			break;
+
+		case 'w':
+			timeo = atof(optarg);
+			break;
+
+		case '?':
+			err_quit("usage: dnsload [ -r queries/sec (0 = no limit) ] "
+					 "[ -d #seconds ] [ -b batch ]\n"
+					 "               [ -f namefile ] [ -q type ] "
+					 "[ -w timeout ] [ -u ] <host> [ port ]");
+		}
+	}
+	if (optind != argc - 1 && optind != argc - 2)
+		err_quit("usage: dnsload [ options ] <host> [ port ]");
+	port = (optind == argc - 2) ? argv[optind + 1] : "53";
+	if (batch < 1 || batch > MAXBATCH)
+		err_quit("batch must be between 1 and %d", MAXBATCH);
+
+	ai = Host_serv(argv[optind], port, AF_INET, SOCK_DGRAM);
+	memcpy(&dst, ai->ai_addr, sizeof(dst));
+	freeaddrinfo(ai);
+
+		/* 4responses come back to this socket; the kernel picks our address */
+	udpfd = Socket(AF_INET, SOCK_DGRAM, 0);
+	Connect(udpfd, (SA *) &dst, sizeof(dst));
+	len = sizeof(src);
+	Getsockname(udpfd, (SA *) &src, &len);
+	n = 4 * 1024 * 1024;
+	setsockopt(udpfd, SOL_SOCKET, SO_RCVBUF, &n, sizeof(n));
+
+	rawfd = -1;
+	if (!useudp) {
+		if ( (rawfd = socket(AF_INET, SOCK_RAW, IPPROTO_RAW)) < 0) {
+			err_ret("can't open raw socket; writing to the UDP socket");
+			useudp = 1;
+		} else
+			Setsockopt(rawfd, IPPROTO_IP, IP_HDRINCL, &on, sizeof(on));
+	}
+	setuid(getuid());	/* don't need superuser privileges anymore */
+	sendfd = useudp ? udpfd : rawfd;
+	hdr = useudp ? DNS_HDRLEN : 0;	/* where the datagram we write starts */
+
+	read_names(file);
+	tmpl = Malloc(nnames * sizeof(struct dnstmpl));
+	for (i = 0; i < nnames; i++)
+		if (dns_template(&tmpl[i], names[i], type, &src, &dst) < 0)
+			err_quit("invalid name: %s", names[i]);
+
+	for (i = 0; i < MAXBATCH; i++) {
+		bzero(&qmsg[i], sizeof(qmsg[i]));
+		qiov[i].iov_base = qbuf[i] + hdr;
+		qmsg[i].msg_hdr.msg_iov = &qiov[i];
+		qmsg[i].msg_hdr.msg_iovlen = 1;
+		if (!useudp) {
+			qmsg[i].msg_hdr.msg_name = &dst;
+			qmsg[i].msg_hdr.msg_namelen = sizeof(dst);
+		}
+
+		bzero(&rmsg[i], sizeof(rmsg[i]));
+		riov[i].iov_base = rbuf[i];
+		riov[i].iov_len = sizeof(rbuf[i]);
+		rmsg[i].msg_hdr.msg_iov = &riov[i];
+		rmsg[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	printf("%d names, %s queries from %s", nnames,
+		   useudp ? "UDP socket" : "raw socket",
+		   Sock_ntop((SA *) &src, sizeof(src)));
+	printf(" to %s, rate %.0f/s\n", Sock_ntop((SA *) &dst, sizeof(dst)),
+		   rate);
+
+	nsent = nrecv = nlost = nunexp = nout = 0;
+	nextid = 0;
+	name = 0;
+	pfd.fd = udpfd;
+	pfd.events = POLLIN;
+	start = swept = now();
+	end = start + nsec;
+
+	for ( ; ; ) {
+		t = now();
+		if (t >= end + timeo || (t >= end && nout == 0))
+			break;
+
+			/* 4queries due by now, at most one batch */
+		due = 0;
+		if (t < end) {
+			due = (rate > 0) ? (long) ((t - start) * rate) - nsent : batch;
+			if (due > batch)
+				due = batch;
+		}
+		for (i = 0; i < due; i++) {
+			id = nextid++;
+			if (sent[id] != 0) {
+				nlost++;		/* ID came around before the answer */
+				nout--;
+			}
+			memcpy(qbuf[i], tmpl[name].t_pkt, tmpl[name].t_len);
+			dns_setid(qbuf[i], id);
+			qiov[i].iov_len = tmpl[name].t_len - hdr;
+			sent[id] = t;
+			if (++name == nnames)
+				name = 0;
+		}
+		for (i = 0; i < due; i += n) {
+			if ( (n = sendmmsg(sendfd, qmsg + i, due - i, 0)) < 0) {
+				if (errno == EINTR) {
+					n = 0;
+					continue;
+				}
+				if (errno == ECONNREFUSED) {	/* ICMP from earlier */
+					n = 0;
+					continue;
+				}
+				err_sys("sendmmsg error");
+			}
+		}
+		nsent += due;
+		nout += due;
+
+			/* 4wait for responses until the next query is due */
+		if (t >= end)
+			wait = 0.010;
+		else if (rate > 0)		/* until a whole batch is due */
+			wait = (nsent + batch) / rate - (t - start);
+		else
+			wait = 0;
+		if (poll(&pfd, 1, wait > 0 ? (int) (wait * 1000) : 0) <= 0)
+			continue;
+
+		for ( ; ; ) {
+			if ( (n = recvmmsg(udpfd, rmsg, batch, MSG_DONTWAIT, NULL)) < 0) {
+				if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+					break;
+				if (errno == ECONNREFUSED)
+					continue;			/* nobody there yet */
+				err_sys("recvmmsg error");
+			}
+			t = now();
+			for (i = 0; i < n; i++) {
+				if (rmsg[i].msg_len < 12 || (rbuf[i][2] & 0x80) == 0) {
+					nunexp++;			/* not a response */
+					continue;
+				}
+				id = ((unsigned char) rbuf[i][0] << 8) |
+					 (unsigned char) rbuf[i][1];
+				if (sent[id] == 0) {
+					nunexp++;			/* late or duplicate */
+					continue;
+				}
+				add_latency(t - sent[id]);
+				sent[id] = 0;
+				nrecv++;
+				nout--;
+			}
+			if (n < batch)
+				break;
+		}
+
+			/* 4every 100 ms: anything outstanding longer than timeo is lost */
+		if (t - swept >= 0.1) {
+			for (i = 0; i < 65536 && nout > 0; i++) {
+				if (sent[i] != 0 && t - sent[i] > timeo) {
+					sent[i] = 0;
+					nlost++;
+					nout--;
+				}
+			}
+			swept = t;
+		}
+	}
+	nlost += nout;				/* never answered */
+
+	printf("%ld queries sent in %d sec = %.0f/s\n", nsent, nsec,
+		   (double) nsent / nsec);
+	printf("%ld answered (%.2f%%), %ld lost, %ld unexpected responses\n",
+		   nrecv, nsent ? 100.0 * nrecv / nsent : 0.0, nlost, nunexp);
+	if (nlat > 0) {
+		qsort(lat, nlat, sizeof(uint32_t), cmp_lat);
+		for (sum = 0, i = 0; i < nlat; i++)
+			sum += lat[i];
+		printf("latency usec: min %u, avg %.0f, p50 %u, p90 %u, p99 %u, "
+			   "p99.9 %u, max %u\n", lat[0], sum / nlat, lat[nlat / 2],
+			   lat[(long) (nlat * 0.9)], lat[(long) (nlat * 0.99)],
+			   lat[(long) (nlat * 0.999)], lat[nlat - 1]);
+	}
+	exit(0);
+}
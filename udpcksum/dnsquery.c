@@ -0,0 +1,162 @@
+#include	"dnsquery.h"
+#include	<netinet/in_systm.h>
+#include	<netinet/ip.h>
+
+/*
+ * Build a query for "name" of type "type" with identification "id" at
+ * "ptr", which must have room for DNS_MAXQUERY bytes, and return its
+ * length, or -1 if "name" is not a valid domain name.
+ */
+
+/* include dns_query */
+int
+dns_query(char *ptr, const char *name, int type, uint16_t id)
+{
+	char		*start, *label;
+	const char	*dot;
+	size_t		len;
+	uint16_t	val;
+
+	start = ptr;
+	val = htons(id);					/* identification */
+	memcpy(ptr, &val, 2);
+	val = htons(0x0100);				/* flags: recursion desired */
+	memcpy(ptr + 2, &val, 2);
+	val = htons(1);						/* # questions */
+	memcpy(ptr + 4, &val, 2);
+	memset(ptr + 6, 0, 6);				/* # answer, authority, additional */
+	ptr += 12;
+
+		/* 4each label is a length byte then the label; a 0 ends the name */
+	for (label = ptr; *name != 0; name = dot + 1) {
+		if ( (dot = strchr(name, '.')) == NULL)
+			dot = name + strlen(name);		/* last label */
+		len = dot - name;
+		if (len == 0 || len > 63 || (ptr - label) + len + 2 > 255)
+			return(-1);
+		*ptr++ = len;
+		memcpy(ptr, name, len);
+		ptr += len;
+		if (*dot == 0)
+			break;
+	}
+	*ptr++ = 0;
+
+	val = htons(type);					/* query type */
+	memcpy(ptr, &val, 2);
+	val = htons(1);						/* query class = 1 (IP addr) */
+	memcpy(ptr + 2, &val, 2);
+	ptr += 4;
+	return(ptr - start);
+}
+/* end dns_query */
+
+/*
+ * Build the complete IP datagram for a query from "src" to "dst", with
+ * identification 0 and a correct UDP checksum, ready to write to a raw
+ * socket with IP_HDRINCL (the kernel fills in the IP checksum and ID).
+ * dns_setid() then gives each copy its own ID without summing the whole
+ * datagram again.
+ */
+
+/* include dns_template */
+int
+dns_template(struct dnstmpl *t, const char *name, int type,
+			 const struct sockaddr_in *src, const struct sockaddr_in *dst)
+{
+	int			n, udplen;
+	uint16_t	val, sum;
+	char		pseudo[12 + 8 + DNS_MAXQUERY];
+	struct ip	*ip;
+
+	bzero(t->t_pkt, DNS_HDRLEN);
+	if ( (n = dns_query(t->t_pkt + DNS_HDRLEN, name, type, 0)) < 0)
+		return(-1);
+	udplen = 8 + n;
+	t->t_len = DNS_HDRLEN + n;
+
+	ip = (struct ip *) t->t_pkt;
+	ip->ip_v = IPVERSION;
+	ip->ip_hl = sizeof(struct ip) >> 2;
+#if defined(linux) || defined(__OpenBSD__)
+	ip->ip_len = htons(t->t_len);	/* network byte order */
+#else
+	ip->ip_len = t->t_len;			/* host byte order */
+#endif
+	ip->ip_ttl = 64;
+	ip->ip_p = IPPROTO_UDP;
+	ip->ip_src = src->sin_addr;
+	ip->ip_dst = dst->sin_addr;
+
+	memcpy(t->t_pkt + 20, &src->sin_port, 2);
+	memcpy(t->t_pkt + 22, &dst->sin_port, 2);
+	val = htons(udplen);
+	memcpy(t->t_pkt + 24, &val, 2);
+
+		/* 4UDP checksum covers a pseudoheader, the UDP header and the data */
+	memcpy(pseudo, &src->sin_addr, 4);
+	memcpy(pseudo + 4, &dst->sin_addr, 4);
+	pseudo[8] = 0;
+	pseudo[9] = IPPROTO_UDP;
+	memcpy(pseudo + 10, &val, 2);
+	memcpy(pseudo + 12, t->t_pkt + 20, udplen);
+	if ( (sum = in_cksum((uint16_t *) pseudo, 12 + udplen)) == 0)
+		sum = 0xffff;
+	memcpy(t->t_pkt + 26, &sum, 2);
+	return(0);
+}
+/* end dns_template */
+
+/*
+ * Change the identification of a query datagram built by dns_template()
+ * and update its UDP checksum for the change alone, as in RFC 1624:
+ * HC' = ~(~HC + ~m + m'), where m is the old ID and m' the new one.
+ */
+
+/* include dns_setid */
+void
+dns_setid(char *pkt, uint16_t id)
+{
+	uint16_t	old, new, sum;
+	uint32_t	acc;
+
+	memcpy(&old, pkt + DNS_HDRLEN, 2);
+	memcpy(&sum, pkt + 26, 2);
+	new = htons(id);
+	acc = (uint16_t) ~sum + (uint16_t) ~old + new;
+	acc = (acc & 0xffff) + (acc >> 16);
+	acc = (acc & 0xffff) + (acc >> 16);
+	sum = ~acc;
+	if (sum == 0)
+		sum = 0xffff;			/* 0 means no checksum */
+	memcpy(pkt + DNS_HDRLEN, &new, 2);
+	memcpy(pkt + 26, &sum, 2);
+}
+/* end dns_setid */
+
+#ifndef	MSG_WAITFORONE
+int
+recvmmsg(int fd, struct mmsghdr *msgs, unsigned int n, int flags, void *timeo)
+{
+	ssize_t		len;
+
+	if ( (len = recvmsg(fd, &msgs[0].msg_hdr, flags)) < 0)
+		return(-1);
+	msgs[0].msg_len = len;
+	return(1);
+}
+
+int
+sendmmsg(int fd, struct mmsghdr *msgs, unsigned int n, int flags)
+{
+	unsigned int	i;
+	ssize_t			len;
+
+	for (i = 0; i < n; i++) {
+		if ( (len = sendmsg(fd, &msgs[i].msg_hdr, flags)) < 0)
+			return(i > 0 ? i : -1);
+		msgs[i].msg_len = len;
+	}
+	return(n);
+}
+#endif
@@ -0,0 +1,38 @@
+/*
+ * DNS query templates for senddnsquery-raw.c and the dnsload generator.
+ * Needs only "unp.h", so dnsload and dnsstub build without libpcap.
+ * Include this before anything else that includes "unp.h".
+ */
+
+#ifndef	_GNU_SOURCE
+#define	_GNU_SOURCE			/* recvmmsg(), sendmmsg() */
+#endif
+#include	"unp.h"
+
+#define	DNS_HDRLEN		28		/* IP and UDP headers before the query */
+#define	DNS_MAXQUERY	(12 + 255 + 4)	/* header, name, type and class */
+#define	DNS_MAXPKT		(DNS_HDRLEN + DNS_MAXQUERY)
+
+#define	DNS_TYPE_A		1
+#define	DNS_TYPE_AAAA	28
+
+struct dnstmpl {				/* one prebuilt query per name */
+  char		t_pkt[DNS_MAXPKT];	/* IP and UDP headers, then the query */
+  int		t_len;				/* bytes in t_pkt */
+};
+
+int		 dns_query(char *, const char *, int, uint16_t);
+int		 dns_template(struct dnstmpl *, const char *, int,
+					  const struct sockaddr_in *, const struct sockaddr_in *);
+void	 dns_setid(char *, uint16_t);
+
+#ifndef	MSG_WAITFORONE		/* no recvmmsg() or sendmmsg(): one at a time */
+struct mmsghdr {
+  struct msghdr	msg_hdr;
+  unsigned int	msg_len;
+};
+
+int		 recvmmsg(int, struct mmsghdr *, unsigned int, int, void *);
+int		 sendmmsg(int, struct mmsghdr *, unsigned int, int);
+#define	MSG_WAITFORONE	0
+#endif
@@ -0,0 +1,139 @@
+/*
+ * A stub DNS responder for dnsload, so the whole loop can be measured on
+ * one host without a real server.  Every query is answered in place:
+ * the header becomes a response, anything after the question is
+ * dropped, and an A query for class IN gets one answer, 127.0.0.1 with
+ * a TTL of 60.  Other queries get an empty NOERROR response.  Queries
+ * are read and answered up to BATCH at a time with recvmmsg() and
+ * sendmmsg().
+ *
+ * When interrupted, it prints how many queries it answered.
+ */
+
+#include	"dnsquery.h"
+
+#define	BATCH	64
+#define	BUFLEN	512				/* classic DNS limit over UDP */
+
+static long		nanswered, nbad;
+
+static void
+sig_int(int signo)
+{
+	printf("\n%ld queries answered, %ld malformed\n", nanswered, nbad);
+	exit(0);
+}
+
+/*
+ * Turn the query of "len" bytes in "buf" into the response and return
+ * its length, or -1 to ignore it.
+ */
+static int
+dns_answer(char *buf, int len)
+{
+	int				n;
+	unsigned char	*ptr, *end;
+	uint16_t		type, class;
+	static const unsigned char	rr[] = {
+		0xc0, 12,				/* name: pointer to the question's */
+		0, DNS_TYPE_A, 0, 1,	/* type A, class IN */
+		0, 0, 0, 60,			/* TTL */
+		0, 4, 127, 0, 0, 1		/* length, address */
+	};
+
+	ptr = (unsigned char *) buf;
+	end = ptr + len;
+	if (len < 12 || (ptr[2] & 0x80) != 0)	/* too short, or a response */
+		return(-1);
+	if (ptr[4] != 0 || ptr[5] != 1)			/* exactly one question */
+		return(-1);
+
+	for (ptr += 12; ptr < end && *ptr != 0; ptr += n + 1)
+		if ( (n = *ptr) > 63)				/* no compression in a query */
+			return(-1);
+	if (ptr + 5 > end)
+		return(-1);
+	type = (ptr[1] << 8) | ptr[2];
+	class = (ptr[3] << 8) | ptr[4];
+	ptr += 5;
+
+	buf[2] = 0x84 | (buf[2] & 0x01);	/* response, authoritative, RD */
+	buf[3] = 0x80;						/* recursion available, NOERROR */
+	memset(buf + 6, 0, 6);				/* # answer, authority, additional */
+	if (type == DNS_TYPE_A && class == 1 && ptr + sizeof(rr) <=
+		(unsigned char *) buf + BUFLEN) {
+		buf[7] = 1;
+		memcpy(ptr, rr, sizeof(rr));
+		ptr += sizeof(rr);
+	}
+	return(ptr - (unsigned char *) buf);
+}
+
+int
+main(int argc, char **argv)
+{
+	int					sockfd, i, n, nsent, len;
+	char				buf[BATCH][BUFLEN];
+	struct sockaddr_in	servaddr, from[BATCH];
+	struct iovec		iov[BATCH];
+	struct mmsghdr		msgs[BATCH];
+
+	if (argc > 2)
+		err_quit("usage: dnsstub [ port ]");
+
+	sockfd = Socket(AF_INET, SOCK_DGRAM, 0);
+	bzero(&servaddr, sizeof(servaddr));
+	servaddr.sin_family = AF_INET;
+	servaddr.sin_addr.s_addr = htonl(INADDR_ANY);
+	servaddr.sin_port = htons(argc == 2 ? atoi(argv[1]) : 53);
+	Bind(sockfd, (SA *) &servaddr, sizeof(servaddr));
+	n = 4 * 1024 * 1024;
+	setsockopt(sockfd, SOL_SOCKET, SO_RCVBUF, &n, sizeof(n));
+
+	Signal(SIGINT, sig_int);
+	Signal(SIGTERM, sig_int);
+
+	for ( ; ; ) {
+		for (i = 0; i < BATCH; i++) {
+			bzero(&msgs[i], sizeof(msgs[i]));
+			iov[i].iov_base = buf[i];
+			iov[i].iov_len = BUFLEN;
+			msgs[i].msg_hdr.msg_name = &from[i];
+			msgs[i].msg_hdr.msg_namelen = sizeof(from[i]);
+			msgs[i].msg_hdr.msg_iov = &iov[i];
+			msgs[i].msg_hdr.msg_iovlen = 1;
+		}
+
+			/* 4block for the first one, then take what else is queued */
+		if ( (n = recvmmsg(sockfd, msgs, BATCH, MSG_WAITFORONE, NULL)) < 0) {
+			if (errno == EINTR)
+				continue;
+			err_sys("recvmmsg error");
+		}
+
+		for (i = nsent = 0; i < n; i++) {
+			if ( (len = dns_answer(buf[i], msgs[i].msg_len)) < 0) {
+				nbad++;
+				continue;
+			}
+			iov[i].iov_len = len;
+			if (nsent != i) {			/* close the gap left by a bad one */
+				msgs[nsent] = msgs[i];
+				iov[nsent] = iov[i];
+				msgs[nsent].msg_hdr.msg_iov = &iov[nsent];
+			}
+			nsent++;
+		}
+		for (i = 0; i < nsent; i += n) {
+			if ( (n = sendmmsg(sockfd, msgs + i, nsent - i, 0)) < 0) {
+				if (errno == EINTR) {
+					n = 0;
+					continue;
+				}
+				err_ret("sendmmsg error");
+				n = 1;					/* skip the one that failed */
+			}
+		}
+		nanswered += nsent;
+	}
+}
@@ -10,6 +10,7 @@ int		datalink;		/* from pcap_datalink(), in <net/bpf.h> */
 char   *device;			/* pcap device */
 pcap_t *pd;				/* packet capture struct pointer */
 int		rawfd;			/* raw socket to write on */
+int		ringfd = -1;	/* -r: packet ring socket, else pcap */
 int		snaplen = 200;	/* amount of data to capture */
 int		verbose;
 int		zerosum;		/* send UDP query with no checksum */
@@ -19,20 +20,24 @@ static void	usage(const char *);
 int
 main(int argc, char *argv[])
 {
-	int				c, lopt=0;
-	char			*ptr, localname[1024], *localport;
+	int				c, lopt=0, ropt=0, nthreads=0;
+	char			*ptr, *file=NULL, localname[1024], *localport;
 	struct addrinfo	*aip;
 /* end main1 */
 
 /* include main2 */
 	opterr = 0;		/* don't want getopt() writing to stderr */
-	while ( (c = getopt(argc, argv, "0i:l:v")) != -1) {
+	while ( (c = getopt(argc, argv, "0f:i:l:rt:v")) != -1) {
 		switch (c) {
 
 		case '0':
 			zerosum = 1;
 			break;
 
+		case 'f':
+			file = optarg;				/* check a capture file */
+			break;
+
 		case 'i':
 			device = optarg;			/* pcap device */
 			break;
@@ -47,6 +52,14 @@ main(int argc, char *argv[])
 			lopt = 1;
 			break;
 
+		case 'r':
+			ropt = 1;
+			break;
+
+		case 't':
+			nthreads = atoi(optarg);	/* for -f */
+			break;
+
 		case 'v':
 			verbose = 1;
 			break;
@@ -57,6 +70,10 @@ main(int argc, char *argv[])
 	}
 /* end main2 */
 /* include main3 */
+	if (file != NULL) {
+		check_file(file, nthreads, verbose);
+		exit(0);
+	}
 	if (optind != argc-2)
 		usage("missing <host> and/or <serv>");
 
@@ -93,7 +110,11 @@ main(int argc, char *argv[])
 
 	open_output();		/* open output, either raw socket or libnet */
 
-	open_pcap();		/* open packet capture device */
+	if (ropt) {			/* capture through a TPACKET_V3 ring */
+		printf("device = %s (ring)\n", device ? device : "all");
+		ringfd = ring_open(device, (struct sockaddr_in *) dest, snaplen);
+	} else
+		open_pcap();	/* open packet capture device */
 
 	setuid(getuid());	/* don't need superuser privileges anymore */
 
@@ -112,10 +133,14 @@ usage(const char *msg)
 {
 	err_msg(
 "usage: udpcksum [ options ] <host> <serv>\n"
+"       udpcksum -f file [ -t #threads ] [ -v ]\n"
 "options: -0    send UDP datagram with checksum set to 0\n"
+"         -f s  check every UDP checksum in a pcap or pcapng file\n"
 "         -i s  packet capture device\n"
 "         -l a.b.c.d.p  local IP=a.b.c.d, local port=p\n"
-"         -v    verbose output"
+"         -r    capture through a TPACKET_V3 ring, not libpcap\n"
+"         -t n  threads for -f (default one per CPU)\n"
+"         -v    verbose output (with -f, list every flow)"
 );
 
 	if (msg[0] != 0)
@@ -0,0 +1,572 @@
+/*
+ * udpcksum -f: verify the IP and UDP checksums of every IPv4 UDP packet
+ * in a pcap or pcapng file, without libpcap.
+ *
+ * The file is mmap'd and one pass over the record headers builds an
+ * index of where each packet starts; the packets themselves are only
+ * touched afterwards, by "nthreads" threads that each take a contiguous
+ * slice of the index.  The checks are those of udp_check(), but a bad
+ * packet is counted against its flow instead of ending the program.
+ * Each thread keeps its own counters and flow table, merged at the end,
+ * so nothing is shared while the packets are being summed.
+ *
+ * This file only needs "unpthread.h" (not <pcap.h> or the BSD headers in
+ * udpcksum.h), and parses the two file formats itself.
+ */
+
+#include	"unpthread.h"
+#include	<sys/mman.h>
+#include	<stdint.h>
+
+					/* link types, from the pcap and pcapng formats */
+#define	LINK_NULL		0		/* 4-byte family, writer's byte order */
+#define	LINK_EN10MB		1
+#define	LINK_RAW		101		/* starts at the IP header */
+#define	LINK_LOOP		108		/* 4-byte family, network byte order */
+#define	LINK_SLL		113		/* Linux "any" device */
+#define	LINK_SLL2		276
+#define	LINK_IPV4		228
+
+struct rec {					/* one per packet in the file */
+  uint64_t	r_off;				/* offset of the packet data */
+  uint32_t	r_caplen;			/* bytes captured */
+  uint32_t	r_link;				/* link type */
+};
+
+struct counts {
+  uint64_t	c_pkts;				/* IPv4 UDP packets */
+  uint64_t	c_other;			/* not IPv4 UDP, or no room for the headers */
+  uint64_t	c_iperr;			/* IP header checksum wrong */
+  uint64_t	c_udperr;			/* UDP checksum wrong */
+  uint64_t	c_nosum;			/* UDP checksum 0: not computed by sender */
+  uint64_t	c_short;			/* truncated by the capture: not checked */
+  uint64_t	c_frag;				/* fragment: not checked */
+  uint64_t	c_bytes;			/* bytes summed */
+};
+
+struct flow {
+  uint32_t	f_src, f_dst;		/* network byte order */
+  uint16_t	f_sport, f_dport;
+  int		f_used;
+  struct counts	f_cnt;
+};
+
+struct slice {					/* one per thread */
+  pthread_t		 s_tid;
+  const char	*s_map;
+  struct rec	*s_rec;
+  long			 s_nrec;
+  int			 s_swapnull;	/* LINK_NULL family is byte swapped */
+  struct counts	 s_cnt;
+  struct flow	*s_flow;		/* open addressing hash table */
+  unsigned long	 s_nflow, s_size;	/* s_size is a power of 2 */
+};
+
+static struct rec	*recs;
+static long			 nrec, maxrec;
+
+/*
+ * Ones complement sum of "len" bytes added to "sum", 4 bytes at a time
+ * into a 64-bit accumulator so no carries are lost until the final fold.
+ * in_cksum() adds 2 bytes at a time, which is the slow part of a large
+ * capture.
+ */
+static uint64_t
+sum_add(uint64_t sum, const unsigned char *p, int len)
+{
+	uint32_t	w;
+	uint16_t	h;
+
+	for ( ; len >= 4; p += 4, len -= 4) {
+		memcpy(&w, p, 4);		/* packets need not be aligned */
+		sum += w;
+	}
+	if (len >= 2) {
+		memcpy(&h, p, 2);
+		sum += h;
+		p += 2;
+		len -= 2;
+	}
+	if (len == 1) {				/* pad with a zero byte */
+		h = 0;
+		memcpy(&h, p, 1);
+		sum += h;
+	}
+	return(sum);
+}
+
+static uint16_t
+sum_fold(uint64_t sum)
+{
+	sum = (sum & 0xffffffff) + (sum >> 32);
+	sum = (sum & 0xffffffff) + (sum >> 32);
+	sum = (sum & 0xffff) + (sum >> 16);
+	sum = (sum & 0xffff) + (sum >> 16);
+	return(sum);
+}
+
+static void
+add_rec(uint64_t off, uint32_t caplen, uint32_t link)
+{
+	if (nrec == maxrec) {
+		maxrec = (maxrec == 0) ? 65536 : 2 * maxrec;
+		if ( (recs = realloc(recs, maxrec * sizeof(struct rec))) == NULL)
+			err_sys("realloc error");
+	}
+	recs[nrec].r_off = off;
+	recs[nrec].r_caplen = caplen;
+	recs[nrec].r_link = link;
+	nrec++;
+}
+
+#define	GET32(p, swap)	get32((const unsigned char *) (p), swap)
+#define	GET16(p, swap)	get16((const unsigned char *) (p), swap)
+
+static uint32_t
+get32(const unsigned char *p, int swap)
+{
+	uint32_t	v;
+
+	memcpy(&v, p, 4);
+	return(swap ? ((v >> 24) | ((v >> 8) & 0xff00) |
+				   ((v << 8) & 0xff0000) | (v << 24)) : v);
+}
+
+static uint16_t
+get16(const unsigned char *p, int swap)
+{
+	uint16_t	v;
+
+	memcpy(&v, p, 2);
+	return(swap ? (v >> 8) | (v << 8) : v);
+}
+
+/*
+ * Index a classic pcap file.  Return nonzero if the writer's byte order
+ * was the opposite of ours.
+ */
+static int
+index_pcap(const char *map, size_t size, int swap)
+{
+	size_t		off;
+	uint32_t	link, caplen;
+
+	if (size < 24)
+		err_quit("pcap file header truncated");
+	link = GET32(map + 20, swap) & 0xffff;		/* upper bits are FCS info */
+
+	for (off = 24; off + 16 <= size; off += 16 + caplen) {
+		caplen = GET32(map + off + 8, swap);
+		if (caplen > size - off - 16) {
+			err_msg("record at offset %lu truncated; stopping there",
+					(unsigned long) off);
+			break;
+		}
+		add_rec(off + 16, caplen, link);
+	}
+	return(swap);
+}
+
+/*
+ * Index a pcapng file: a sequence of sections, each a Section Header
+ * Block followed by Interface Description Blocks (which give the link
+ * type of each interface) and packet blocks.  Return nonzero if the last
+ * section was written in the opposite byte order to ours.
+ */
+static int
+index_pcapng(const char *map, size_t size)
+{
+	size_t		off;
+	uint32_t	type, blen, caplen, origlen, ifid, links[256];
+	int			swap, nif;
+
+	swap = nif = 0;
+	for (off = 0; off + 12 <= size; off += blen) {
+		type = GET32(map + off, 0);
+		if (type == 0x0a0d0d0a) {				/* palindrome: any order */
+			swap = (GET32(map + off + 8, 0) != 0x1a2b3c4d);
+			nif = 0;							/* new section */
+		} else
+			type = GET32(map + off, swap);
+		blen = GET32(map + off + 4, swap);
+		if (blen < 12 || blen > size - off) {
+			err_msg("block at offset %lu truncated; stopping there",
+					(unsigned long) off);
+			break;
+		}
+
+		switch (type) {
+		case 1:									/* Interface Description */
+			if (nif < 256 && blen >= 20)
+				links[nif++] = GET16(map + off + 8, swap);
+			break;
+
+		case 6:									/* Enhanced Packet */
+			if (blen < 32)
+				break;
+			ifid = GET32(map + off + 8, swap);
+			caplen = GET32(map + off + 20, swap);
+			if (ifid >= nif || caplen > blen - 32)
+				err_quit("bad enhanced packet block at offset %lu",
+						 (unsigned long) off);
+			add_rec(off + 28, caplen, links[ifid]);
+			break;
+
+		case 3:									/* Simple Packet */
+			if (nif == 0 || blen < 16)
+				break;
+			origlen = GET32(map + off + 8, swap);
+			caplen = min(origlen, blen - 16);
+			add_rec(off + 12, caplen, links[0]);
+			break;
+		}
+	}
+	return(swap);
+}
+
+static unsigned long
+flow_hash(uint32_t src, uint32_t dst, uint16_t sport, uint16_t dport)
+{
+	uint64_t	h;
+
+	h = ((uint64_t) src << 32 | dst) ^ ((uint64_t) sport << 16 | dport);
+	h *= 0x9e3779b97f4a7c15ULL;
+	return(h >> 32);
+}
+
+/*
+ * Return the counters for the packet's flow in this thread's table,
+ * adding the flow if it is new.
+ */
+static struct counts *
+flow_counts(struct slice *s, uint32_t src, uint32_t dst,
+			uint16_t sport, uint16_t dport)
+{
+	unsigned long	h, i;
+	struct flow		*f, *old;
+
+	if (2 * (s->s_nflow + 1) > s->s_size) {		/* keep it half empty */
+		old = s->s_flow;
+		s->s_size = (s->s_size == 0) ? 1024 : 2 * s->s_size;
+		s->s_flow = Calloc(s->s_size, sizeof(struct flow));
+		s->s_nflow = 0;
+		for (i = 0; old != NULL && i < s->s_size / 2; i++) {
+			if (old[i].f_used) {
+				h = flow_hash(old[i].f_src, old[i].f_dst,
+							  old[i].f_sport, old[i].f_dport);
+				for (h &= s->s_size - 1; s->s_flow[h].f_used;
+					 h = (h + 1) & (s->s_size - 1))
+					;
+				s->s_flow[h] = old[i];
+				s->s_nflow++;
+			}
+		}
+		free(old);
+	}
+
+	h = flow_hash(src, dst, sport, dport);
+	for (h &= s->s_size - 1; ; h = (h + 1) & (s->s_size - 1)) {
+		f = &s->s_flow[h];
+		if (!f->f_used) {
+			f->f_used = 1;
+			f->f_src = src;
+			f->f_dst = dst;
+			f->f_sport = sport;
+			f->f_dport = dport;
+			s->s_nflow++;
+			return(&f->f_cnt);
+		}
+		if (f->f_src == src && f->f_dst == dst &&
+			f->f_sport == sport && f->f_dport == dport)
+			return(&f->f_cnt);
+	}
+}
+
+/*
+ * Return the IPv4 header in a captured packet, or NULL if there isn't
+ * one, and subtract the link header from *len.
+ */
+static const unsigned char *
+strip_link(const unsigned char *p, int *len, uint32_t link, int swapnull)
+{
+	int		hlen;
+	uint32_t	family;
+	uint16_t	type;
+
+	switch (link) {
+	case LINK_NULL:
+	case LINK_LOOP:
+		if (*len < 4)
+			return(NULL);
+		family = GET32(p, link == LINK_NULL ? swapnull : 0);
+		if (link == LINK_LOOP)
+			family = ntohl(family);
+		if (family != 2)				/* AF_INET on every system */
+			return(NULL);
+		hlen = 4;
+		break;
+
+	case LINK_EN10MB:
+		if (*len < 14)
+			return(NULL);
+		hlen = 14;
+		type = (p[12] << 8) | p[13];
+		if (type == 0x8100 && *len >= 18) {	/* one VLAN tag */
+			hlen = 18;
+			type = (p[16] << 8) | p[17];
+		}
+		if (type != 0x0800)
+			return(NULL);
+		break;
+
+	case LINK_SLL:
+		if (*len < 16 || ((p[14] << 8) | p[15]) != 0x0800)
+			return(NULL);
+		hlen = 16;
+		break;
+
+	case LINK_SLL2:
+		if (*len < 20 || ((p[0] << 8) | p[1]) != 0x0800)
+			return(NULL);
+		hlen = 20;
+		break;
+
+	case LINK_RAW:
+	case LINK_IPV4:
+		hlen = 0;
+		break;
+
+	default:
+		return(NULL);
+	}
+	*len -= hlen;
+	return(p + hlen);
+}
+
+/* include check_packet */
+static void
+check_packet(struct slice *s, const struct rec *r)
+{
+	int					len, hlen, iplen, udplen;
+	uint64_t			sum;
+	uint32_t			src, dst;
+	uint16_t			sport, dport;
+	const unsigned char	*p, *udp;
+	struct counts		*fc;
+
+	len = r->r_caplen;
+	p = strip_link((const unsigned char *) s->s_map + r->r_off, &len,
+				   r->r_link, s->s_swapnull);
+	if (p == NULL || len < 20 || (p[0] >> 4) != 4 ||
+		(hlen = (p[0] & 0x0f) << 2) < 20 || len < hlen + 8 ||
+		p[9] != IPPROTO_UDP) {
+		s->s_cnt.c_other++;
+		return;
+	}
+	udp = p + hlen;
+	memcpy(&src, p + 12, 4);
+	memcpy(&dst, p + 16, 4);
+	memcpy(&sport, udp, 2);
+	memcpy(&dport, udp + 2, 2);
+	fc = flow_counts(s, src, dst, sport, dport);
+	fc->c_pkts++;
+	s->s_cnt.c_pkts++;
+
+	if (sum_fold(sum_add(0, p, hlen)) != 0xffff) {
+		fc->c_iperr++;
+		s->s_cnt.c_iperr++;
+		return;				/* don't trust the lengths */
+	}
+	if ((p[6] & 0x3f) != 0 || p[7] != 0) {		/* MF or offset */
+		fc->c_frag++;
+		s->s_cnt.c_frag++;
+		return;
+	}
+	if (udp[6] == 0 && udp[7] == 0) {
+		fc->c_nosum++;
+		s->s_cnt.c_nosum++;
+		return;
+	}
+	iplen = (p[2] << 8) | p[3];
+	udplen = (udp[4] << 8) | udp[5];
+	if (udplen < 8 || hlen + udplen > iplen) {
+		fc->c_udperr++;		/* the sender got this wrong, too */
+		s->s_cnt.c_udperr++;
+		return;
+	}
+	if (hlen + udplen > len) {
+		fc->c_short++;
+		s->s_cnt.c_short++;
+		return;
+	}
+
+		/* pseudoheader: addresses, protocol, UDP length */
+	sum = sum_add(0, p + 12, 8);
+	sum += htons(IPPROTO_UDP) + htons(udplen);
+	sum = sum_add(sum, udp, udplen);
+	s->s_cnt.c_bytes += udplen;
+	if (sum_fold(sum) != 0xffff) {
+		fc->c_udperr++;
+		s->s_cnt.c_udperr++;
+	}
+}
+/* end check_packet */
+
+static void *
+check_slice(void *arg)
+{
+	long			i;
+	struct slice	*s = arg;
+
+	for (i = 0; i < s->s_nrec; i++)
+		check_packet(s, &s->s_rec[i]);
+	return(NULL);
+}
+
+static void
+add_counts(struct counts *to, const struct counts *from)
+{
+	to->c_pkts += from->c_pkts;
+	to->c_other += from->c_other;
+	to->c_iperr += from->c_iperr;
+	to->c_udperr += from->c_udperr;
+	to->c_nosum += from->c_nosum;
+	to->c_short += from->c_short;
+	to->c_frag += from->c_frag;
+	to->c_bytes += from->c_bytes;
+}
+
+static int
+cmp_flow(const void *a, const void *b)
+{
+	const struct flow	*fa = a, *fb = b;
+	uint64_t			ea, eb;
+
+	ea = fa->f_cnt.c_iperr + fa->f_cnt.c_udperr;
+	eb = fb->f_cnt.c_iperr + fb->f_cnt.c_udperr;
+	if (ea != eb)
+		return(ea < eb ? 1 : -1);
+	return(fa->f_cnt.c_pkts < fb->f_cnt.c_pkts ? 1 :
+		   fa->f_cnt.c_pkts > fb->f_cnt.c_pkts ? -1 : 0);
+}
+
+static double
+seconds(struct timeval *start)
+{
+	struct timeval	now;
+
+	Gettimeofday(&now, NULL);
+	tv_sub(&now, start);
+	return(now.tv_sec + now.tv_usec / 1e6);
+}
+
+/* include check_file */
+void
+check_file(const char *path, int nthreads, int verbose)
+{
+	int				fd, i, swap, nbad;
+	long			per;
+	unsigned long	j;
+	uint32_t		magic;
+	char			*map, src[INET_ADDRSTRLEN], dst[INET_ADDRSTRLEN];
+	double			tindex, tcheck;
+	struct stat		st;
+	struct timeval	start;
+	struct slice	*s, all;
+	struct counts	*c;
+	struct flow		*f;
+
+	fd = Open(path, O_RDONLY, 0);
+	if (fstat(fd, &st) < 0)
+		err_sys("fstat error for %s", path);
+	if (st.st_size < 4)
+		err_quit("%s: too short for a capture file", path);
+	map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (map == MAP_FAILED)
+		err_sys("mmap error for %s", path);
+	Close(fd);
+	madvise(map, st.st_size, MADV_WILLNEED);
+
+	Gettimeofday(&start, NULL);
+	memcpy(&magic, map, 4);
+	swap = 0;
+	if (magic == 0xa1b2c3d4 || magic == 0xa1b23c4d)		/* usec, nsec */
+		swap = index_pcap(map, st.st_size, 0);
+	else if (magic == 0xd4c3b2a1 || magic == 0x4d3cb2a1)
+		swap = index_pcap(map, st.st_size, 1);
+	else if (magic == 0x0a0d0d0a)
+		swap = index_pcapng(map, st.st_size);
+	else
+		err_quit("%s: not a pcap or pcapng file", path);
+	tindex = seconds(&start);
+
+	if (nthreads <= 0)
+		nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+	if (nthreads > nrec)
+		nthreads = (nrec > 0) ? nrec : 1;
+	s = Calloc(nthreads, sizeof(struct slice));
+	per = (nrec + nthreads - 1) / nthreads;
+
+	Gettimeofday(&start, NULL);
+	for (i = 0; i < nthreads; i++) {
+		s[i].s_map = map;
+		s[i].s_rec = recs + i * per;
+		s[i].s_nrec = min(per, nrec - i * per);
+		s[i].s_swapnull = swap;
+		Pthread_create(&s[i].s_tid, NULL, check_slice, &s[i]);
+	}
+	for (i = 0; i < nthreads; i++)
+		Pthread_join(s[i].s_tid, NULL);
+	tcheck = seconds(&start);
+
+		/* merge every thread's flows into the first one's table */
+	bzero(&all, sizeof(all));
+	for (i = 0; i < nthreads; i++) {
+		add_counts(&all.s_cnt, &s[i].s_cnt);
+		for (j = 0; j < s[i].s_size; j++) {
+			f = &s[i].s_flow[j];
+			if (f->f_used)
+				add_counts(flow_counts(&all, f->f_src, f->f_dst,
+									   f->f_sport, f->f_dport), &f->f_cnt);
+		}
+		free(s[i].s_flow);
+	}
+
+	c = &all.s_cnt;
+	printf("%s: %ld records, %.1f MB, indexed in %.3f sec\n",
+		   path, nrec, st.st_size / 1e6, tindex);
+	printf("checked in %.3f sec with %d threads = %.2f GB/s\n",
+		   tcheck, nthreads, st.st_size / tcheck / 1e9);
+	printf("%llu IPv4 UDP packets in %lu flows, %llu other records\n",
+		   (unsigned long long) c->c_pkts, all.s_nflow,
+		   (unsigned long long) c->c_other);
+	printf("%llu bad IP checksums, %llu bad UDP checksums, "
+		   "%llu without UDP checksum\n",
+		   (unsigned long long) c->c_iperr, (unsigned long long) c->c_udperr,
+		   (unsigned long long) c->c_nosum);
+	printf("not checked: %llu truncated, %llu fragments\n",
+		   (unsigned long long) c->c_short, (unsigned long long) c->c_frag);
+
+		/* flows with errors first; every flow with -v */
+	qsort(all.s_flow, all.s_size, sizeof(struct flow), cmp_flow);
+	for (j = 0, nbad = 0; j < all.s_nflow; j++) {
+		f = &all.s_flow[j];
+		if (f->f_cnt.c_iperr + f->f_cnt.c_udperr == 0 && !verbose)
+			break;
+		if (nbad++ == 0)
+			printf("\n%21s %21s %10s %8s %8s %8s\n", "source", "destination",
+				   "packets", "IP err", "UDP err", "no sum");
+		Inet_ntop(AF_INET, &f->f_src, src, sizeof(src));
+		Inet_ntop(AF_INET, &f->f_dst, dst, sizeof(dst));
+		printf("%15s.%-5d %15s.%-5d %10llu %8llu %8llu %8llu\n",
+			   src, ntohs(f->f_sport), dst, ntohs(f->f_dport),
+			   (unsigned long long) f->f_cnt.c_pkts,
+			   (unsigned long long) f->f_cnt.c_iperr,
+			   (unsigned long long) f->f_cnt.c_udperr,
+			   (unsigned long long) f->f_cnt.c_nosum);
+	}
+	free(all.s_flow);
+	free(s);
+	munmap(map, st.st_size);
+}
+/* end check_file */
@@ -0,0 +1,223 @@
+/*
+ * Capture with an AF_PACKET TPACKET_V3 ring instead of libpcap.
+ *
+ * The kernel writes packets straight into a ring of blocks that we have
+ * mmap'd and hands over a whole block at a time, so there is no copy
+ * and no system call per packet: ring_next() just steps through the
+ * current block and only calls poll() when it reaches a block the
+ * kernel still owns.  A block is handed over when it is full or
+ * RING_TIMEO ms after its first packet, whichever comes first.
+ *
+ * The socket is SOCK_DGRAM ("cooked"), so the kernel removes the
+ * datalink header and every packet starts at its IP header, whatever
+ * the interface; there is no per-packet switch on the datalink type
+ * as in udp_read().  The filter is classic BPF, assembled here for the
+ * same expression open_pcap() compiles:
+ * "udp and src host A and src port P".
+ */
+
+#include	"unp.h"
+#include	"ring.h"
+
+#ifdef	__linux__
+#include	<net/if.h>
+#include	<sys/mman.h>
+#include	<net/ethernet.h>		/* ETHERTYPE_IP */
+#include	<linux/if_packet.h>		/* TPACKET_V3, as well as sockaddr_ll */
+#include	<linux/filter.h>
+
+#define	RING_BLOCKSIZE	(1 << 18)	/* 256 KB */
+#define	RING_NBLOCKS	64
+#define	RING_FRAMESIZE	2048		/* only sets the size limit in V3 */
+#define	RING_TIMEO		60			/* ms, to hand over a partial block */
+
+static struct {
+  int							r_fd;
+  char						   *r_map;
+  unsigned int					r_block;	/* index of the next block */
+  struct tpacket_block_desc	   *r_bd;		/* block we own, or NULL */
+  struct tpacket3_hdr		   *r_pkt;		/* next packet in r_bd */
+  unsigned int					r_left;		/* # packets left in r_bd */
+} ring = { -1 };
+
+/*
+ * Build the filter into f[] (room for RING_NFILTER instructions) and
+ * return its length.  It accepts IPv4 (the socket only sees ETHERTYPE_IP)
+ * UDP, first fragments only, and if "src" is not NULL, only from its
+ * address and port.  Accepted packets are cut to "snaplen" bytes.
+ * Offsets are from the IP header since the socket is cooked.
+ */
+int
+ring_filter(struct sock_filter *f, const struct sockaddr_in *src, int snaplen)
+{
+	int		n, drop;
+
+	n = 0;
+	drop = (src != NULL) ? 10 : 5;	/* index of the final "ret #0" */
+
+#define	STMT(c, val)		(f[n].code = (c), f[n].jt = f[n].jf = 0, \
+							 f[n].k = (val), n++)
+#define	JUMP(c, val, t, e)	(f[n].code = (c), f[n].jt = (t) - n - 1, \
+							 f[n].jf = (e) - n - 1, f[n].k = (val), n++)
+
+	STMT(BPF_LD + BPF_B + BPF_ABS, 9);					/* protocol */
+	JUMP(BPF_JMP + BPF_JEQ + BPF_K, IPPROTO_UDP, n + 1, drop);
+	STMT(BPF_LD + BPF_H + BPF_ABS, 6);					/* flags, offset */
+	JUMP(BPF_JMP + BPF_JSET + BPF_K, 0x1fff, drop, n + 1);
+	if (src != NULL) {
+		STMT(BPF_LD + BPF_W + BPF_ABS, 12);				/* source address */
+		JUMP(BPF_JMP + BPF_JEQ + BPF_K, ntohl(src->sin_addr.s_addr),
+			 n + 1, drop);
+		STMT(BPF_LDX + BPF_B + BPF_MSH, 0);				/* X = IP hdr len */
+		STMT(BPF_LD + BPF_H + BPF_IND, 0);				/* source port */
+		JUMP(BPF_JMP + BPF_JEQ + BPF_K, ntohs(src->sin_port), n + 1, drop);
+	}
+	STMT(BPF_RET + BPF_K, snaplen);
+	STMT(BPF_RET + BPF_K, 0);							/* drop */
+	return(n);
+
+#undef	STMT
+#undef	JUMP
+}
+
+/*
+ * Open the ring on "device", or on every interface if NULL, and return
+ * the socket.
+ */
+int
+ring_open(const char *device, const struct sockaddr_in *src, int snaplen)
+{
+	int					fd, version;
+	struct tpacket_req3	req;
+	struct sockaddr_ll	sll;
+	struct sock_filter	code[RING_NFILTER];
+	struct sock_fprog	prog;
+
+	fd = Socket(AF_PACKET, SOCK_DGRAM, htons(ETHERTYPE_IP));
+
+		/* filter before the ring fills with other traffic */
+	prog.len = ring_filter(code, src, snaplen);
+	prog.filter = code;
+	Setsockopt(fd, SOL_SOCKET, SO_ATTACH_FILTER, &prog, sizeof(prog));
+
+	version = TPACKET_V3;
+	Setsockopt(fd, SOL_PACKET, PACKET_VERSION, &version, sizeof(version));
+
+	bzero(&req, sizeof(req));
+	req.tp_block_size = RING_BLOCKSIZE;
+	req.tp_block_nr = RING_NBLOCKS;
+	req.tp_frame_size = RING_FRAMESIZE;
+	req.tp_frame_nr = RING_BLOCKSIZE / RING_FRAMESIZE * RING_NBLOCKS;
+	req.tp_retire_blk_tov = RING_TIMEO;
+	Setsockopt(fd, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req));
+
+	ring.r_map = mmap(NULL, (size_t) RING_BLOCKSIZE * RING_NBLOCKS,
+					  PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (ring.r_map == MAP_FAILED)
+		err_sys("mmap error for packet ring");
+
+	bzero(&sll, sizeof(sll));
+	sll.sll_family = AF_PACKET;
+	sll.sll_protocol = htons(ETHERTYPE_IP);
+	if (device != NULL && (sll.sll_ifindex = if_nametoindex(device)) == 0)
+		err_quit("unknown interface %s", device);
+	Bind(fd, (SA *) &sll, sizeof(sll));
+
+	ring.r_fd = fd;
+	ring.r_block = 0;
+	ring.r_bd = NULL;
+	return(fd);
+}
+
+/*
+ * Return the next packet, starting at its IP header, and its captured
+ * length.  Like pcap_next(), the packet is only valid until the next
+ * call.
+ */
+char *
+ring_next(int *len)
+{
+	struct tpacket3_hdr			*hdr;
+	struct tpacket_block_desc	*bd;
+	struct pollfd				pfd;
+
+	for ( ; ; ) {
+		if (ring.r_left > 0) {
+			hdr = ring.r_pkt;
+			ring.r_pkt = (struct tpacket3_hdr *)
+							((char *) hdr + hdr->tp_next_offset);
+			ring.r_left--;
+			*len = hdr->tp_snaplen;
+			return((char *) hdr + hdr->tp_net);
+		}
+
+		if (ring.r_bd != NULL) {
+				/* done with every packet in the block; give it back */
+			__sync_synchronize();
+			ring.r_bd->hdr.bh1.block_status = TP_STATUS_KERNEL;
+			ring.r_bd = NULL;
+			ring.r_block = (ring.r_block + 1) % RING_NBLOCKS;
+		}
+
+		bd = (struct tpacket_block_desc *)
+				(ring.r_map + (size_t) ring.r_block * RING_BLOCKSIZE);
+		if ((bd->hdr.bh1.block_status & TP_STATUS_USER) == 0) {
+			pfd.fd = ring.r_fd;
+			pfd.events = POLLIN | POLLERR;
+			if (poll(&pfd, 1, INFTIM) < 0 && errno != EINTR)
+				err_sys("poll error");
+			continue;
+		}
+		__sync_synchronize();	/* read the packets after the status */
+
+		ring.r_bd = bd;
+		ring.r_pkt = (struct tpacket3_hdr *)
+						((char *) bd + bd->hdr.bh1.offset_to_first_pkt);
+		ring.r_left = bd->hdr.bh1.num_pkts;
+	}
+}
+
+/*
+ * Packets accepted by the filter and dropped for lack of room in the
+ * ring, since the last call.
+ */
+void
+ring_stats(unsigned int *nrecv, unsigned int *ndrop)
+{
+	socklen_t					len;
+	struct tpacket_stats_v3		st;
+
+	len = sizeof(st);
+	if (getsockopt(ring.r_fd, SOL_PACKET, PACKET_STATISTICS, &st, &len) < 0)
+		err_sys("getsockopt PACKET_STATISTICS error");
+	*nrecv = st.tp_packets;
+	*ndrop = st.tp_drops;
+}
+
+#else	/* not Linux */
+
+int
+ring_filter(struct sock_filter *f, const struct sockaddr_in *src, int snaplen)
+{
+	return(0);
+}
+
+int
+ring_open(const char *device, const struct sockaddr_in *src, int snaplen)
+{
+	err_quit("packet ring capture needs Linux AF_PACKET");
+	return(-1);
+}
+
+char *
+ring_next(int *len)
+{
+	return(NULL);
+}
+
+void
+ring_stats(unsigned int *nrecv, unsigned int *ndrop)
+{
+	*nrecv = *ndrop = 0;
+}
+#endif
@@ -0,0 +1,12 @@
+/*
+ * Packet capture through an AF_PACKET TPACKET_V3 ring (Linux), instead
+ * of libpcap.  See ring.c.
+ */
+
+#define	RING_NFILTER	16		/* max # instructions from ring_filter() */
+
+struct sock_filter;
+int		 ring_filter(struct sock_filter *, const struct sockaddr_in *, int);
+int		 ring_open(const char *, const struct sockaddr_in *, int);
+char	*ring_next(int *);
+void	 ring_stats(unsigned int *, unsigned int *);
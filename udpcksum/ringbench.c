@@ -0,0 +1,120 @@
+/*
+ * Packets per second captured on the loopback interface, one packet per
+ * recvfrom() on a packet socket (as libpcap reads without a ring) versus
+ * walking the TPACKET_V3 ring with ring_next().  A child process sends
+ * small UDP datagrams to a socket that the parent binds but never reads;
+ * both capture methods use the same BPF filter for the child's address
+ * and port, and touch the IP header of every packet.
+ */
+
+#include	"unp.h"
+#include	"ring.h"
+
+#ifdef	__linux__
+#include	<netinet/in_systm.h>
+#include	<netinet/ip.h>
+#include	<net/ethernet.h>
+#include	<linux/filter.h>
+#endif
+
+#define	SRCPORT		9878		/* the child sends from here ... */
+#define	DSTPORT		9879		/* ... to here */
+
+static void
+sender(void)
+{
+	int					sockfd;
+	char				buf[32];
+	struct sockaddr_in	sin;
+
+	sockfd = Socket(AF_INET, SOCK_DGRAM, 0);
+	bzero(&sin, sizeof(sin));
+	sin.sin_family = AF_INET;
+	sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	sin.sin_port = htons(SRCPORT);
+	Bind(sockfd, (SA *) &sin, sizeof(sin));
+
+	sin.sin_port = htons(DSTPORT);
+	memset(buf, 0, sizeof(buf));
+	for ( ; ; )
+		sendto(sockfd, buf, sizeof(buf), 0, (SA *) &sin, sizeof(sin));
+}
+
+static double
+elapsed(struct timeval *start)
+{
+	struct timeval	now;
+
+	Gettimeofday(&now, NULL);
+	tv_sub(&now, start);
+	return(now.tv_sec + now.tv_usec / 1e6);
+}
+
+int
+main(int argc, char **argv)
+{
+#ifdef	__linux__
+	int					nsec, sinkfd, pktfd, mode, n;
+	long				npkts, sum;
+	pid_t				pid;
+	char				buf[256], *ptr;
+	unsigned int		nrecv, ndrop;
+	struct timeval		start;
+	struct sockaddr_in	src;
+	struct sock_filter	code[RING_NFILTER];
+	struct sock_fprog	prog;
+
+	if (argc > 2)
+		err_quit("usage: ringbench [ #seconds ]");
+	nsec = (argc == 2) ? atoi(argv[1]) : 5;
+
+	bzero(&src, sizeof(src));
+	src.sin_family = AF_INET;
+	src.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	src.sin_port = htons(DSTPORT);
+	sinkfd = Socket(AF_INET, SOCK_DGRAM, 0);	/* no ICMP port unreachables */
+	Bind(sinkfd, (SA *) &src, sizeof(src));
+	src.sin_port = htons(SRCPORT);				/* what we capture */
+
+	for (mode = 0; mode < 2; mode++) {
+		if (mode == 0) {
+			pktfd = Socket(AF_PACKET, SOCK_DGRAM, htons(ETHERTYPE_IP));
+			prog.len = ring_filter(code, &src, 200);
+			prog.filter = code;
+			Setsockopt(pktfd, SOL_SOCKET, SO_ATTACH_FILTER, &prog, sizeof(prog));
+		} else
+			pktfd = ring_open("lo", &src, 200);
+
+		if ( (pid = Fork()) == 0)
+			sender();			/* never returns */
+
+		npkts = sum = 0;
+		Gettimeofday(&start, NULL);
+		while (elapsed(&start) < nsec) {
+			if (mode == 0) {
+				if ( (n = recvfrom(pktfd, buf, sizeof(buf), 0, NULL, NULL)) < 0)
+					err_sys("recvfrom error");
+				ptr = buf;
+			} else
+				ptr = ring_next(&n);
+			sum += ((struct ip *) ptr)->ip_len;		/* touch the packet */
+			npkts++;
+		}
+		kill(pid, SIGTERM);
+		Waitpid(pid, NULL, 0);
+
+		printf("%-9s %10ld packets in %d sec = %8.0f/s",
+			   mode == 0 ? "recvfrom:" : "ring:", npkts, nsec,
+			   (double) npkts / nsec);
+		if (mode == 1) {
+			ring_stats(&nrecv, &ndrop);
+			printf(", %u dropped by kernel", ndrop);
+		}
+		printf("\n");
+		Close(pktfd);
+	}
+	exit(sum == -1);	/* so the compiler keeps the loads */
+#else
+	err_quit("ringbench needs Linux AF_PACKET");
+#endif
+}
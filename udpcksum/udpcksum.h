@@ -9,6 +9,7 @@
 #include	<netinet/udp_var.h>
 #include	<net/if.h>
 #include	<netinet/if_ether.h>
+#include	"ring.h"
 
 #define	TTL_OUT		64				/* outgoing TTL */
 
@@ -19,11 +20,13 @@ extern int		datalink;
 extern char    *device;
 extern pcap_t  *pd;
 extern int		rawfd;
+extern int		ringfd;
 extern int		snaplen;
 extern int		verbose;
 extern int		zerosum;
 
 					/* function prototypes */
+void			 check_file(const char *, int, int);
 void			 cleanup(int);
 char			*next_pcap(int *);
 void			 open_output(void);
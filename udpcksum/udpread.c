@@ -15,6 +15,11 @@ udp_read(void)
 	char				*ptr;
 	struct ether_header	*eptr;
 
+	if (ringfd >= 0) {		/* ring packets start at the IP header */
+		ptr = ring_next(&len);
+		return(udp_check(ptr, len));
+	}
+
 	for ( ; ; ) {
 		ptr = next_pcap(&len);
 